@@ -22,6 +22,8 @@ SOURCES += \
     $$PWD/../../src/igs_performance.c \
     $$PWD/../../src/igs_replay.c \
     $$PWD/../../src/igs_service.c \
+    $$PWD/../../src/igs_shm.c \
+    $$PWD/../../src/igs_loop.c \
     $$PWD/../../src/igs_split.c \
     $$PWD/../../src/igsagent.c \
     $$PWD/../../src/yajl_alloc.c \
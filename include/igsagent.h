@@ -156,6 +156,14 @@ INGESCAPE_EXPORT double igsagent_parameter_double (igsagent_t *self, const char
 INGESCAPE_EXPORT char * igsagent_parameter_string (igsagent_t *self, const char *name);//caller owns returned value
 INGESCAPE_EXPORT igs_result_t igsagent_parameter_data (igsagent_t *self, const char *name, void **data, size_t *size);
 
+//borrowed reads, see igs_value_release in ingescape.h
+INGESCAPE_EXPORT igs_result_t igsagent_input_data_borrow (igsagent_t *self, const char *name, const void **data, size_t *size, igs_value_t **token);
+INGESCAPE_EXPORT igs_result_t igsagent_input_string_borrow (igsagent_t *self, const char *name, const char **value, igs_value_t **token);
+INGESCAPE_EXPORT igs_result_t igsagent_output_data_borrow (igsagent_t *self, const char *name, const void **data, size_t *size, igs_value_t **token);
+INGESCAPE_EXPORT igs_result_t igsagent_output_string_borrow (igsagent_t *self, const char *name, const char **value, igs_value_t **token);
+INGESCAPE_EXPORT igs_result_t igsagent_parameter_data_borrow (igsagent_t *self, const char *name, const void **data, size_t *size, igs_value_t **token);
+INGESCAPE_EXPORT igs_result_t igsagent_parameter_string_borrow (igsagent_t *self, const char *name, const char **value, igs_value_t **token);
+
 INGESCAPE_EXPORT igs_result_t igsagent_input_set_bool (igsagent_t *self, const char *name, bool value);
 INGESCAPE_EXPORT igs_result_t igsagent_input_set_int (igsagent_t *self, const char *name, int value);
 INGESCAPE_EXPORT igs_result_t igsagent_input_set_double (igsagent_t *self, const char *name, double value);
@@ -169,6 +177,9 @@ INGESCAPE_EXPORT igs_result_t igsagent_output_set_double (igsagent_t *self, cons
 INGESCAPE_EXPORT igs_result_t igsagent_output_set_string (igsagent_t *self, const char *name, const char *value);
 INGESCAPE_EXPORT igs_result_t igsagent_output_set_impulsion (igsagent_t *self, const char *name);
 INGESCAPE_EXPORT igs_result_t igsagent_output_set_data (igsagent_t *self, const char *name, void *value, size_t size);
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_data_owned (igsagent_t *self, const char *name, void *value, size_t size, igs_data_free_fn *free_fn); //value is adopted, see igs_output_set_data_owned
+INGESCAPE_EXPORT igs_result_t igsagent_outputs_begin (igsagent_t *self); //outputs written until commit are published together
+INGESCAPE_EXPORT igs_result_t igsagent_outputs_commit (igsagent_t *self);
 
 INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_bool (igsagent_t *self, const char *name, bool value);
 INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_int (igsagent_t *self, const char *name, int value);
@@ -176,6 +187,11 @@ INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_double (igsagent_t *self, c
 INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_string (igsagent_t *self, const char *name, const char *value);
 INGESCAPE_EXPORT igs_result_t igsagent_parameter_set_data (igsagent_t *self, const char *name, void *value, size_t size);
 
+//handles, see igs_iop_handle_t in ingescape.h
+INGESCAPE_EXPORT igs_iop_handle_t * igsagent_input_handle (igsagent_t *self, const char *name); //returns NULL if input does not exist
+INGESCAPE_EXPORT igs_iop_handle_t * igsagent_output_handle (igsagent_t *self, const char *name); //returns NULL if output does not exist
+INGESCAPE_EXPORT igs_iop_handle_t * igsagent_parameter_handle (igsagent_t *self, const char *name); //returns NULL if parameter does not exist
+
 INGESCAPE_EXPORT void igsagent_constraints_enforce(igsagent_t *self, bool enforce); //default is false, i.e. disabled
 INGESCAPE_EXPORT igs_result_t igsagent_input_add_constraint(igsagent_t *self, const char *name, const char *constraint);
 INGESCAPE_EXPORT igs_result_t igsagent_output_add_constraint(igsagent_t *self, const char *name, const char *constraint);
@@ -213,6 +229,16 @@ INGESCAPE_EXPORT void igsagent_output_mute (igsagent_t *self, const char *name);
 INGESCAPE_EXPORT void igsagent_output_unmute (igsagent_t *self, const char *name);
 INGESCAPE_EXPORT bool igsagent_output_is_muted (igsagent_t *self, const char *name);
 
+//publish an output only when its value differs from the last published one
+INGESCAPE_EXPORT void igsagent_output_set_publish_on_change (igsagent_t *self, const char *name, bool on_change_only); //default is false
+INGESCAPE_EXPORT bool igsagent_output_publish_on_change (igsagent_t *self, const char *name);
+INGESCAPE_EXPORT size_t igsagent_output_suppressed_publications (igsagent_t *self, const char *name);
+INGESCAPE_EXPORT size_t igsagent_suppressed_publications (igsagent_t *self); //sum for all outputs
+
+//limit the publication rate of an output, latest value is published when the next slot opens
+INGESCAPE_EXPORT igs_result_t igsagent_output_set_max_rate (igsagent_t *self, const char *name, double max_rate); //in Hz, 0 for no limit (default)
+INGESCAPE_EXPORT double igsagent_output_max_rate (igsagent_t *self, const char *name);
+
 
 ////////////////////////////////
 // Mapping edition & inspection
@@ -302,6 +302,23 @@ INGESCAPE_EXPORT double igs_parameter_double(const char *name);
 INGESCAPE_EXPORT char * igs_parameter_string(const char *name); //caller owns returned value
 INGESCAPE_EXPORT igs_result_t igs_parameter_data(const char *name, void **data, size_t *size); //caller owns returned value
 
+/*Borrowed reads
+ Borrowing gives read access to the current value of a string or data
+ IOP without copying it. The value is immutable and stays valid, even if
+ the IOP is written again or removed, until the returned token is passed
+ to igs_value_release. Borrowing is the cheapest way to read large data
+ from inside observe callbacks. Values that are not stored as strings or
+ data, or that are very small, are returned as a private copy behind the
+ same kind of token. Data and strings may be NULL with a NULL token.*/
+typedef struct _igs_value_t igs_value_t;
+INGESCAPE_EXPORT igs_result_t igs_input_data_borrow(const char *name, const void **data, size_t *size, igs_value_t **token);
+INGESCAPE_EXPORT igs_result_t igs_input_string_borrow(const char *name, const char **value, igs_value_t **token);
+INGESCAPE_EXPORT igs_result_t igs_output_data_borrow(const char *name, const void **data, size_t *size, igs_value_t **token);
+INGESCAPE_EXPORT igs_result_t igs_output_string_borrow(const char *name, const char **value, igs_value_t **token);
+INGESCAPE_EXPORT igs_result_t igs_parameter_data_borrow(const char *name, const void **data, size_t *size, igs_value_t **token);
+INGESCAPE_EXPORT igs_result_t igs_parameter_string_borrow(const char *name, const char **value, igs_value_t **token);
+INGESCAPE_EXPORT void igs_value_release(igs_value_t **token); //token may be NULL, is set to NULL
+
 //write IOPs per value type
 INGESCAPE_EXPORT igs_result_t igs_input_set_bool(const char *name, bool value);
 INGESCAPE_EXPORT igs_result_t igs_input_set_int(const char *name, int value);
@@ -316,6 +333,19 @@ INGESCAPE_EXPORT igs_result_t igs_output_set_double(const char *name, double val
 INGESCAPE_EXPORT igs_result_t igs_output_set_string(const char *name, const char *value);
 INGESCAPE_EXPORT igs_result_t igs_output_set_impulsion(const char *name);
 INGESCAPE_EXPORT igs_result_t igs_output_set_data(const char *name, void *value, size_t size);
+/*Data outputs may adopt a buffer allocated by the caller instead of
+ copying it. The buffer then belongs to ingescape, even if the call
+ fails, and shall not be used anymore by the caller. It is released with
+ free_fn, or free if free_fn is NULL, when neither the output nor pending
+ publications or borrowers need it anymore.*/
+typedef void (igs_data_free_fn)(void *data);
+INGESCAPE_EXPORT igs_result_t igs_output_set_data_owned(const char *name, void *value, size_t size, igs_data_free_fn *free_fn);
+
+/*Outputs written between igs_outputs_begin and igs_outputs_commit are
+ published together, in a single message per transport, when committing.
+ Their values are updated in the model immediately.*/
+INGESCAPE_EXPORT igs_result_t igs_outputs_begin(void);
+INGESCAPE_EXPORT igs_result_t igs_outputs_commit(void);
 
 INGESCAPE_EXPORT igs_result_t igs_parameter_set_bool(const char *name, bool value);
 INGESCAPE_EXPORT igs_result_t igs_parameter_set_int(const char *name, int value);
@@ -323,6 +353,31 @@ INGESCAPE_EXPORT igs_result_t igs_parameter_set_double(const char *name, double
 INGESCAPE_EXPORT igs_result_t igs_parameter_set_string(const char *name, const char *value);
 INGESCAPE_EXPORT igs_result_t igs_parameter_set_data(const char *name, void *value, size_t size);
 
+/*IOP handles
+ A handle resolves an IOP by name once and then reads or writes it
+ without looking its name up again, which is useful for IOPs that are
+ read or written at high rates. Handles follow definition reloads and
+ IOP removals: they resolve again by name on their next use and fail
+ while the IOP does not exist. Handles may be used by several threads.
+ A handle keeps a pointer to its agent: it must be destroyed before its
+ agent, and using it once the agent is destroyed is undefined.*/
+typedef struct _igs_iop_handle_t igs_iop_handle_t;
+INGESCAPE_EXPORT igs_iop_handle_t * igs_input_handle(const char *name); //returns NULL if input does not exist
+INGESCAPE_EXPORT igs_iop_handle_t * igs_output_handle(const char *name); //returns NULL if output does not exist
+INGESCAPE_EXPORT igs_iop_handle_t * igs_parameter_handle(const char *name); //returns NULL if parameter does not exist
+INGESCAPE_EXPORT void igs_iop_handle_destroy(igs_iop_handle_t **handle);
+
+INGESCAPE_EXPORT bool igs_iop_bool_h(igs_iop_handle_t *handle);
+INGESCAPE_EXPORT int igs_iop_int_h(igs_iop_handle_t *handle);
+INGESCAPE_EXPORT double igs_iop_double_h(igs_iop_handle_t *handle);
+
+INGESCAPE_EXPORT igs_result_t igs_output_set_bool_h(igs_iop_handle_t *handle, bool value);
+INGESCAPE_EXPORT igs_result_t igs_output_set_int_h(igs_iop_handle_t *handle, int value);
+INGESCAPE_EXPORT igs_result_t igs_output_set_double_h(igs_iop_handle_t *handle, double value);
+INGESCAPE_EXPORT igs_result_t igs_output_set_string_h(igs_iop_handle_t *handle, const char *value);
+INGESCAPE_EXPORT igs_result_t igs_output_set_impulsion_h(igs_iop_handle_t *handle);
+INGESCAPE_EXPORT igs_result_t igs_output_set_data_h(igs_iop_handle_t *handle, void *value, size_t size);
+
 /*Constraints on IOPs
  Constraints enable verifications upon sending or receiving information
  with inputs and outputs. The syntax for the constraints is global but
@@ -381,6 +436,9 @@ INGESCAPE_EXPORT void igs_clear_output(const char *name);
 INGESCAPE_EXPORT void igs_clear_parameter(const char *name);
 
 //observe changes to an IOP
+//NB: inputs mapped on the outputs of other processes are written, and
+//their callbacks executed, from dedicated ingescape threads, see
+//igs_net_set_receive_threads.
 typedef void (igs_iop_fn)(igs_iop_type_t iop_type,
                           const char *name,
                           igs_iop_value_type_t value_type,
@@ -396,6 +454,21 @@ INGESCAPE_EXPORT void igs_output_mute(const char *name);
 INGESCAPE_EXPORT void igs_output_unmute(const char *name);
 INGESCAPE_EXPORT bool igs_output_is_muted(const char *name);
 
+/*Publish an output only when its new value differs from the last
+ published one: a value bit-identical to it is not published (strings
+ and data are compared by size and hash). Impulsions are always
+ published. Suppressed publications are counted.*/
+INGESCAPE_EXPORT void igs_output_set_publish_on_change(const char *name, bool on_change_only); //default is false
+INGESCAPE_EXPORT bool igs_output_publish_on_change(const char *name);
+INGESCAPE_EXPORT size_t igs_output_suppressed_publications(const char *name);
+INGESCAPE_EXPORT size_t igs_suppressed_publications(void); //sum for all outputs
+
+/*Limit the publication rate of an output. Writes arriving faster are
+ coalesced and only the latest value is published when the next slot
+ opens. Limits only apply when the agent is started.*/
+INGESCAPE_EXPORT igs_result_t igs_output_set_max_rate(const char *name, double max_rate); //in Hz, 0 for no limit (default)
+INGESCAPE_EXPORT double igs_output_max_rate(const char *name);
+
 
 ////////////////////////////////
 // Mapping edition & inspection
@@ -432,6 +505,10 @@ INGESCAPE_EXPORT igs_result_t igs_split_remove_with_name(const char *from_our_in
 /*When mapping other agents, it is possible to ask the mapped
  agents to send us their current output values through a dedicated
  message for our initialization.
+ Our subscription to an agent is opened with the first mapping on its
+ outputs and closed with the last one: values it publishes before the
+ subscription reaches it are lost, and this request is sent shortly
+ after each mapping to get them anyway.
  By default, this behavior is disabled.*/
 INGESCAPE_EXPORT void igs_mapping_set_outputs_request(bool notify);
 INGESCAPE_EXPORT bool igs_mapping_outputs_request(void);
@@ -773,10 +850,17 @@ INGESCAPE_EXPORT void igs_mapping_save(void);
  path whose default value is '/tmp/ingescape/' completed by the
  agent UUID.
  • On Microsoft Windows systems, the loopback is used.
+ • On Linux, agents of different processes also exchange their
+ publications through a shared-memory ring created in the IPC folder,
+ unless security is enabled. Data values of a megabyte or more are
+ written in separate shared-memory segments, which these agents read in
+ place, while agents on other computers still receive them by TCP.
  Advanced transports are allowed by default and can be disabled
- using igs_set_ipc.*/
+ using igs_set_ipc, or igs_set_shm for the shared-memory ring only.*/
 INGESCAPE_EXPORT void igs_set_ipc(bool allow);
 INGESCAPE_EXPORT bool igs_has_ipc(void);
+INGESCAPE_EXPORT void igs_set_shm(bool allow);
+INGESCAPE_EXPORT bool igs_has_shm(void);
 #if defined (__UNIX__)
 //set IPC folder path on UNIX systems (default is /tmp/ingescape/)
 INGESCAPE_EXPORT void igs_set_ipc_dir(const char *path);
@@ -802,6 +886,24 @@ INGESCAPE_EXPORT void  igs_net_raise_sockets_limit(void); //UNIX only, to be cal
 //Set high water marks (HWM) for the publish/subscribe sockets.
 //Setting HWM to 0 means that they are disabled.
 INGESCAPE_EXPORT void igs_net_set_high_water_marks(int hwm_value);
+//Publications are queued by the threads writing outputs and sent by a
+//dedicated thread. Publications arriving while the queue is full are
+//dropped, like publications exceeding the high water marks. Queue size
+//is used at next start.
+INGESCAPE_EXPORT void igs_net_set_publication_queue_size(size_t size); //default is 4096
+INGESCAPE_EXPORT size_t igs_net_publication_queue_depth(void); //publications waiting to be sent
+INGESCAPE_EXPORT size_t igs_net_dropped_publications(void); //since last start
+//Publications of other processes are received and written to our inputs
+//by dedicated threads, each of them handling some of the peers, so that
+//the publications of a peer are always handled in order. Number of
+//threads is used at next start.
+INGESCAPE_EXPORT void igs_net_set_receive_threads(size_t nb_threads); //default is 1
+INGESCAPE_EXPORT size_t igs_net_receive_threads(void);
+//String and data outputs larger than this threshold are handed to ZeroMQ
+//without any copy, their value being shared with the pending publications
+//until they are sent. Smaller ones are copied, which is cheaper.
+INGESCAPE_EXPORT void igs_net_set_zero_copy_threshold(size_t size); //in bytes, default is 1024
+INGESCAPE_EXPORT size_t igs_net_zero_copy_threshold(void);
 
 
 /*PERFORMANCE CHECK
@@ -13,6 +13,7 @@
 #ifndef ingescape_private_h
 #define ingescape_private_h
 
+#include <stdarg.h>
 #include <stdbool.h>
 #include <string.h>
 #include <zyre.h>
@@ -61,6 +62,62 @@ typedef CRITICAL_SECTION igs_mutex_t;
 #   define IGS_MUTEX_DESTROY(m) DeleteCriticalSection (&m)
 #endif
 
+//  Reader/writer lock macros
+#if defined (__UNIX__)
+typedef pthread_rwlock_t igs_rwlock_t;
+#   define IGS_RWLOCK_INIT(l)           pthread_rwlock_init (&l, NULL)
+#   define IGS_RWLOCK_READ_LOCK(l)      pthread_rwlock_rdlock (&l)
+#   define IGS_RWLOCK_READ_UNLOCK(l)    pthread_rwlock_unlock (&l)
+#   define IGS_RWLOCK_WRITE_LOCK(l)     pthread_rwlock_wrlock (&l)
+#   define IGS_RWLOCK_WRITE_UNLOCK(l)   pthread_rwlock_unlock (&l)
+#   define IGS_RWLOCK_DESTROY(l)        pthread_rwlock_destroy (&l)
+#elif defined (__WINDOWS__)
+typedef SRWLOCK igs_rwlock_t;
+#   define IGS_RWLOCK_INIT(l)           InitializeSRWLock (&l)
+#   define IGS_RWLOCK_READ_LOCK(l)      AcquireSRWLockShared (&l)
+#   define IGS_RWLOCK_READ_UNLOCK(l)    ReleaseSRWLockShared (&l)
+#   define IGS_RWLOCK_WRITE_LOCK(l)     AcquireSRWLockExclusive (&l)
+#   define IGS_RWLOCK_WRITE_UNLOCK(l)   ReleaseSRWLockExclusive (&l)
+#   define IGS_RWLOCK_DESTROY(l)
+#endif
+
+//  Thread-local storage qualifier
+#if defined (__WINDOWS__)
+#   define IGS_THREAD_LOCAL __declspec(thread)
+#else
+#   define IGS_THREAD_LOCAL __thread
+#endif
+
+//  Atomic reference counts, INCREMENT and DECREMENT return the new count
+#if defined (__WINDOWS__)
+typedef volatile LONG igs_refcount_t;
+#   define IGS_REFCOUNT_INCREMENT(c)    InterlockedIncrement (&c)
+#   define IGS_REFCOUNT_DECREMENT(c)    InterlockedDecrement (&c)
+#   define IGS_REFCOUNT_GET(c)          InterlockedCompareExchange (&c, 0, 0)
+#else
+typedef int igs_refcount_t;
+#   define IGS_REFCOUNT_INCREMENT(c)    __atomic_add_fetch (&c, 1, __ATOMIC_RELAXED)
+#   define IGS_REFCOUNT_DECREMENT(c)    __atomic_sub_fetch (&c, 1, __ATOMIC_ACQ_REL)
+#   define IGS_REFCOUNT_GET(c)          __atomic_load_n (&c, __ATOMIC_ACQUIRE)
+#endif
+
+//  Atomic integers for lock-free queues and counters, sequentially consistent
+#if defined (__WINDOWS__)
+typedef volatile LONG64 igs_atomic_t;
+#   define IGS_ATOMIC_LOAD(a)           InterlockedCompareExchange64 (&a, 0, 0)
+#   define IGS_ATOMIC_STORE(a, v)       InterlockedExchange64 (&a, v)
+#   define IGS_ATOMIC_EXCHANGE(a, v)    InterlockedExchange64 (&a, v)
+#   define IGS_ATOMIC_ADD(a, v)         InterlockedExchangeAdd64 (&a, v)
+#   define IGS_ATOMIC_CAS(a, e, v)      (InterlockedCompareExchange64 (&a, v, e) == (e))
+#else
+typedef int64_t igs_atomic_t;
+#   define IGS_ATOMIC_LOAD(a)           __atomic_load_n (&a, __ATOMIC_SEQ_CST)
+#   define IGS_ATOMIC_STORE(a, v)       __atomic_store_n (&a, v, __ATOMIC_SEQ_CST)
+#   define IGS_ATOMIC_EXCHANGE(a, v)    __atomic_exchange_n (&a, v, __ATOMIC_SEQ_CST)
+#   define IGS_ATOMIC_ADD(a, v)         __atomic_fetch_add (&a, v, __ATOMIC_SEQ_CST)
+#   define IGS_ATOMIC_CAS(a, e, v)      __atomic_compare_exchange_n (&a, &e, v, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#endif
+
 typedef struct igs_core_context igs_core_context_t;
 
 //////////////////  IOP/SERVICE STRUCTURES AND ENUMS   //////////////////
@@ -111,6 +168,19 @@ typedef struct igs_constraint{
     struct igs_constraint *next;
 } igs_constraint_t;
 
+#define IGS_IOP_INLINE_VALUE_SIZE 32
+
+// reference-counted heap storage for IOP values, shared between the IOP
+// and the readers that borrowed it: the IOP only writes in place when it
+// holds the single reference
+struct _igs_value_t{
+    igs_refcount_t refcount;
+    size_t capacity;
+    char *data; //storage following this structure, or adopted buffer
+    igs_data_free_fn *free_data; //releases an adopted buffer, NULL otherwise
+    char storage[];
+};
+
 typedef struct igs_iop{
     char* name;
     char *description;
@@ -124,12 +194,41 @@ typedef struct igs_iop{
         void* data;
     } value;
     size_t value_size;
+    // storage behind value.s and value.data, either value_inline,
+    // value_block or a plain heap buffer of unknown capacity (value_capacity
+    // is 0 in this last case)
+    size_t value_capacity;
+    igs_value_t *value_block;
+    char value_inline[IGS_IOP_INLINE_VALUE_SIZE];
     bool is_muted;
+    // change suppression for outputs, protected by the global model mutex:
+    // last published value is kept as raw bits for int, double and bool
+    // and as a hash for strings and data
+    bool publish_on_change_only;
+    bool has_published_value;
+    uint64_t last_published_value;
+    size_t last_published_size;
+    size_t suppressed_publications;
+    // rate limiting for outputs, protected by the global model mutex
+    int64_t publication_period; //in microseconds, 0 if not limited
+    int64_t last_publication_time;
+    bool publication_pending; //latest value waits for the next slot
+    uint64_t publication_topic_id; //protocol v5 topic id, 0 until first publication
     igs_observe_wrapper_t *callbacks;
     igs_constraint_t *constraint;
     UT_hash_handle hh;         /* makes this structure hashable */
 } igs_iop_t;
 
+struct _igs_iop_handle_t{
+    igsagent_t *agent;
+    char *name;
+    igs_iop_type_t type;
+    // cached igs_iop_t, valid while generation matches the agent's, both
+    // atomic as threads sharing the agent read lock may update them
+    igs_atomic_t iop;
+    igs_atomic_t generation;
+};
+
 typedef struct igs_service{
     char * name;
     char * description;
@@ -159,6 +258,21 @@ typedef struct igs_map{
     UT_hash_handle hh;
 } igs_map_t;
 
+// reverse mapping index: local agents and inputs mapped on an output
+// of a remote agent, protected by the global model mutex
+typedef struct igs_mapping_target{
+    igsagent_t *agent;
+    igs_map_t *map_elmt;
+    struct igs_mapping_target *next;
+} igs_mapping_target_t;
+
+typedef struct igs_mapped_output{
+    char *key; //remote agent name and output name, separated by '\0'
+    size_t key_length;
+    igs_mapping_target_t *targets;
+    UT_hash_handle hh;
+} igs_mapped_output_t;
+
 typedef struct igs_split{
     uint64_t id;
     char* from_input;
@@ -174,6 +288,7 @@ typedef struct igs_mapping{
 
 typedef struct igs_mapping_filter {
     char *filter;
+    size_t length; //protocol v5 filters are binary
     struct igs_mapping_filter *next, *prev;
 } igs_mapping_filter_t;
 
@@ -195,6 +310,7 @@ typedef struct igs_queued_works{
         void* data;
     } value;
     size_t value_size;
+    igs_value_t *shared_value; //storage behind value.s and value.data
     struct igs_queued_works *next;
 }igs_queued_work_t;
 
@@ -208,13 +324,24 @@ typedef struct igs_splitter{
 
 //////////////////  NETWORK  STRUCTURES AND ENUMS   //////////////////
 
+// shared-memory ring of publications and its reader thread, see igs_shm.c
+typedef struct igs_shm_ring igs_shm_ring_t;
+typedef struct igs_shm_reader igs_shm_reader_t;
+
 typedef struct igs_zyre_peer {
     char *peer_id;
     char *name;
-    zsock_t *subscriber; //link to the peer's publisher socket
+    zsock_t *subscriber; //link to the peer's publisher socket while we subscribe to it, see receivers
+    char *publisher_endpoint; //NULL if the peer does not publish
+    char *public_key; //of the peer, for a secured subscriber
+    char *shm_path; //shared-memory ring of the peer, if we can read it
+    size_t nb_filters; //subscription filters of the remote agents of the peer
     int reconnected;
     bool has_joined_private_channel;
     char *protocol;
+    bool accepts_publication_batches;
+    bool uses_textual_topics; //ingescape agent older than protocol v5
+    igs_shm_reader_t *shm_reader; //reads the peer's shared-memory ring, if any, see receivers
     UT_hash_handle hh;
 } igs_zyre_peer_t;
 
@@ -238,6 +365,70 @@ typedef struct igs_timer{
     UT_hash_handle hh;
 } igs_timer_t;
 
+// output waiting for its next publication slot (see igsagent_output_set_max_rate)
+typedef struct igs_coalesced_publication{
+    char *agent_uuid;
+    char *output_name;
+} igs_coalesced_publication_t;
+
+// publication message whose large string and data frames share the
+// storage of the published values instead of copying it
+typedef struct igs_publication{
+    zmsg_t *msg;
+    igs_value_t **values; //references held until the publication is destroyed
+    size_t nb_values;
+    size_t values_capacity;
+} igs_publication_t;
+
+// item waiting in a lock-free queue, with flags telling what to do with
+// it, e.g. the publishers a publication goes to
+typedef struct igs_queued_item {
+    igs_atomic_t sequence;
+    void *item;
+    int flags;
+} igs_queued_item_t;
+
+// bounded lock-free queue, filled by any thread and drained by a single
+// one: publications for the publisher thread, commands for the receiver
+// thread
+typedef struct igs_queue {
+    igs_queued_item_t *cells;
+    int64_t mask;
+    igs_atomic_t enqueue_position;
+    igs_atomic_t dequeue_position;
+    igs_atomic_t is_waiting; //consumer thread waits for a signal
+} igs_queue_t;
+
+// receiver thread, as seen by the network thread
+typedef struct igs_receiver_thread {
+    igs_core_context_t *context;
+    zactor_t *actor;
+    igs_queue_t *queue;
+    zlist_t *backlog; //commands waiting for room in the queue
+} igs_receiver_thread_t;
+
+// event loop of the network and receiver threads, see igs_loop.c
+typedef struct igs_loop igs_loop_t;
+typedef int (igs_loop_reader_fn) (igs_loop_t *loop, zsock_t *socket, void *arg);
+typedef int (igs_loop_timer_fn) (igs_loop_t *loop, int timer_id, void *arg);
+typedef void (igs_loop_free_fn) (void *arg);
+
+// topic filter subscribed on one of our publishers
+typedef struct igs_subscription {
+    char *filter;
+    size_t length;
+    UT_hash_handle hh;
+} igs_subscription_t;
+
+// protocol v5 topic subscribed on a remote agent, giving the output a
+// received publication is about (output_name is NULL for batches)
+typedef struct igs_remote_topic {
+    uint64_t id;
+    igs_remote_agent_t *remote_agent;
+    char *output_name;
+    UT_hash_handle hh;
+} igs_remote_topic_t;
+
 typedef struct igs_peer_header {
     char *key;
     char *value;
@@ -333,6 +524,22 @@ struct _igsagent_t {
     igs_agent_event_wrapper_t *agent_event_callbacks;
     bool enforce_constraints;
 
+    /*
+     Protects the IOP values and the definition tables of this
+     agent only. Value writes take it exclusively, value reads
+     take it shared. Structural changes to the definition take it
+     exclusively in addition to the global model mutex (always
+     locked first), so that independent agents never contend on
+     each other when reading and writing their IOPs.
+     */
+    igs_rwlock_t model_lock;
+    // keep the agent and its model_lock alive: one is held by its owner
+    // until igsagent_destroy, one by each thread using it without the model
+    // mutex, the last one freeing it
+    igs_atomic_t references;
+    // incremented under model_lock each time the definition tables change
+    uint64_t definition_generation;
+
     // definition
     char *definition_path;
     igs_definition_t* definition;
@@ -350,6 +557,11 @@ struct _igsagent_t {
     bool is_whole_agent_muted;
     igs_mute_wrapper_t *mute_callbacks;
 
+    // outputs published between igsagent_outputs_begin and
+    // igsagent_outputs_commit, as name/type/value triplets,
+    // protected by the global model mutex
+    igs_publication_t *outputs_batch;
+
     zlist_t *elections;
 
     UT_hash_handle hh;
@@ -389,11 +601,15 @@ typedef struct igs_core_context {
     // network
     bool network_allow_ipc;
     bool network_allow_inproc;
+    bool network_allow_shm;
     int network_zyre_port;
     int network_hwm_value;
     unsigned int network_discovery_interval;
     unsigned int network_agent_timeout;
     unsigned int network_publishing_port;
+    size_t network_publication_queue_size;
+    size_t network_receive_threads;
+    size_t network_zero_copy_threshold; //larger values are shared with publications
     unsigned int network_log_stream_port;
     bool network_shall_raise_file_descriptors_limit;
     bool external_stop;
@@ -439,18 +655,48 @@ typedef struct igs_core_context {
     char *network_ipc_full_path;
     char *network_ipc_endpoint;
     igs_zyre_peer_t *zyre_peers;
+    size_t zyre_peers_without_batches; //peers that need one publication per output
+    size_t zyre_peers_with_textual_topics; //peers older than protocol v5
     igs_channels_wrapper_t *zyre_callbacks;
     igsagent_t *agents;
     zhash_t *created_agents;
     igs_remote_agent_t *remote_agents; // those our agents subscribed to
     igs_splitter_t *splitters;
+    igs_mapped_output_t *mapped_outputs; //reverse mapping index
     zactor_t *network_actor;
     zyre_t *node;
     zsock_t *publisher;
     zsock_t *ipc_publisher;
     zsock_t *inproc_publisher;
+    // filters subscribed on each publisher, updated by the publisher thread
+    // from the XPUB subscription messages under the model mutex
+    igs_subscription_t *publisher_subscriptions;
+    igs_subscription_t *ipc_publisher_subscriptions;
+    igs_subscription_t *inproc_publisher_subscriptions;
+    // while started, our publishers are only used by the publisher thread,
+    // which sends the publications queued by application threads
+    zactor_t *publisher_actor;
+    igs_queue_t *publication_queue;
+    igs_mutex_t publication_signal_mutex; //application threads may signal concurrently
+    // while started, the subscriber sockets and shared-memory readers of
+    // our peers are only used by the receiver threads, which write the
+    // received publications to our inputs. Each peer is handled by one of
+    // them, given by its id. The network thread hands the sockets over and
+    // updates their subscriptions through the queue of their receiver.
+    igs_receiver_thread_t *receivers;
+    size_t nb_receivers;
+    igs_atomic_t dropped_publications;
+    // written by the publisher thread for the agents of other processes
+    // of this host which subscribed to it, NULL if unavailable
+    igs_shm_ring_t *shm_ring;
+    // publications sent using IPC because they did not fit in the ring,
+    // numbered by the publisher thread, see s_drain_publication_queue
+    uint64_t shm_fallbacks;
+    // protocol v5 topics we subscribed to, by id, used by the network
+    // thread, which copies them to the receiver thread
+    igs_remote_topic_t *remote_topics;
     zsock_t *logger;
-    zloop_t *loop;
+    igs_loop_t *loop;
 
 } igs_core_context_t;
 
@@ -476,6 +722,12 @@ igs_map_t* mapping_create_mapping_element(const char * from_input,
 INGESCAPE_EXPORT bool mapping_is_equal(const char *first_str, const char *second_str);
 
 uint64_t s_djb2_hash (unsigned char *str);
+// reverse mapping index, to be called with the model mutex locked
+void mapping_index_add (igsagent_t *agent, igs_map_t *map_elmt);
+void mapping_index_remove (igsagent_t *agent, igs_map_t *map_elmt);
+void mapping_index_add_all (igsagent_t *agent); //indexes the whole mapping of agent
+void mapping_index_remove_all (igsagent_t *agent);
+igs_mapping_target_t* mapping_index_targets (const char *agent_name, const char *output_name);
 bool mapping_check_input_output_compatibility(igsagent_t *agent, igs_iop_t *found_input, igs_iop_t *found_output);
 
 // split
@@ -493,10 +745,21 @@ uint8_t* s_model_string_to_bytes (char* string);
 const igs_iop_t* model_write_iop (igsagent_t *agent, const char *iop_name, igs_iop_type_t type,
                                   igs_iop_value_type_t val_type, void* value, size_t size);
 igs_iop_t* model_find_iop_by_name(igsagent_t *agent, const char* name, igs_iop_type_t type);
+void* model_iop_value_reserve(igs_iop_t *iop, size_t size); //returns storage for at least size bytes, previous content is lost
+void model_iop_value_release(igs_iop_t *iop);
+bool model_iop_publication_is_unchanged(igs_iop_t *iop); //records the value as the last published one
+igs_value_t* model_iop_value_share(const igs_iop_t *iop); //new reference on a string or data value, NULL if none
+zframe_t* model_value_frame_new(igs_value_t *value, size_t size); //frame without copy, consumes the reference
 char* model_get_iop_value_as_string (igs_iop_t* iop); //caller owns returned value
 #define IGS_MODEL_READ_WRITE_MUTEX_DEBUG 0
 void model_read_write_lock(const char *function, int line);
 void model_read_write_unlock(const char *function, int line);
+void model_agent_retain(igsagent_t *agent);
+void model_agent_release(igsagent_t *agent); //frees the agent with its last reference
+bool model_agent_read_lock(igsagent_t *agent); //false if the agent was destroyed, lock not taken
+void model_agent_read_unlock(igsagent_t *agent);
+bool model_agent_write_lock(igsagent_t *agent); //false if the agent was destroyed, lock not taken
+void model_agent_write_unlock(igsagent_t *agent);
 igs_constraint_t* s_model_parse_constraint(igs_iop_value_type_t type,
                                            const char *expression,char **error);
 
@@ -504,6 +767,37 @@ igs_constraint_t* s_model_parse_constraint(igs_iop_value_type_t type,
 #define IGS_PRIVATE_CHANNEL "INGESCAPE_PRIVATE"
 #define IGS_DEFAULT_AGENT_NAME "no_name"
 igs_result_t network_publish_output (igsagent_t *agent, const igs_iop_t *iop);
+igs_result_t network_publish_outputs_batch (igsagent_t *agent, igs_publication_t **batch);
+igs_publication_t* network_publication_new (void);
+void network_publication_destroy (igs_publication_t **publication);
+
+// shm, shared-memory ring of publications between processes of the same
+// host, with a single writer and many readers
+#if defined (__linux__)
+#define IGS_SHM_RING 1
+#define IGS_SHM_RING_CAPACITY (16 * 1024 * 1024)
+igs_shm_ring_t* shm_ring_create (const char *path, size_t capacity); //writer, capacity is rounded up to a power of two
+igs_shm_ring_t* shm_ring_open (const char *path); //reader, starting at the current write position
+void shm_ring_destroy (igs_shm_ring_t **ring); //the writer also removes the file
+bool shm_ring_write (igs_shm_ring_t *ring, zmsg_t *msg); //false if msg is too large for the ring
+void shm_ring_subscribe (igs_shm_ring_t *ring, const char *filter, size_t length, bool subscribe); //reader, filters are counted
+zmsg_t* shm_ring_read (igs_shm_ring_t *ring); //next subscribed publication, NULL if none
+bool shm_ring_wait (igs_shm_ring_t *ring, zsock_t *pipe); //true if a publication is available, false if pipe is readable
+igs_shm_reader_t* shm_reader_new (const char *path); //thread sending the publications of the ring on its socket
+void shm_reader_destroy (igs_shm_reader_t **reader);
+zsock_t* shm_reader_sock (igs_shm_reader_t *reader);
+void shm_reader_subscribe (igs_shm_reader_t *reader, const char *filter, size_t length, bool subscribe); //filter as on a SUB socket
+#endif
+
+// loop, polling readers and firing timers until a handler returns -1
+INGESCAPE_EXPORT igs_loop_t* loop_new (void);
+INGESCAPE_EXPORT void loop_destroy (igs_loop_t **loop);
+INGESCAPE_EXPORT int loop_reader (igs_loop_t *loop, zsock_t *socket, igs_loop_reader_fn handler, void *arg);
+INGESCAPE_EXPORT void loop_reader_end (igs_loop_t *loop, zsock_t *socket);
+INGESCAPE_EXPORT int loop_timer (igs_loop_t *loop, size_t delay, size_t times, igs_loop_timer_fn handler, void *arg); //times 0 for forever, any thread
+INGESCAPE_EXPORT int loop_timer_owning (igs_loop_t *loop, size_t delay, size_t times, igs_loop_timer_fn handler, void *arg, igs_loop_free_fn free_arg); //arg is freed when the timer is removed, after its last call or with the loop
+INGESCAPE_EXPORT void loop_timer_end (igs_loop_t *loop, int timer_id); //any thread
+INGESCAPE_EXPORT int loop_start (igs_loop_t *loop);
 
 // parser
 INGESCAPE_EXPORT igs_definition_t *parser_parse_definition_from_node (igs_json_node_t **json);
@@ -518,7 +812,10 @@ INGESCAPE_EXPORT igs_mapping_t* parser_load_mapping_from_path (const char* load_
 
 // admin
 void s_admin_make_file_path(const char *from, char *to, size_t size_of_to);
+bool admin_log_is_enabled(igs_log_level_t level); //true if at least one log output accepts this level
 void admin_log(igsagent_t *agent, igs_log_level_t, const char *function, const char *format, ...)  CHECK_PRINTF (4);
+void admin_log_v(igsagent_t *agent, igs_log_level_t level, const char *function, const char *format, va_list list);
+void admin_set_logger_hwm(int hwm_value);
 
 // channels
 #define IGS_ZYRE_PEER_MUTEX_DEBUG 0
@@ -20,7 +20,7 @@
 #include "ingescape_classes.h"
 #include "ingescape_private.h"
 
-#define INGESCAPE_PROTOCOL 4
+#define INGESCAPE_PROTOCOL 5
 #define NUMBER_OF_LOGS_FOR_FFLUSH 0
 
 #ifndef W_OK
@@ -37,7 +37,8 @@ static const char *log_colors[] = {"\x1b[94m", "\x1b[36m", "\x1b[32m",
                                    "\x1b[35m"};
 
 #define LOG_TIME_LENGTH 128
-char log_content[IGS_MAX_LOG_LENGTH] = "";
+static IGS_THREAD_LOCAL char log_content[IGS_MAX_LOG_LENGTH] = "";
+static IGS_THREAD_LOCAL char log_content_rectified[IGS_MAX_LOG_LENGTH * 2 + 1] = "";
 char log_time[LOG_TIME_LENGTH] = "";
 
 // TODO: This method is a utility method and is not specialy linked with the administration. It is used in multiple .c files and may be moved to a more relevant place.
@@ -82,60 +83,94 @@ int igs_protocol (void)
     return INGESCAPE_PROTOCOL;
 }
 
+bool admin_log_is_enabled (igs_log_level_t level)
+{
+    assert (core_context);
+    return (level >= IGS_LOG_WARN)
+        || (core_context->log_in_console && level >= core_context->log_level)
+        || (core_context->log_in_file && level >= core_context->log_file_level)
+        || (core_context->log_in_stream && core_context->logger)
+        || core_context->log_in_syslog;
+}
+
 void admin_log (igsagent_t *agent,
                 igs_log_level_t level,
                 const char *function,
                 const char *fmt,
                 ...)
+{
+    assert (fmt);
+    if (!admin_log_is_enabled (level))
+        return;
+    va_list list;
+    va_start (list, fmt);
+    admin_log_v (agent, level, function, fmt, list);
+    va_end (list);
+}
+
+void admin_log_v (igsagent_t *agent,
+                  igs_log_level_t level,
+                  const char *function,
+                  const char *fmt,
+                  va_list list)
 {
     assert (agent);
     assert (function);
     assert (fmt);
 
+    // single formatting pass, done before taking the lock and shared
+    // by all outputs
+    va_list long_list;
+    va_copy (long_list, list);
+    int formatted_length = vsnprintf (log_content, IGS_MAX_LOG_LENGTH, fmt, list);
+    if (formatted_length < 0) {
+        va_end (long_list);
+        return;
+    }
+    // lines longer than our buffer are formatted again on the heap, so
+    // that file and stream logs are only truncated by their max line length
+    size_t full_log_length = (size_t) formatted_length;
+    const char *full_log_content = log_content;
+    char *long_log_content = NULL;
+    if (full_log_length >= IGS_MAX_LOG_LENGTH) {
+        long_log_content = (char *) zmalloc (full_log_length + 1);
+        vsnprintf (long_log_content, full_log_length + 1, fmt, long_list);
+        full_log_content = long_log_content;
+    }
+    va_end (long_list);
+    char *full_log_content_rectified = log_content_rectified;
+
     if (!s_lock_initialized) {
         IGS_MUTEX_INIT (lock);
         s_lock_initialized = true;
     }
     IGS_MUTEX_LOCK (lock);
     
-    // generate log entries for stream and file
-    va_list list;
-    va_start (list, fmt);
-    size_t full_log_length = vsnprintf (NULL, 0, fmt, list);
-    va_end (list);
-    size_t full_log_length_offset = 0;
-    char *full_log_content_rectified = NULL;
+    // generate log entries for stream and file with escaped line breaks
     if (core_context->log_in_file || (core_context->log_in_stream && core_context->logger)) {
-        full_log_content_rectified = (char*)zmalloc(core_context->log_file_max_line_length * 2 + 1);
-        char *full_log_content = (char*)zmalloc(core_context->log_file_max_line_length + 1);
-        va_start (list, fmt);
-        vsnprintf (full_log_content, core_context->log_file_max_line_length + 1, fmt, list);
-        va_end (list);
+        if (full_log_length > core_context->log_file_max_line_length)
+            full_log_length = core_context->log_file_max_line_length;
+        if (full_log_length > IGS_MAX_LOG_LENGTH)
+            full_log_content_rectified = (char *) zmalloc (full_log_length * 2 + 1);
         size_t j = 0;
         for (size_t i = 0; i < full_log_length; i++) {
             if (full_log_content[i] == '\n') {
                 full_log_content_rectified[j] = '\\';
                 full_log_content_rectified[j + 1] = 'n';
                 j++;
-                full_log_length_offset++;
-            } else if (full_log_content[i] == '\0')
-                break;
-            else
+            } else
                 full_log_content_rectified[j] = full_log_content[i];
             j++;
         }
         full_log_content_rectified[j] = '\0';
-        free(full_log_content);
     }
 
-    
     if (core_context->log_in_stream && core_context->logger)
         zstr_sendf (core_context->logger, "%s;%s;%s;%s\n",
                     agent->definition->name, log_levels[level], function,
                     full_log_content_rectified);
     
     if (core_context->log_in_file && level >= core_context->log_file_level) {
-        full_log_content_rectified[full_log_length + full_log_length_offset] = '\0';
         if (!core_context->log_file
             && strlen (core_context->log_file_path) == 0) {
             // Current path is empty and log file is not already initiated, create
@@ -212,9 +247,6 @@ void admin_log (igsagent_t *agent,
     
     if ((core_context->log_in_console && level >= core_context->log_level)
         || level >= IGS_LOG_WARN) {
-        va_start (list, fmt);
-        vsnprintf (log_content, IGS_MAX_LOG_LENGTH, fmt, list);
-        va_end (list);
         if (level >= IGS_LOG_WARN) {
             if (core_context->use_color_in_console)
                 fprintf (stderr, "%s;%s%s\x1b[0m;%s;%s\n",
@@ -295,10 +327,24 @@ void admin_log (igsagent_t *agent,
 #endif
     }
     
-    if (full_log_content_rectified)
-        free (full_log_content_rectified);
     assert (s_lock_initialized);
     IGS_MUTEX_UNLOCK (lock);
+    if (full_log_content_rectified != log_content_rectified)
+        free (full_log_content_rectified);
+    free (long_log_content);
+}
+
+// The logger is used by any thread logging, under the log lock
+void admin_set_logger_hwm (int hwm_value)
+{
+    if (!s_lock_initialized) {
+        IGS_MUTEX_INIT (lock);
+        s_lock_initialized = true;
+    }
+    IGS_MUTEX_LOCK (lock);
+    if (core_context->logger)
+        zsock_set_sndhwm (core_context->logger, hwm_value);
+    IGS_MUTEX_UNLOCK (lock);
 }
 
 void igs_log_set_console_level (igs_log_level_t level)
@@ -87,7 +87,11 @@ void core_init_context ()
         // by other functions.
         core_context->network_allow_ipc = true;
         core_context->network_allow_inproc = true;
+        core_context->network_allow_shm = true;
         core_context->network_hwm_value = 1000;
+        core_context->network_publication_queue_size = 4096;
+        core_context->network_receive_threads = 1;
+        core_context->network_zero_copy_threshold = 1024;
         core_context->network_discovery_interval = 1000;
         core_context->network_agent_timeout = 8000;
         core_context->log_level = IGS_LOG_INFO;
@@ -447,6 +451,57 @@ igs_result_t igs_parameter_data (const char *name, void **data, size_t *size)
     return igsagent_parameter_data (core_agent, name, data, size);
 }
 
+igs_result_t igs_input_data_borrow (const char *name,
+                                    const void **data,
+                                    size_t *size,
+                                    igs_value_t **token)
+{
+    core_init_agent ();
+    return igsagent_input_data_borrow (core_agent, name, data, size, token);
+}
+
+igs_result_t igs_input_string_borrow (const char *name,
+                                      const char **value,
+                                      igs_value_t **token)
+{
+    core_init_agent ();
+    return igsagent_input_string_borrow (core_agent, name, value, token);
+}
+
+igs_result_t igs_output_data_borrow (const char *name,
+                                     const void **data,
+                                     size_t *size,
+                                     igs_value_t **token)
+{
+    core_init_agent ();
+    return igsagent_output_data_borrow (core_agent, name, data, size, token);
+}
+
+igs_result_t igs_output_string_borrow (const char *name,
+                                       const char **value,
+                                       igs_value_t **token)
+{
+    core_init_agent ();
+    return igsagent_output_string_borrow (core_agent, name, value, token);
+}
+
+igs_result_t igs_parameter_data_borrow (const char *name,
+                                        const void **data,
+                                        size_t *size,
+                                        igs_value_t **token)
+{
+    core_init_agent ();
+    return igsagent_parameter_data_borrow (core_agent, name, data, size, token);
+}
+
+igs_result_t igs_parameter_string_borrow (const char *name,
+                                          const char **value,
+                                          igs_value_t **token)
+{
+    core_init_agent ();
+    return igsagent_parameter_string_borrow (core_agent, name, value, token);
+}
+
 igs_result_t igs_input_set_bool (const char *name, bool value)
 {
     core_init_agent ();
@@ -519,6 +574,28 @@ igs_result_t igs_output_set_data (const char *name, void *value, size_t size)
     return igsagent_output_set_data (core_agent, name, value, size);
 }
 
+igs_result_t igs_output_set_data_owned (const char *name,
+                                        void *value,
+                                        size_t size,
+                                        igs_data_free_fn *free_fn)
+{
+    assert (name);
+    core_init_agent ();
+    return igsagent_output_set_data_owned (core_agent, name, value, size, free_fn);
+}
+
+igs_result_t igs_outputs_begin (void)
+{
+    core_init_agent ();
+    return igsagent_outputs_begin (core_agent);
+}
+
+igs_result_t igs_outputs_commit (void)
+{
+    core_init_agent ();
+    return igsagent_outputs_commit (core_agent);
+}
+
 igs_result_t igs_parameter_set_bool (const char *name, bool value)
 {
     core_init_agent ();
@@ -549,6 +626,24 @@ igs_result_t igs_parameter_set_data (const char *name, void *value, size_t size)
     return igsagent_parameter_set_data (core_agent, name, value, size);
 }
 
+igs_iop_handle_t *igs_input_handle (const char *name)
+{
+    core_init_agent ();
+    return igsagent_input_handle (core_agent, name);
+}
+
+igs_iop_handle_t *igs_output_handle (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_handle (core_agent, name);
+}
+
+igs_iop_handle_t *igs_parameter_handle (const char *name)
+{
+    core_init_agent ();
+    return igsagent_parameter_handle (core_agent, name);
+}
+
 igs_result_t igs_input_add_constraint (const char *name, const char *constraint)
 {
     core_init_agent ();
@@ -695,6 +790,42 @@ bool igs_output_is_muted (const char *name)
     return igsagent_output_is_muted (core_agent, name);
 }
 
+void igs_output_set_publish_on_change (const char *name, bool on_change_only)
+{
+    core_init_agent ();
+    igsagent_output_set_publish_on_change (core_agent, name, on_change_only);
+}
+
+bool igs_output_publish_on_change (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_publish_on_change (core_agent, name);
+}
+
+size_t igs_output_suppressed_publications (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_suppressed_publications (core_agent, name);
+}
+
+size_t igs_suppressed_publications (void)
+{
+    core_init_agent ();
+    return igsagent_suppressed_publications (core_agent);
+}
+
+igs_result_t igs_output_set_max_rate (const char *name, double max_rate)
+{
+    core_init_agent ();
+    return igsagent_output_set_max_rate (core_agent, name, max_rate);
+}
+
+double igs_output_max_rate (const char *name)
+{
+    core_init_agent ();
+    return igsagent_output_max_rate (core_agent, name);
+}
+
 igs_iop_value_type_t igs_input_type (const char *name)
 {
     core_init_agent ();
@@ -1055,12 +1186,12 @@ void igs_log (igs_log_level_t level,
               ...)
 {
     core_init_agent ();
+    if (!admin_log_is_enabled (level))
+        return;
     va_list list;
     va_start (list, format);
-    char content[IGS_MAX_STRING_MSG_LENGTH] = "";
-    vsnprintf (content, IGS_MAX_STRING_MSG_LENGTH - 1, format, list);
+    admin_log_v (core_agent, level, function, format, list);
     va_end (list);
-    admin_log (core_agent, level, function, "%s", content);
 }
 
 // ADVANCED
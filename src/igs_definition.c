@@ -42,12 +42,8 @@ void s_definition_free_iop (igs_iop_t **iop)
 
     switch ((*iop)->value_type) {
         case IGS_STRING_T:
-            if ((*iop)->value.s)
-                free ((char *) (*iop)->value.s);
-            break;
         case IGS_DATA_T:
-            if ((*iop)->value.data)
-                free ((*iop)->value.data);
+            model_iop_value_release (*iop);
             break;
         default:
             break;
@@ -82,6 +78,7 @@ igs_result_t definition_add_iop_to_definition (igsagent_t *agent,
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_SUCCESS;
     }
+    model_agent_write_lock (agent);
     igs_iop_t *previousIOP = NULL;
     switch (iop_type) {
         case IGS_INPUT_T:
@@ -99,6 +96,7 @@ igs_result_t definition_add_iop_to_definition (igsagent_t *agent,
     if (previousIOP) {
         igsagent_error (agent, "%s already exists and cannot be overwritten",
                          iop->name);
+        model_agent_write_unlock (agent);
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
@@ -115,6 +113,8 @@ igs_result_t definition_add_iop_to_definition (igsagent_t *agent,
         default:
             break;
     }
+    agent->definition_generation++;
+    model_agent_write_unlock (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
 }
@@ -237,6 +237,7 @@ void igsagent_clear_definition (igsagent_t *agent)
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return;
     }
+    model_agent_write_lock (agent);
     char *previous_name = NULL;
     if (agent->definition) {
         if (agent->definition->name)
@@ -252,6 +253,8 @@ void igsagent_clear_definition (igsagent_t *agent)
         // igsagent_debug(agent, "Use default name '%s'", IGS_DEFAULT_AGENT_NAME);
     }
     agent->network_need_to_send_definition_update = true;
+    agent->definition_generation++;
+    model_agent_write_unlock (agent);
     model_read_write_unlock (__FUNCTION__, __LINE__);
 }
 
@@ -261,7 +264,10 @@ char *igsagent_definition_json (igsagent_t *agent)
     char *def = NULL;
     if (!agent->definition)
         return NULL;
+    // values are written under the agent lock only
+    model_agent_read_lock (agent);
     def = parser_export_definition (agent->definition);
+    model_agent_read_unlock (agent);
     return def;
 }
 
@@ -392,8 +398,11 @@ igs_result_t igsagent_input_remove (igsagent_t *agent, const char *name)
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_SUCCESS;
     }
+    model_agent_write_lock (agent);
     HASH_DEL (agent->definition->inputs_table, iop);
     s_definition_free_iop (&iop);
+    agent->definition_generation++;
+    model_agent_write_unlock (agent);
     agent->network_need_to_send_definition_update = true;
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
@@ -415,8 +424,11 @@ igs_result_t igsagent_output_remove (igsagent_t *agent, const char *name)
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_SUCCESS;
     }
+    model_agent_write_lock (agent);
     HASH_DEL (agent->definition->outputs_table, iop);
     s_definition_free_iop (&iop);
+    agent->definition_generation++;
+    model_agent_write_unlock (agent);
     agent->network_need_to_send_definition_update = true;
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
@@ -438,8 +450,11 @@ igs_result_t igsagent_parameter_remove (igsagent_t *agent, const char *name)
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_SUCCESS;
     }
+    model_agent_write_lock (agent);
     HASH_DEL (agent->definition->params_table, iop);
     s_definition_free_iop (&iop);
+    agent->definition_generation++;
+    model_agent_write_unlock (agent);
     agent->network_need_to_send_definition_update = true;
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
@@ -491,7 +506,9 @@ void igsagent_definition_save (igsagent_t *agent)
         igsagent_error (agent, "Could not open '%s' for writing",
                          agent->definition_path);
     else {
+        model_agent_read_lock (agent);
         char *def = parser_export_definition (agent->definition);
+        model_agent_read_unlock (agent);
         assert (def);
         fprintf (fp, "%s", def);
         fflush (fp);
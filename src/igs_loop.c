@@ -0,0 +1,479 @@
+/*  =========================================================================
+    loop - event loop of the network and receiver threads
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+    This file is part of Ingescape, see https://github.com/zeromq/ingescape.
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#include "ingescape_private.h"
+
+#include <limits.h>
+
+// The loop replaces zloop, whose cost grows with the number of readers and
+// timers: zloop polls an array of all its readers and checks all its timers
+// at each iteration.
+//
+// Readers are polled with zmq_poller when libzmq provides it, i.e. with
+// epoll on Linux, whose cost does not depend on the number of idle
+// readers. Otherwise, they are polled with zmq_poll over an array rebuilt
+// only when readers change.
+//
+// Timers are kept in a hierarchical timing wheel with a 1 ms tick: level 0
+// holds the timers due in the next LOOP_WHEEL_SLOTS ticks, one slot per
+// tick, and each next level holds timers further away, one slot covering a
+// whole revolution of the level below. When a level completes a
+// revolution, the next slot of the level above is cascaded into it. Adding
+// or removing a timer and firing it are O(1). Timers further away than the
+// wheel are clamped to its last slot and inserted again when reaching it.
+// Timers may be added and removed from any thread: a timer due before the
+// end of the current poll wakes the loop up through an internal pipe.
+
+#define LOOP_WHEEL_BITS 6
+#define LOOP_WHEEL_SLOTS (1 << LOOP_WHEEL_BITS)
+#define LOOP_WHEEL_MASK (LOOP_WHEEL_SLOTS - 1)
+#define LOOP_WHEEL_LEVELS 4
+#define LOOP_WHEEL_SPAN ((int64_t) 1 << (LOOP_WHEEL_BITS * LOOP_WHEEL_LEVELS))
+
+#define LOOP_TIMER_FIRING -1 //level of the timers being fired
+
+typedef struct igs_loop_reader {
+    zsock_t *socket;
+    igs_loop_reader_fn *handler;
+    void *arg;
+    bool ended; //freed after the current poll results
+    UT_hash_handle hh;
+    struct igs_loop_reader *next; //in the ended readers
+} igs_loop_reader_t;
+
+typedef struct igs_loop_timer {
+    int timer_id;
+    size_t delay;
+    size_t times; //remaining, 0 for forever
+    igs_loop_timer_fn *handler;
+    void *arg;
+    igs_loop_free_fn *free_arg; //may be NULL
+    int64_t expiry; //in ms on the monotonic clock
+    int level; //in the wheel, or LOOP_TIMER_FIRING
+    int slot;
+    bool ended; //freed once fired
+    struct igs_loop_timer *prev, *next; //in its slot
+    UT_hash_handle hh;
+} igs_loop_timer_t;
+
+struct igs_loop {
+    igs_loop_reader_t *readers; //by socket
+    igs_loop_reader_t *ended_readers;
+    size_t nb_readers;
+#if defined(ZMQ_HAVE_POLLER)
+    void *poller;
+    zmq_poller_event_t *events;
+    size_t events_capacity;
+#else
+    bool readers_changed;
+    zmq_pollitem_t *items;
+    igs_loop_reader_t **items_readers;
+    size_t nb_items;
+#endif
+    igs_mutex_t timers_mutex;
+    igs_loop_timer_t *timers; //by id
+    igs_loop_timer_t *wheel[LOOP_WHEEL_LEVELS][LOOP_WHEEL_SLOTS];
+    int64_t wheel_time; //last tick processed
+    int last_timer_id;
+    zsock_t *wakeup; //read by the loop
+    zsock_t *wakeup_sender; //used under the timers mutex
+    bool polling; //the loop waits until poll_end
+    int64_t poll_end; //-1 for no timer
+};
+
+// May be called with the timers mutex locked: free_arg shall not use the
+// loop
+static void s_timer_destroy (igs_loop_timer_t *timer)
+{
+    if (timer->free_arg)
+        timer->free_arg (timer->arg);
+    free (timer);
+}
+
+static int s_wakeup (igs_loop_t *loop, zsock_t *socket, void *arg)
+{
+    IGS_UNUSED (loop)
+    IGS_UNUSED (arg)
+    zsock_wait (socket);
+    return 0;
+}
+
+igs_loop_t *loop_new (void)
+{
+    igs_loop_t *loop = (igs_loop_t *) zmalloc (sizeof (igs_loop_t));
+#if defined(ZMQ_HAVE_POLLER)
+    loop->poller = zmq_poller_new ();
+    assert (loop->poller);
+#endif
+    IGS_MUTEX_INIT (loop->timers_mutex);
+    loop->wheel_time = zclock_mono ();
+    loop->wakeup = zsys_create_pipe (&loop->wakeup_sender);
+    assert (loop->wakeup);
+    loop_reader (loop, loop->wakeup, s_wakeup, NULL);
+    return loop;
+}
+
+static void s_free_ended_readers (igs_loop_t *loop)
+{
+    igs_loop_reader_t *reader = loop->ended_readers;
+    while (reader) {
+        igs_loop_reader_t *next = reader->next;
+        free (reader);
+        reader = next;
+    }
+    loop->ended_readers = NULL;
+}
+
+void loop_destroy (igs_loop_t **loop)
+{
+    assert (loop);
+    if (*loop == NULL)
+        return;
+    igs_loop_reader_t *reader, *tmp_reader;
+    HASH_ITER (hh, (*loop)->readers, reader, tmp_reader){
+        HASH_DEL ((*loop)->readers, reader);
+        free (reader);
+    }
+    s_free_ended_readers (*loop);
+    igs_loop_timer_t *timer, *tmp_timer;
+    HASH_ITER (hh, (*loop)->timers, timer, tmp_timer){
+        HASH_DEL ((*loop)->timers, timer);
+        s_timer_destroy (timer);
+    }
+#if defined(ZMQ_HAVE_POLLER)
+    zmq_poller_destroy (&(*loop)->poller);
+    free ((*loop)->events);
+#else
+    free ((*loop)->items);
+    free ((*loop)->items_readers);
+#endif
+    zsock_destroy (&(*loop)->wakeup);
+    zsock_destroy (&(*loop)->wakeup_sender);
+    IGS_MUTEX_DESTROY ((*loop)->timers_mutex);
+    free (*loop);
+    *loop = NULL;
+}
+
+int loop_reader (igs_loop_t *loop,
+                 zsock_t *socket,
+                 igs_loop_reader_fn handler,
+                 void *arg)
+{
+    assert (loop);
+    assert (socket);
+    assert (handler);
+    igs_loop_reader_t *reader = NULL;
+    HASH_FIND_PTR (loop->readers, &socket, reader);
+    if (reader) {
+        igs_error ("socket is already read by this loop");
+        return -1;
+    }
+    reader = (igs_loop_reader_t *) zmalloc (sizeof (igs_loop_reader_t));
+    reader->socket = socket;
+    reader->handler = handler;
+    reader->arg = arg;
+#if defined(ZMQ_HAVE_POLLER)
+    if (zmq_poller_add (loop->poller, zsock_resolve (socket), reader, ZMQ_POLLIN) != 0) {
+        igs_error ("could not add socket to the loop (%s)", zmq_strerror (zmq_errno ()));
+        free (reader);
+        return -1;
+    }
+#else
+    loop->readers_changed = true;
+#endif
+    HASH_ADD_PTR (loop->readers, socket, reader);
+    loop->nb_readers++;
+    return 0;
+}
+
+void loop_reader_end (igs_loop_t *loop, zsock_t *socket)
+{
+    assert (loop);
+    assert (socket);
+    igs_loop_reader_t *reader = NULL;
+    HASH_FIND_PTR (loop->readers, &socket, reader);
+    if (reader == NULL)
+        return;
+    HASH_DEL (loop->readers, reader);
+    loop->nb_readers--;
+#if defined(ZMQ_HAVE_POLLER)
+    zmq_poller_remove (loop->poller, zsock_resolve (socket));
+#else
+    loop->readers_changed = true;
+#endif
+    // the reader may still be in the results of the current poll
+    reader->ended = true;
+    reader->next = loop->ended_readers;
+    loop->ended_readers = reader;
+}
+
+// Must be called with the timers mutex locked. Timers are placed at tick
+// 'from' at the earliest.
+static void s_wheel_insert (igs_loop_t *loop, igs_loop_timer_t *timer, int64_t from)
+{
+    int64_t when = (timer->expiry > from) ? timer->expiry : from;
+    if (when - loop->wheel_time >= LOOP_WHEEL_SPAN)
+        when = loop->wheel_time + LOOP_WHEEL_SPAN - 1;
+    int64_t delta = when - loop->wheel_time;
+    int level = 0;
+    while (level < LOOP_WHEEL_LEVELS - 1
+           && delta >= ((int64_t) 1 << (LOOP_WHEEL_BITS * (level + 1))))
+        level++;
+    timer->level = level;
+    timer->slot = (int) ((when >> (LOOP_WHEEL_BITS * level)) & LOOP_WHEEL_MASK);
+    DL_APPEND (loop->wheel[level][timer->slot], timer);
+}
+
+int loop_timer (igs_loop_t *loop,
+                size_t delay,
+                size_t times,
+                igs_loop_timer_fn handler,
+                void *arg)
+{
+    return loop_timer_owning (loop, delay, times, handler, arg, NULL);
+}
+
+int loop_timer_owning (igs_loop_t *loop,
+                       size_t delay,
+                       size_t times,
+                       igs_loop_timer_fn handler,
+                       void *arg,
+                       igs_loop_free_fn free_arg)
+{
+    assert (loop);
+    assert (handler);
+    igs_loop_timer_t *timer = (igs_loop_timer_t *) zmalloc (sizeof (igs_loop_timer_t));
+    timer->delay = delay;
+    timer->times = times;
+    timer->handler = handler;
+    timer->arg = arg;
+    timer->free_arg = free_arg;
+    timer->expiry = zclock_mono () + (int64_t) delay;
+    IGS_MUTEX_LOCK (loop->timers_mutex);
+    // ids wrap around, skipping the ones still in use
+    igs_loop_timer_t *existing = NULL;
+    do {
+        loop->last_timer_id = (loop->last_timer_id == INT_MAX) ? 1 : loop->last_timer_id + 1;
+        HASH_FIND_INT (loop->timers, &loop->last_timer_id, existing);
+    } while (existing);
+    timer->timer_id = loop->last_timer_id;
+    HASH_ADD_INT (loop->timers, timer_id, timer);
+    s_wheel_insert (loop, timer, loop->wheel_time + 1);
+    int timer_id = timer->timer_id;
+    if (loop->polling && (loop->poll_end < 0 || timer->expiry < loop->poll_end)) {
+        loop->poll_end = timer->expiry;
+        zsock_signal (loop->wakeup_sender, 0);
+    }
+    IGS_MUTEX_UNLOCK (loop->timers_mutex);
+    return timer_id;
+}
+
+void loop_timer_end (igs_loop_t *loop, int timer_id)
+{
+    assert (loop);
+    IGS_MUTEX_LOCK (loop->timers_mutex);
+    igs_loop_timer_t *timer = NULL;
+    HASH_FIND_INT (loop->timers, &timer_id, timer);
+    if (timer) {
+        HASH_DEL (loop->timers, timer);
+        if (timer->level == LOOP_TIMER_FIRING)
+            timer->ended = true;
+        else {
+            DL_DELETE (loop->wheel[timer->level][timer->slot], timer);
+            s_timer_destroy (timer);
+        }
+    }
+    IGS_MUTEX_UNLOCK (loop->timers_mutex);
+}
+
+// Fires the timers of level 0 slot for tick, with the timers mutex locked,
+// which is released while calling handlers. Returns -1 if a handler did.
+static int s_fire_timers (igs_loop_t *loop, int64_t tick)
+{
+    int result = 0;
+    igs_loop_timer_t *firing = loop->wheel[0][tick & LOOP_WHEEL_MASK];
+    loop->wheel[0][tick & LOOP_WHEEL_MASK] = NULL;
+    igs_loop_timer_t *timer = NULL;
+    DL_FOREACH (firing, timer)
+        timer->level = LOOP_TIMER_FIRING;
+    while (firing) {
+        timer = firing;
+        DL_DELETE (firing, timer);
+        if (timer->ended) {
+            s_timer_destroy (timer);
+            continue;
+        }
+        if (timer->expiry > tick) {
+            // clamped timer, still far away
+            s_wheel_insert (loop, timer, tick + 1);
+            continue;
+        }
+        IGS_MUTEX_UNLOCK (loop->timers_mutex);
+        if (timer->handler (loop, timer->timer_id, timer->arg) == -1)
+            result = -1;
+        IGS_MUTEX_LOCK (loop->timers_mutex);
+        if (!timer->ended && timer->times != 1) {
+            if (timer->times > 1)
+                timer->times--;
+            timer->expiry = tick + (int64_t) timer->delay;
+            s_wheel_insert (loop, timer, tick + 1);
+        }
+        else {
+            if (!timer->ended)
+                HASH_DEL (loop->timers, timer);
+            s_timer_destroy (timer);
+        }
+    }
+    return result;
+}
+
+// Moves the timers of a slot to the lower levels, with the timers mutex
+// locked
+static void s_cascade_timers (igs_loop_t *loop, int level, int64_t tick)
+{
+    int slot = (int) ((tick >> (LOOP_WHEEL_BITS * level)) & LOOP_WHEEL_MASK);
+    igs_loop_timer_t *cascaded = loop->wheel[level][slot];
+    loop->wheel[level][slot] = NULL;
+    while (cascaded) {
+        igs_loop_timer_t *timer = cascaded;
+        DL_DELETE (cascaded, timer);
+        s_wheel_insert (loop, timer, tick);
+    }
+}
+
+// Processes the ticks up to now. Returns -1 if a handler did.
+static int s_advance_timers (igs_loop_t *loop, int64_t now)
+{
+    int result = 0;
+    IGS_MUTEX_LOCK (loop->timers_mutex);
+    if (loop->timers == NULL && loop->wheel_time < now)
+        loop->wheel_time = now;
+    while (loop->wheel_time < now && result == 0) {
+        int64_t tick = loop->wheel_time + 1;
+        // empty ticks are skipped up to the next cascade
+        while ((tick & LOOP_WHEEL_MASK) && tick < now
+               && loop->wheel[0][tick & LOOP_WHEEL_MASK] == NULL)
+            tick++;
+        loop->wheel_time = tick;
+        for (int level = 1; level < LOOP_WHEEL_LEVELS; level++) {
+            if (tick & (((int64_t) 1 << (LOOP_WHEEL_BITS * level)) - 1))
+                break;
+            s_cascade_timers (loop, level, tick);
+        }
+        result = s_fire_timers (loop, tick);
+    }
+    IGS_MUTEX_UNLOCK (loop->timers_mutex);
+    return result;
+}
+
+// Time before the next tick having timers to fire or to cascade, in ms,
+// -1 if there is no timer. The loop is then polling until this tick.
+static long s_timers_timeout (igs_loop_t *loop, int64_t now)
+{
+    IGS_MUTEX_LOCK (loop->timers_mutex);
+    int64_t next = -1;
+    if (loop->timers) {
+        for (int level = 0; level < LOOP_WHEEL_LEVELS; level++) {
+            int shift = LOOP_WHEEL_BITS * level;
+            int64_t current = loop->wheel_time >> shift;
+            for (int64_t k = 1; k <= LOOP_WHEEL_SLOTS; k++) {
+                if (loop->wheel[level][(current + k) & LOOP_WHEEL_MASK]) {
+                    int64_t tick = (current + k) << shift;
+                    if (next < 0 || tick < next)
+                        next = tick;
+                    break;
+                }
+            }
+        }
+    }
+    loop->polling = true;
+    loop->poll_end = next;
+    IGS_MUTEX_UNLOCK (loop->timers_mutex);
+    if (next < 0)
+        return -1;
+    return (next > now) ? (long) (next - now) : 0;
+}
+
+#if !defined(ZMQ_HAVE_POLLER)
+static void s_rebuild_items (igs_loop_t *loop)
+{
+    free (loop->items);
+    free (loop->items_readers);
+    loop->nb_items = loop->nb_readers;
+    loop->items = (zmq_pollitem_t *) zmalloc ((loop->nb_items + 1) * sizeof (zmq_pollitem_t));
+    loop->items_readers = (igs_loop_reader_t **) zmalloc ((loop->nb_items + 1) * sizeof (igs_loop_reader_t *));
+    size_t i = 0;
+    igs_loop_reader_t *reader, *tmp;
+    HASH_ITER (hh, loop->readers, reader, tmp){
+        loop->items[i].socket = zsock_resolve (reader->socket);
+        loop->items[i].events = ZMQ_POLLIN;
+        loop->items_readers[i] = reader;
+        i++;
+    }
+    loop->readers_changed = false;
+}
+#endif
+
+// Timers added from now on are seen before the next poll
+static void s_stop_polling (igs_loop_t *loop)
+{
+    IGS_MUTEX_LOCK (loop->timers_mutex);
+    loop->polling = false;
+    IGS_MUTEX_UNLOCK (loop->timers_mutex);
+}
+
+int loop_start (igs_loop_t *loop)
+{
+    assert (loop);
+    int result = 0;
+    while (result == 0 && !zsys_interrupted) {
+        long timeout = s_timers_timeout (loop, zclock_mono ());
+#if defined(ZMQ_HAVE_POLLER)
+        if (loop->events_capacity < loop->nb_readers) {
+            loop->events_capacity = loop->nb_readers;
+            loop->events = (zmq_poller_event_t *) realloc (
+              loop->events, loop->events_capacity * sizeof (zmq_poller_event_t));
+        }
+        int nb_events = zmq_poller_wait_all (loop->poller, loop->events,
+                                             (int) loop->nb_readers, timeout);
+        if (nb_events < 0 && zmq_errno () == EAGAIN)
+            nb_events = 0;
+        s_stop_polling (loop);
+        if (nb_events < 0)
+            break; //interrupted or context terminated
+        for (int i = 0; i < nb_events && result == 0; i++) {
+            igs_loop_reader_t *reader = (igs_loop_reader_t *) loop->events[i].user_data;
+            if (!reader->ended && (loop->events[i].events & ZMQ_POLLIN))
+                result = reader->handler (loop, reader->socket, reader->arg);
+        }
+#else
+        if (loop->readers_changed)
+            s_rebuild_items (loop);
+        int nb_events = zmq_poll (loop->items, (int) loop->nb_items, timeout);
+        s_stop_polling (loop);
+        if (nb_events < 0)
+            break; //interrupted or context terminated
+        for (size_t i = 0; i < loop->nb_items && nb_events > 0 && result == 0; i++) {
+            if (loop->items[i].revents == 0)
+                continue;
+            nb_events--;
+            igs_loop_reader_t *reader = loop->items_readers[i];
+            if (!reader->ended && (loop->items[i].revents & ZMQ_POLLIN))
+                result = reader->handler (loop, reader->socket, reader->arg);
+        }
+#endif
+        s_free_ended_readers (loop);
+        if (result == 0)
+            result = s_advance_timers (loop, zclock_mono ());
+    }
+    return result;
+}
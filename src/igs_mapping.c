@@ -67,6 +67,111 @@ void mapping_free_mapping (igs_mapping_t **mapping)
     *mapping = NULL;
 }
 
+// Key of an output in the reverse mapping index, written in buffer when it
+// fits or allocated otherwise. Returns the key, to be freed if different
+// from buffer.
+static char *s_mapping_index_key (const char *agent_name,
+                                  const char *output_name,
+                                  char *buffer,
+                                  size_t buffer_size,
+                                  size_t *key_length)
+{
+    size_t agent_length = strlen (agent_name);
+    size_t output_length = strlen (output_name);
+    *key_length = agent_length + 1 + output_length;
+    char *key = (*key_length <= buffer_size) ? buffer : (char *) zmalloc (*key_length);
+    memcpy (key, agent_name, agent_length);
+    key[agent_length] = '\0';
+    memcpy (key + agent_length + 1, output_name, output_length);
+    return key;
+}
+
+static igs_mapped_output_t *s_mapping_index_find (const char *agent_name,
+                                                  const char *output_name)
+{
+    char buffer[256];
+    size_t key_length = 0;
+    char *key = s_mapping_index_key (agent_name, output_name, buffer, 256, &key_length);
+    igs_mapped_output_t *mapped_output = NULL;
+    HASH_FIND (hh, core_context->mapped_outputs, key, key_length, mapped_output);
+    if (key != buffer)
+        free (key);
+    return mapped_output;
+}
+
+void mapping_index_add (igsagent_t *agent, igs_map_t *map_elmt)
+{
+    assert (agent);
+    assert (map_elmt);
+    core_init_context ();
+    igs_mapped_output_t *mapped_output =
+      s_mapping_index_find (map_elmt->to_agent, map_elmt->to_output);
+    if (!mapped_output) {
+        mapped_output = (igs_mapped_output_t *) zmalloc (sizeof (igs_mapped_output_t));
+        mapped_output->key = s_mapping_index_key (map_elmt->to_agent, map_elmt->to_output,
+                                                  NULL, 0, &mapped_output->key_length);
+        HASH_ADD_KEYPTR (hh, core_context->mapped_outputs, mapped_output->key,
+                         mapped_output->key_length, mapped_output);
+    }
+    igs_mapping_target_t *target = (igs_mapping_target_t *) zmalloc (sizeof (igs_mapping_target_t));
+    target->agent = agent;
+    target->map_elmt = map_elmt;
+    LL_APPEND (mapped_output->targets, target);
+}
+
+void mapping_index_remove (igsagent_t *agent, igs_map_t *map_elmt)
+{
+    assert (agent);
+    assert (map_elmt);
+    core_init_context ();
+    igs_mapped_output_t *mapped_output =
+      s_mapping_index_find (map_elmt->to_agent, map_elmt->to_output);
+    if (!mapped_output)
+        return;
+    igs_mapping_target_t *target, *tmp;
+    LL_FOREACH_SAFE (mapped_output->targets, target, tmp){
+        if (target->agent == agent && target->map_elmt == map_elmt) {
+            LL_DELETE (mapped_output->targets, target);
+            free (target);
+        }
+    }
+    if (!mapped_output->targets) {
+        HASH_DEL (core_context->mapped_outputs, mapped_output);
+        free (mapped_output->key);
+        free (mapped_output);
+    }
+}
+
+void mapping_index_add_all (igsagent_t *agent)
+{
+    assert (agent);
+    if (!agent->mapping)
+        return;
+    igs_map_t *elmt, *tmp;
+    HASH_ITER (hh, agent->mapping->map_elements, elmt, tmp)
+        mapping_index_add (agent, elmt);
+}
+
+void mapping_index_remove_all (igsagent_t *agent)
+{
+    assert (agent);
+    if (!agent->mapping)
+        return;
+    igs_map_t *elmt, *tmp;
+    HASH_ITER (hh, agent->mapping->map_elements, elmt, tmp)
+        mapping_index_remove (agent, elmt);
+}
+
+igs_mapping_target_t *mapping_index_targets (const char *agent_name,
+                                             const char *output_name)
+{
+    assert (agent_name);
+    assert (output_name);
+    core_init_context ();
+    igs_mapped_output_t *mapped_output = s_mapping_index_find (agent_name, output_name);
+    return (mapped_output) ? mapped_output->targets : NULL;
+}
+
 bool mapping_is_equal (const char *first_str, const char *second_str)
 {
     if (!first_str && !second_str)
@@ -213,9 +318,12 @@ igs_result_t igsagent_mapping_load_str (igsagent_t *agent,
             model_read_write_unlock (__FUNCTION__, __LINE__);
             return IGS_FAILURE;
         }
-        if (agent->mapping)
+        if (agent->mapping) {
+            mapping_index_remove_all (agent);
             mapping_free_mapping (&agent->mapping);
+        }
         agent->mapping = tmp;
+        mapping_index_add_all (agent);
         agent->network_need_to_send_mapping_update = true;
         model_read_write_unlock (__FUNCTION__, __LINE__);
     }
@@ -239,10 +347,13 @@ igs_result_t igsagent_mapping_load_file (igsagent_t *agent,
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
-    if (agent->mapping)
+    if (agent->mapping) {
+        mapping_index_remove_all (agent);
         mapping_free_mapping (&agent->mapping);
+    }
     agent->mapping_path = s_strndup (file_path, IGS_MAX_PATH_LENGTH - 1);
     agent->mapping = tmp;
+    mapping_index_add_all (agent);
     agent->network_need_to_send_mapping_update = true;
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
@@ -259,8 +370,10 @@ void igsagent_clear_mappings (igsagent_t *agent)
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return;
     }
-    if (agent->mapping)
+    if (agent->mapping) {
+        mapping_index_remove_all (agent);
         mapping_free_mapping (&agent->mapping);
+    }
     agent->mapping =
       (struct igs_mapping *) zmalloc (sizeof (struct igs_mapping));
     agent->network_need_to_send_mapping_update = true;
@@ -281,6 +394,7 @@ void igsagent_clear_mappings_with_agent (igsagent_t *agent,
         HASH_ITER (hh, agent->mapping->map_elements, elmt, tmp)
         {
             if (streq (elmt->to_agent, agent_name)) {
+                mapping_index_remove (agent, elmt);
                 HASH_DEL (agent->mapping->map_elements, elmt);
                 s_mapping_free_mapping_element (&elmt);
                 agent->network_need_to_send_mapping_update = true;
@@ -424,6 +538,7 @@ uint64_t igsagent_mapping_add (igsagent_t *agent,
         igs_map_t *new = mapping_create_mapping_element (reviewed_from_our_input, reviewed_to_agent, reviewed_with_output);
         new->id = hash;
         HASH_ADD (hh, agent->mapping->map_elements, id, sizeof (uint64_t), new);
+        mapping_index_add (agent, new);
         agent->network_need_to_send_mapping_update = true;
     } else
         igsagent_warn (agent,
@@ -460,6 +575,7 @@ igs_result_t igsagent_mapping_remove_with_id (igsagent_t *agent,
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_SUCCESS;
     }
+    mapping_index_remove (agent, el);
     HASH_DEL (agent->mapping->map_elements, el);
     s_mapping_free_mapping_element (&el);
     agent->network_need_to_send_mapping_update = true;
@@ -509,6 +625,7 @@ igs_result_t igsagent_mapping_remove_with_name (igsagent_t *agent,
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_SUCCESS;
     }
+    mapping_index_remove (agent, tmp);
     HASH_DEL (agent->mapping->map_elements, tmp);
     s_mapping_free_mapping_element (&tmp);
     agent->network_need_to_send_mapping_update = true;
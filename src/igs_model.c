@@ -84,6 +84,64 @@ void model_read_write_unlock (const char *function, int line)
     IGS_MUTEX_UNLOCK (s_model_read_write_mutex);
 }
 
+void model_agent_retain (igsagent_t *agent)
+{
+    assert (agent);
+    IGS_ATOMIC_ADD (agent->references, 1);
+}
+
+void model_agent_release (igsagent_t *agent)
+{
+    assert (agent);
+    if (IGS_ATOMIC_ADD (agent->references, -1) == 1) {
+        IGS_RWLOCK_DESTROY (agent->model_lock);
+        free (agent);
+    }
+}
+
+// Per-agent locks protecting IOP values and definition tables.
+// When both are needed, the global model mutex must be locked first.
+// Holding the lock keeps the agent alive. As igsagent_destroy clears the
+// agent uuid under the write lock, a thread that waited for the lock of
+// an agent destroyed meanwhile gets false and must not use it anymore.
+bool model_agent_read_lock (igsagent_t *agent)
+{
+    assert (agent);
+    model_agent_retain (agent);
+    IGS_RWLOCK_READ_LOCK (agent->model_lock);
+    if (agent->uuid)
+        return true;
+    IGS_RWLOCK_READ_UNLOCK (agent->model_lock);
+    model_agent_release (agent);
+    return false;
+}
+
+void model_agent_read_unlock (igsagent_t *agent)
+{
+    assert (agent);
+    IGS_RWLOCK_READ_UNLOCK (agent->model_lock);
+    model_agent_release (agent);
+}
+
+bool model_agent_write_lock (igsagent_t *agent)
+{
+    assert (agent);
+    model_agent_retain (agent);
+    IGS_RWLOCK_WRITE_LOCK (agent->model_lock);
+    if (agent->uuid)
+        return true;
+    IGS_RWLOCK_WRITE_UNLOCK (agent->model_lock);
+    model_agent_release (agent);
+    return false;
+}
+
+void model_agent_write_unlock (igsagent_t *agent)
+{
+    assert (agent);
+    IGS_RWLOCK_WRITE_UNLOCK (agent->model_lock);
+    model_agent_release (agent);
+}
+
 char *model_get_iop_value_as_string (igs_iop_t *iop)
 {
     assert (iop);
@@ -128,7 +186,187 @@ char *model_get_iop_value_as_string (igs_iop_t *iop)
     return str_value;
 }
 
-#define MAX_IOP_VALUE_LOG_BUFFER_LENGTH 256
+static igs_value_t *s_model_value_new (size_t capacity)
+{
+    igs_value_t *value = (igs_value_t *) zmalloc (sizeof (igs_value_t) + capacity);
+    value->refcount = 1;
+    value->capacity = capacity;
+    value->data = value->storage;
+    return value;
+}
+
+// Wraps a buffer allocated by the application, which is released with
+// the value
+static igs_value_t *s_model_value_adopt (void *data, size_t size, igs_data_free_fn *free_fn)
+{
+    igs_value_t *value = (igs_value_t *) zmalloc (sizeof (igs_value_t));
+    value->refcount = 1;
+    value->capacity = size;
+    value->data = (char *) data;
+    value->free_data = (free_fn) ? free_fn : free;
+    return value;
+}
+
+static igs_value_t *s_model_value_copy (const void *data, size_t size)
+{
+    igs_value_t *value = s_model_value_new (size);
+    memcpy (value->data, data, size);
+    return value;
+}
+
+void igs_value_release (igs_value_t **value)
+{
+    assert (value);
+    if (*value && IGS_REFCOUNT_DECREMENT ((*value)->refcount) == 0) {
+        if ((*value)->free_data)
+            (*value)->free_data ((*value)->data);
+        free (*value);
+    }
+    *value = NULL;
+}
+
+// Must be called with the agent lock held, in read or write mode
+igs_value_t *model_iop_value_share (const igs_iop_t *iop)
+{
+    assert (iop);
+    if ((iop->value_type != IGS_STRING_T && iop->value_type != IGS_DATA_T)
+        || iop->value.data == NULL)
+        return NULL;
+    if (iop->value_block) {
+        IGS_REFCOUNT_INCREMENT (iop->value_block->refcount);
+        return iop->value_block;
+    }
+    // inline values and values loaded from definitions are copied,
+    // strings loaded from definitions have no value_size
+    size_t size = (iop->value_type == IGS_STRING_T) ? strlen (iop->value.s) + 1
+                                                    : iop->value_size;
+    return s_model_value_copy (iop->value.data, size);
+}
+
+static void s_model_value_frame_destroy (void **hint)
+{
+    igs_value_release ((igs_value_t **) hint);
+}
+
+zframe_t *model_value_frame_new (igs_value_t *value, size_t size)
+{
+    assert (value);
+    assert (size <= value->capacity);
+    return zframe_frommem (value->data, size, s_model_value_frame_destroy, value);
+}
+
+void *model_iop_value_reserve (igs_iop_t *iop, size_t size)
+{
+    assert (iop);
+    // a block that has been borrowed is immutable: readers keep the old
+    // value and the new one goes to fresh storage
+    if (iop->value.data && size <= iop->value_capacity
+        && (iop->value_block == NULL
+            || IGS_REFCOUNT_GET (iop->value_block->refcount) == 1))
+        return iop->value.data;
+    model_iop_value_release (iop);
+    if (size <= IGS_IOP_INLINE_VALUE_SIZE) {
+        iop->value.data = iop->value_inline;
+        iop->value_capacity = IGS_IOP_INLINE_VALUE_SIZE;
+    }
+    else {
+        // some headroom so that values slowly growing in size
+        // do not reallocate on each write
+        size_t capacity = size + size / 4;
+        iop->value_block = s_model_value_new (capacity);
+        iop->value.data = iop->value_block->data;
+        iop->value_capacity = capacity;
+    }
+    return iop->value.data;
+}
+
+void model_iop_value_release (igs_iop_t *iop)
+{
+    assert (iop);
+    if (iop->value_block)
+        igs_value_release (&iop->value_block);
+    else if (iop->value.data && iop->value.data != (void *) iop->value_inline)
+        free (iop->value.data);
+    iop->value.data = NULL;
+    iop->value_capacity = 0;
+}
+
+// FNV-1a
+static uint64_t s_model_hash_bytes (const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *) data;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool model_iop_publication_is_unchanged (igs_iop_t *iop)
+{
+    assert (iop);
+    uint64_t value = 0;
+    size_t size = 0;
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            size = sizeof (int);
+            memcpy (&value, &iop->value.i, size);
+            break;
+        case IGS_DOUBLE_T:
+            size = sizeof (double);
+            memcpy (&value, &iop->value.d, size);
+            break;
+        case IGS_BOOL_T:
+            size = sizeof (bool);
+            memcpy (&value, &iop->value.b, size);
+            break;
+        case IGS_STRING_T:
+            size = (iop->value.s) ? strlen (iop->value.s) : 0;
+            value = s_model_hash_bytes (iop->value.s, size);
+            break;
+        case IGS_DATA_T:
+            size = (iop->value.data) ? iop->value_size : 0;
+            value = s_model_hash_bytes (iop->value.data, size);
+            break;
+        default:
+            // impulsions carry no value and are always published
+            return false;
+    }
+    bool unchanged = iop->has_published_value
+                     && iop->last_published_value == value
+                     && iop->last_published_size == size;
+    iop->last_published_value = value;
+    iop->last_published_size = size;
+    iop->has_published_value = true;
+    return unchanged;
+}
+
+static void s_model_set_string (igs_iop_t *iop, const char *str)
+{
+    size_t length = strlen (str) + 1;
+    memcpy (model_iop_value_reserve (iop, length), str, length);
+    iop->value_size = length;
+}
+
+static void s_model_set_data (igs_iop_t *iop, const void *data, size_t size)
+{
+    void *storage = model_iop_value_reserve (iop, size);
+    if (data && size > 0)
+        memcpy (storage, data, size);
+    iop->value_size = size;
+}
+
+// iop keeps a reference on adopted
+static void s_model_adopt_data (igs_iop_t *iop, igs_value_t *adopted)
+{
+    model_iop_value_release (iop);
+    IGS_REFCOUNT_INCREMENT (adopted->refcount);
+    iop->value_block = adopted;
+    iop->value.data = adopted->data;
+    iop->value_capacity = adopted->capacity;
+    iop->value_size = adopted->capacity;
+}
 
 void s_model_run_observe_callbacks_for_iop (igsagent_t *agent,
                                             igs_iop_t *iop,
@@ -143,29 +381,21 @@ void s_model_run_observe_callbacks_for_iop (igsagent_t *agent,
     }
 }
 
-const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
-                                  igs_iop_type_t type, igs_iop_value_type_t value_type,
-                                  void *value, size_t size)
+// Writes value into iop, which must have been resolved while holding
+// the agent write lock. The lock is released before observe callbacks
+// are run, whatever the outcome. Data written into a data IOP is adopted
+// rather than copied if adopted, the value wrapping it, is not NULL.
+static const igs_iop_t *s_model_write_iop_locked (igsagent_t *agent,
+                                                  igs_iop_t *iop,
+                                                  igs_iop_value_type_t value_type,
+                                                  void *value, size_t size,
+                                                  igs_value_t *adopted)
 {
-    assert (agent);
-    assert (name);
-    model_read_write_lock (__FUNCTION__, __LINE__);
-    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
-    if (!iop) {
-        igsagent_error (agent, "%s not found for writing", name);
-        model_read_write_unlock (__FUNCTION__, __LINE__);
-        return NULL;
-    }
     int ret = 1;
     void *out_value = NULL;
     size_t out_size = 0;
     char buf[NUMBER_TO_STRING_MAX_LENGTH + 1] = "";
-    // check that this agent has not been destroyed when we were locked
-    if (!agent || !(agent->uuid)) {
-        model_read_write_unlock (__FUNCTION__, __LINE__);
-        return NULL;
-    }
-    
+
     //apply constraint if any
     if (iop->constraint && agent->enforce_constraints){
         if (iop->value_type == IGS_INTEGER_T){
@@ -176,7 +406,7 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                     break;
                 case IGS_DATA_T:
                     igsagent_error(agent, "constraint type error for %s (value is data and IOP is integer)", iop->name);
-                    model_read_write_unlock (__FUNCTION__, __LINE__);
+                    model_agent_write_unlock (agent);
                     return NULL;
                 case IGS_DOUBLE_T:
                     converted_value = (int)(*(double*)value);
@@ -190,25 +420,25 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                 case IGS_CONSTRAINT_MIN:
                     if (converted_value < iop->constraint->min_int.min){
                         igsagent_error(agent, "constraint error for %s (too low)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
+                        model_agent_write_unlock (agent);
                         return NULL;
                     }
                     break;
                 case IGS_CONSTRAINT_MAX:
                     if (converted_value > iop->constraint->max_int.max){
                         igsagent_error(agent, "constraint error for %s (too high)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
+                        model_agent_write_unlock (agent);
                         return NULL;
                     }
                     break;
                 case IGS_CONSTRAINT_RANGE:
                     if (converted_value > iop->constraint->range_int.max){
                         igsagent_error(agent, "constraint error for %s (too high)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
+                        model_agent_write_unlock (agent);
                         return NULL;
                     }else if (converted_value < iop->constraint->range_int.min){
                         igsagent_error(agent, "constraint error for %s (too low)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
+                        model_agent_write_unlock (agent);
                         return NULL;
                     }
                     break;
@@ -224,7 +454,7 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                     break;
                 case IGS_DATA_T:
                     igsagent_error(agent, "constraint type error for %s (value is data and IOP is double)", iop->name);
-                    model_read_write_unlock (__FUNCTION__, __LINE__);
+                    model_agent_write_unlock (agent);
                     return NULL;
                 case IGS_INTEGER_T:
                 case IGS_BOOL_T:
@@ -239,25 +469,25 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                 case IGS_CONSTRAINT_MIN:
                     if (converted_value < iop->constraint->min_double.min){
                         igsagent_error(agent, "constraint error for %s (too low)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
+                        model_agent_write_unlock (agent);
                         return NULL;
                     }
                     break;
                 case IGS_CONSTRAINT_MAX:
                     if (converted_value > iop->constraint->max_double.max){
                         igsagent_error(agent, "constraint error for %s (too high)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
+                        model_agent_write_unlock (agent);
                         return NULL;
                     }
                     break;
                 case IGS_CONSTRAINT_RANGE:
                     if (converted_value > iop->constraint->range_double.max){
                         igsagent_error(agent, "constraint error for %s (too high)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
+                        model_agent_write_unlock (agent);
                         return NULL;
                     }else if (converted_value < iop->constraint->range_double.min){
                         igsagent_error(agent, "constraint error for %s (too low)", iop->name);
-                        model_read_write_unlock (__FUNCTION__, __LINE__);
+                        model_agent_write_unlock (agent);
                         return NULL;
                     }
                     break;
@@ -273,7 +503,7 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                     break;
                 case IGS_DATA_T:
                     igsagent_error(agent, "constraint type error for %s (value is data and IOP is string)", iop->name);
-                    model_read_write_unlock (__FUNCTION__, __LINE__);
+                    model_agent_write_unlock (agent);
                     return NULL;
                 case IGS_INTEGER_T:
                 case IGS_BOOL_T:
@@ -293,12 +523,12 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
             }
             if (!converted_value){
                 igsagent_error(agent, "constraint error for %s (value is NULL)", iop->name);
-                model_read_write_unlock (__FUNCTION__, __LINE__);
+                model_agent_write_unlock (agent);
                 return NULL;
             }
             if (!zrex_matches(iop->constraint->regexp.rex, converted_value)){
                 igsagent_error(agent, "constraint error for %s (not matching regexp)", iop->name);
-                model_read_write_unlock (__FUNCTION__, __LINE__);
+                model_agent_write_unlock (agent);
                 return NULL;
             }
         }
@@ -326,34 +556,27 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                     out_value = &(iop->value.b);
                     break;
                 case IGS_STRING_T: {
-                    if (iop->value.s)
-                        free (iop->value.s);
                     if (value == NULL)
-                        iop->value.s = strdup ("");
+                        s_model_set_string (iop, "");
                     else {
                         snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%d",
                                   (value == NULL) ? 0 : *(int *) (value));
-                        iop->value.s = strdup (buf);
+                        s_model_set_string (iop, buf);
                     }
-                    out_size = iop->value_size =
-                      (strlen (iop->value.s) + 1) * sizeof (char);
+                    out_size = iop->value_size;
                     out_value = iop->value.s;
                 } break;
                 case IGS_IMPULSION_T:
                     iop->value_size = 0;
                     break;
                 case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    iop->value.data = (void *) zmalloc (sizeof (int));
-                    memcpy (iop->value.data, value, sizeof (int));
-                    out_size = iop->value_size = sizeof (int);
+                    s_model_set_data (iop, value, sizeof (int));
+                    out_size = iop->value_size;
                     out_value = iop->value.data;
                 } break;
                 default:
                     igsagent_error (agent, "%s has an invalid value type %d",
-                                     name, iop->value_type);
+                                     iop->name, iop->value_type);
                     ret = 0;
                     break;
             }
@@ -381,34 +604,27 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                     out_value = &(iop->value.b);
                     break;
                 case IGS_STRING_T: {
-                    if (iop->value.s)
-                        free (iop->value.s);
                     if (value == NULL)
-                        iop->value.s = strdup ("");
+                        s_model_set_string (iop, "");
                     else {
                         snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%lf",
                                   (value == NULL) ? 0 : *(double *) (value));
-                        iop->value.s = strdup (buf);
+                        s_model_set_string (iop, buf);
                     }
-                    out_size = iop->value_size =
-                      (strlen (iop->value.s) + 1) * sizeof (char);
+                    out_size = iop->value_size;
                     out_value = iop->value.s;
                 } break;
                 case IGS_IMPULSION_T:
                     iop->value_size = 0;
                     break;
                 case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    iop->value.data = (void *) zmalloc (sizeof (double));
-                    memcpy (iop->value.data, value, sizeof (double));
-                    out_size = iop->value_size = sizeof (double);
+                    s_model_set_data (iop, value, sizeof (double));
+                    out_size = iop->value_size;
                     out_value = iop->value.data;
                 } break;
                 default:
                     igsagent_error(agent, "%s has an invalid value type %d",
-                                   name, iop->value_type);
+                                   iop->name, iop->value_type);
                     ret = 0;
                     break;
             }
@@ -431,34 +647,27 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                     out_value = &(iop->value.b);
                     break;
                 case IGS_STRING_T: {
-                    if (iop->value.s)
-                        free (iop->value.s);
                     if (value == NULL)
-                        iop->value.s = strdup ("");
+                        s_model_set_string (iop, "");
                     else {
                         snprintf (buf, NUMBER_TO_STRING_MAX_LENGTH + 1, "%d",
                                   (value == NULL) ? 0 : *(bool *) value);
-                        iop->value.s = strdup (buf);
+                        s_model_set_string (iop, buf);
                     }
-                    out_size = iop->value_size =
-                      (strlen (iop->value.s) + 1) * sizeof (char);
+                    out_size = iop->value_size;
                     out_value = iop->value.s;
                 } break;
                 case IGS_IMPULSION_T:
                     iop->value_size = 0;
                     break;
                 case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    iop->value.data = (void *) zmalloc (sizeof (bool));
-                    memcpy (iop->value.data, value, sizeof (bool));
-                    out_size = iop->value_size = sizeof (bool);
+                    s_model_set_data (iop, value, sizeof (bool));
+                    out_size = iop->value_size;
                     out_value = iop->value.data;
                 } break;
                 default:
                     igsagent_error(agent, "%s has an invalid value type %d",
-                                   name, iop->value_type);
+                                   iop->name, iop->value_type);
                     ret = 0;
                     break;
             }
@@ -494,42 +703,38 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                     out_value = &(iop->value.b);
                     break;
                 case IGS_STRING_T: {
-                    if (iop->value.s)
-                        free (iop->value.s);
                     if (value == NULL)
-                        iop->value.s = strdup ("");
+                        s_model_set_string (iop, "");
                     else
-                        iop->value.s = strdup ((char *) value);
-                    out_size = iop->value_size =
-                      (strlen (iop->value.s) + 1) * sizeof (char);
+                        s_model_set_string (iop, (char *) value);
+                    out_size = iop->value_size;
                     out_value = iop->value.s;
                 } break;
                 case IGS_IMPULSION_T:
                     iop->value_size = 0;
                     break;
                 case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    size_t s = 0;
                     if (value) {
                         uint8_t *converted = s_model_string_to_bytes (value);
                         if (converted){
-                            iop->value.data = converted;
-                            s = strlen (value) / 2;
+                            s_model_set_data (iop, converted, strlen (value) / 2);
+                            free (converted);
                         }else {
                             igs_error ("string %s is not a valid hexadecimal-encoded string",
                                        (char *) value);
-                            model_read_write_unlock (__FUNCTION__, __LINE__);
+                            model_agent_write_unlock (agent);
                             return NULL;
                         }
+                    }else {
+                        model_iop_value_release (iop);
+                        iop->value_size = 0;
                     }
-                    out_size = iop->value_size = s;
+                    out_size = iop->value_size;
                     out_value = iop->value.data;
                 } break;
                 default:
                     igsagent_error(agent, "%s has an invalid value type %d",
-                                   name, iop->value_type);
+                                   iop->name, iop->value_type);
                     ret = 0;
                     break;
             }
@@ -552,9 +757,7 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                     out_value = &(iop->value.b);
                     break;
                 case IGS_STRING_T: {
-                    if (iop->value.s)
-                        free (iop->value.s);
-                    iop->value.s = strdup ("");
+                    s_model_set_string (iop, "");
                     out_size = iop->value_size = sizeof (char);
                     out_value = iop->value.s;
                 } break;
@@ -562,14 +765,12 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                     iop->value_size = 0;
                     break;
                 case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
+                    model_iop_value_release (iop);
                     iop->value_size = 0;
                 } break;
                 default:
                     igsagent_error(agent, "%s has an invalid value type %d",
-                                   name, iop->value_type);
+                                   iop->name, iop->value_type);
                     ret = 0;
                     break;
             }
@@ -579,42 +780,41 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
                 case IGS_INTEGER_T:
                     igsagent_warn (
                       agent, "Raw data is not allowed into integer IOP %s",
-                      name);
+                      iop->name);
                     ret = 0;
                     break;
                 case IGS_DOUBLE_T:
                     igsagent_warn (
                       agent, "Raw data is not allowed into double IOP %s",
-                      name);
+                      iop->name);
                     ret = 0;
                     break;
                 case IGS_BOOL_T:
                     igsagent_warn (
                       agent, "Raw data is not allowed into boolean IOP %s",
-                      name);
+                      iop->name);
                     ret = 0;
                     break;
                 case IGS_STRING_T: {
                     igsagent_warn (
                       agent, "Raw data is not allowed into string IOP %s",
-                      name);
+                      iop->name);
                     ret = 0;
                 } break;
                 case IGS_IMPULSION_T:
                     iop->value_size = 0;
                     break;
                 case IGS_DATA_T: {
-                    if (iop->value.data)
-                        free (iop->value.data);
-                    iop->value.data = NULL;
-                    iop->value.data = (void *) zmalloc (size);
-                    memcpy (iop->value.data, value, size);
-                    out_size = iop->value_size = size;
+                    if (adopted)
+                        s_model_adopt_data (iop, adopted);
+                    else
+                        s_model_set_data (iop, value, size);
+                    out_size = iop->value_size;
                     out_value = iop->value.data;
                 } break;
                 default:
                     igsagent_error(agent, "%s has an invalid value type %d",
-                                   name, iop->value_type);
+                                   iop->name, iop->value_type);
                     ret = 0;
                     break;
             }
@@ -624,83 +824,96 @@ const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
     }
 
     if (ret) {
-        // compose log entry
-        const char *log_iop_type = NULL;
-        switch (type) {
-            case IGS_INPUT_T:
-                log_iop_type = "input";
-                break;
-            case IGS_OUTPUT_T:
-                log_iop_type = "output";
-                break;
-            case IGS_PARAMETER_T:
-                log_iop_type = "parameter";
-                break;
-            default:
-                break;
-        }
-        char log_iop_value_buffer[MAX_IOP_VALUE_LOG_BUFFER_LENGTH] = "";
-        char *log_iop_value = NULL;
-        switch (iop->value_type) {
-            case IGS_IMPULSION_T:
-                log_iop_value = strdup ("impulsion (no value)");
-                break;
-            case IGS_BOOL_T:
-                snprintf (log_iop_value_buffer, MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
-                          "bool %d", iop->value.b);
-                log_iop_value = strdup (log_iop_value_buffer);
-                break;
-            case IGS_INTEGER_T:
-                snprintf (log_iop_value_buffer, MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
-                          "int %d", iop->value.i);
-                log_iop_value = strdup (log_iop_value_buffer);
-                break;
-            case IGS_DOUBLE_T:
-                snprintf (log_iop_value_buffer, MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
-                          "double %f", iop->value.d);
-                log_iop_value = strdup (log_iop_value_buffer);
-                break;
-            case IGS_STRING_T:
-                log_iop_value = zmalloc ((strlen (iop->value.s) + strlen ("string ") + 1) * sizeof (char));
-                sprintf (log_iop_value, "string %s", iop->value.s);
-                break;
-            case IGS_DATA_T: {
-                if (core_context->enable_data_logging) {
-                    if (iop->value_size > 0) {
-                        zchunk_t *chunk = zchunk_new (iop->value.data, iop->value_size);
-                        char *hex_chunk = zchunk_strhex (chunk);
-                        log_iop_value = zmalloc ((strlen (hex_chunk) + strlen ("data ") + 1) * sizeof (char));
-                        sprintf (log_iop_value, "data %s", hex_chunk);
-                        free (hex_chunk);
-                        zchunk_destroy (&chunk);
-                    }
-                    else {
-                        log_iop_value = (void *) zmalloc ((strlen ("data 00") + 1) * sizeof (char));
-                        sprintf (log_iop_value, "data 00");
+        // log entry, composed only if some log output accepts it
+        if (admin_log_is_enabled (IGS_LOG_DEBUG)) {
+            const char *log_iop_type = NULL;
+            switch (iop->type) {
+                case IGS_INPUT_T:
+                    log_iop_type = "input";
+                    break;
+                case IGS_OUTPUT_T:
+                    log_iop_type = "output";
+                    break;
+                case IGS_PARAMETER_T:
+                    log_iop_type = "parameter";
+                    break;
+                default:
+                    break;
+            }
+            switch (iop->value_type) {
+                case IGS_IMPULSION_T:
+                    igsagent_debug (agent, "set %s %s to impulsion (no value)",
+                                    log_iop_type, iop->name);
+                    break;
+                case IGS_BOOL_T:
+                    igsagent_debug (agent, "set %s %s to bool %d",
+                                    log_iop_type, iop->name, iop->value.b);
+                    break;
+                case IGS_INTEGER_T:
+                    igsagent_debug (agent, "set %s %s to int %d",
+                                    log_iop_type, iop->name, iop->value.i);
+                    break;
+                case IGS_DOUBLE_T:
+                    igsagent_debug (agent, "set %s %s to double %f",
+                                    log_iop_type, iop->name, iop->value.d);
+                    break;
+                case IGS_STRING_T:
+                    igsagent_debug (agent, "set %s %s to string %s",
+                                    log_iop_type, iop->name, iop->value.s);
+                    break;
+                case IGS_DATA_T: {
+                    if (core_context->enable_data_logging) {
+                        if (iop->value_size > 0) {
+                            zchunk_t *chunk = zchunk_new (iop->value.data, iop->value_size);
+                            char *hex_chunk = zchunk_strhex (chunk);
+                            igsagent_debug (agent, "set %s %s to data %s",
+                                            log_iop_type, iop->name, hex_chunk);
+                            free (hex_chunk);
+                            zchunk_destroy (&chunk);
+                        }
+                        else
+                            igsagent_debug (agent, "set %s %s to data 00",
+                                            log_iop_type, iop->name);
                     }
-                }
-                else {
-                    snprintf (log_iop_value_buffer,
-                              MAX_IOP_VALUE_LOG_BUFFER_LENGTH,
-                              "data |size: %zu bytes", iop->value_size);
-                    log_iop_value = strdup (log_iop_value_buffer);
-                }
-            } break;
-            default:
-                break;
+                    else
+                        igsagent_debug (agent, "set %s %s to data |size: %zu bytes",
+                                        log_iop_type, iop->name, iop->value_size);
+                } break;
+                default:
+                    break;
+            }
         }
-        igsagent_debug (agent, "set %s %s to %s", log_iop_type, name,
-                        log_iop_value);
-        free (log_iop_value);
         
-        model_read_write_unlock (__FUNCTION__, __LINE__);
+        model_agent_write_unlock (agent);
         // handle iop callbacks
         s_model_run_observe_callbacks_for_iop (agent, iop, out_value, out_size);
     }else
-        model_read_write_unlock (__FUNCTION__, __LINE__);
+        model_agent_write_unlock (agent);
     return iop;
 }
 
+const igs_iop_t *model_write_iop (igsagent_t *agent, const char *name,
+                                  igs_iop_type_t type, igs_iop_value_type_t value_type,
+                                  void *value, size_t size)
+{
+    assert (agent);
+    assert (name);
+    // this agent may have been destroyed when we were waiting for the lock
+    if (!model_agent_write_lock (agent))
+        return NULL;
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (!iop) {
+        igsagent_error (agent, "%s not found for writing", name);
+        model_agent_write_unlock (agent);
+        return NULL;
+    }
+    // observe callbacks are run once the lock is released
+    model_agent_retain (agent);
+    const igs_iop_t *written = s_model_write_iop_locked (agent, iop, value_type, value, size, NULL);
+    model_agent_release (agent);
+    return written;
+}
+
 igs_iop_t *s_model_find_input_by_name (igsagent_t *agent, const char *name)
 {
     igs_iop_t *found = NULL;
@@ -766,25 +979,20 @@ void model_clear_iop (igsagent_t *agent, const char *name, igs_iop_type_t type)
 {
     assert (agent);
     assert (name);
+    if (!model_agent_write_lock (agent))
+        return;
     igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
-    if (!iop)
+    if (!iop) {
+        model_agent_write_unlock (agent);
         return;
+    }
     switch (iop->value_type) {
         case IGS_IMPULSION_T:
             break;
         case IGS_DATA_T:
-            if (iop->value.data) {
-                free (iop->value.data);
-                iop->value.data = NULL;
-                iop->value_size = 0;
-            }
-            break;
         case IGS_STRING_T:
-            if (iop->value.s) {
-                free (iop->value.s);
-                iop->value.s = NULL;
-                iop->value_size = 0;
-            }
+            model_iop_value_release (iop);
+            iop->value_size = 0;
             break;
         case IGS_DOUBLE_T:
             iop->value.d = 0;
@@ -801,6 +1009,7 @@ void model_clear_iop (igsagent_t *agent, const char *name, igs_iop_type_t type)
         default:
             break;
     }
+    model_agent_write_unlock (agent);
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -860,9 +1069,12 @@ igs_result_t s_read_iop (igsagent_t *agent,
                          void **value,
                          size_t *size)
 {
+    if (!model_agent_read_lock (agent))
+        return IGS_FAILURE;
     igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
     if (iop == NULL) {
         igsagent_error (agent, "%s not found", name);
+        model_agent_read_unlock (agent);
         return IGS_FAILURE;
     }
     if (iop->value_type == IGS_IMPULSION_T
@@ -877,6 +1089,7 @@ igs_result_t s_read_iop (igsagent_t *agent,
                 iop->value_size);
         *size = iop->value_size;
     }
+    model_agent_read_unlock (agent);
     return IGS_SUCCESS;
 }
 
@@ -910,42 +1123,35 @@ igs_result_t igsagent_parameter_buffer (igsagent_t *agent,
     return s_read_iop (agent, name, IGS_PARAMETER_T, value, size);
 }
 
-bool s_model_read_iop_as_bool (igsagent_t *agent,
-                               const char *name,
-                               igs_iop_type_t type)
+bool s_model_iop_as_bool (igsagent_t *agent, igs_iop_t *iop)
 {
     bool res = false;
-    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
-    if (iop == NULL) {
-        igsagent_error (agent, "%s not found", name);
-        return false;
-    }
     switch (iop->value_type) {
         case IGS_BOOL_T:
             res = iop->value.b;
             return res;
         case IGS_INTEGER_T:
             igsagent_warn (
-              agent, "Implicit conversion from int to bool for %s", name);
+              agent, "Implicit conversion from int to bool for %s", iop->name);
             res = (iop->value.i == 0) ? false : true;
             return res;
         case IGS_DOUBLE_T:
             igsagent_warn (
-              agent, "Implicit conversion from double to bool for %s", name);
+              agent, "Implicit conversion from double to bool for %s", iop->name);
             res = (iop->value.d >= 0 && iop->value.d <= 0) ? false : true;
             return res;
         case IGS_STRING_T:
             if (streq (iop->value.s, "true")) {
                 igsagent_warn (
                   agent, "Implicit conversion from string to bool for %s",
-                  name);
+                  iop->name);
                 return true;
             }
             else
             if (streq (iop->value.s, "false")) {
                 igsagent_warn (
                   agent, "Implicit conversion from string to bool for %s",
-                  name);
+                  iop->name);
                 return false;
             }
             else {
@@ -953,18 +1159,41 @@ bool s_model_read_iop_as_bool (igsagent_t *agent,
                   agent,
                   "Implicit conversion from double to bool for %s (string "
                   "value is %s and false was returned)",
-                  name, iop->value.s);
+                  iop->name, iop->value.s);
                 return false;
             }
         default:
             igsagent_error (
               agent,
               "No implicit conversion possible for %s (false was returned)",
-              name);
+              iop->name);
             return false;
     }
 }
 
+bool s_model_read_iop_as_bool_unlocked (igsagent_t *agent,
+                                        const char *name,
+                                        igs_iop_type_t type)
+{
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (iop == NULL) {
+        igsagent_error (agent, "%s not found", name);
+        return false;
+    }
+    return s_model_iop_as_bool (agent, iop);
+}
+
+bool s_model_read_iop_as_bool (igsagent_t *agent,
+                               const char *name,
+                               igs_iop_type_t type)
+{
+    if (!model_agent_read_lock (agent))
+        return false;
+    bool res = s_model_read_iop_as_bool_unlocked (agent, name, type);
+    model_agent_read_unlock (agent);
+    return res;
+}
+
 bool igsagent_input_bool (igsagent_t *agent, const char *name)
 {
     assert (agent);
@@ -972,20 +1201,13 @@ bool igsagent_input_bool (igsagent_t *agent, const char *name)
     return s_model_read_iop_as_bool (agent, name, IGS_INPUT_T);
 }
 
-int s_model_read_iop_as_int (igsagent_t *agent,
-                             const char *name,
-                             igs_iop_type_t type)
+int s_model_iop_as_int (igsagent_t *agent, igs_iop_t *iop)
 {
     int res = 0;
-    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
-    if (iop == NULL) {
-        igsagent_error (agent, "%s not found", name);
-        return 0;
-    }
     switch (iop->value_type) {
         case IGS_BOOL_T:
             igsagent_warn (
-              agent, "Implicit conversion from bool to int for %s", name);
+              agent, "Implicit conversion from bool to int for %s", iop->name);
             res = (iop->value.b) ? 1 : 0;
             return res;
         case IGS_INTEGER_T:
@@ -993,7 +1215,7 @@ int s_model_read_iop_as_int (igsagent_t *agent,
             return res;
         case IGS_DOUBLE_T:
             igsagent_warn (
-              agent, "Implicit conversion from double to int for %s", name);
+              agent, "Implicit conversion from double to int for %s", iop->name);
             if (iop->value.d < 0)
                 res = (int) (iop->value.d - 0.5);
             else
@@ -1002,17 +1224,40 @@ int s_model_read_iop_as_int (igsagent_t *agent,
         case IGS_STRING_T:
             igsagent_warn (agent,
                             "Implicit conversion from string %s to int for %s",
-                            iop->value.s, name);
+                            iop->value.s, iop->name);
             res = atoi (iop->value.s);
             return res;
         default:
             igsagent_error (
               agent, "No implicit conversion possible for %s (0 was returned)",
-              name);
+              iop->name);
             return 0;
     }
 }
 
+int s_model_read_iop_as_int_unlocked (igsagent_t *agent,
+                                      const char *name,
+                                      igs_iop_type_t type)
+{
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (iop == NULL) {
+        igsagent_error (agent, "%s not found", name);
+        return 0;
+    }
+    return s_model_iop_as_int (agent, iop);
+}
+
+int s_model_read_iop_as_int (igsagent_t *agent,
+                             const char *name,
+                             igs_iop_type_t type)
+{
+    if (!model_agent_read_lock (agent))
+        return 0;
+    int res = s_model_read_iop_as_int_unlocked (agent, name, type);
+    model_agent_read_unlock (agent);
+    return res;
+}
+
 int igsagent_input_int (igsagent_t *agent, const char *name)
 {
     assert (agent);
@@ -1020,25 +1265,18 @@ int igsagent_input_int (igsagent_t *agent, const char *name)
     return s_model_read_iop_as_int (agent, name, IGS_INPUT_T);
 }
 
-double s_model_read_iop_as_double (igsagent_t *agent,
-                                   const char *name,
-                                   igs_iop_type_t type)
+double s_model_iop_as_double (igsagent_t *agent, igs_iop_t *iop)
 {
     double res = 0;
-    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
-    if (iop == NULL) {
-        igsagent_error (agent, "%s not found", name);
-        return 0;
-    }
     switch (iop->value_type) {
         case IGS_BOOL_T:
             igsagent_warn (
-              agent, "Implicit conversion from bool to double for %s", name);
+              agent, "Implicit conversion from bool to double for %s", iop->name);
             res = (iop->value.b) ? 1 : 0;
             return res;
         case IGS_INTEGER_T:
             igsagent_warn (
-              agent, "Implicit conversion from int to double for %s", name);
+              agent, "Implicit conversion from int to double for %s", iop->name);
             res = iop->value.i;
             return res;
         case IGS_DOUBLE_T:
@@ -1047,17 +1285,40 @@ double s_model_read_iop_as_double (igsagent_t *agent,
         case IGS_STRING_T:
             igsagent_warn (
               agent, "Implicit conversion from string %s to double for %s",
-              iop->value.s, name);
+              iop->value.s, iop->name);
             res = atof (iop->value.s);
             return res;
         default:
             igsagent_error (
               agent, "No implicit conversion possible for %s (0 was returned)",
-              name);
+              iop->name);
             return 0;
     }
 }
 
+double s_model_read_iop_as_double_unlocked (igsagent_t *agent,
+                                            const char *name,
+                                            igs_iop_type_t type)
+{
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (iop == NULL) {
+        igsagent_error (agent, "%s not found", name);
+        return 0;
+    }
+    return s_model_iop_as_double (agent, iop);
+}
+
+double s_model_read_iop_as_double (igsagent_t *agent,
+                                   const char *name,
+                                   igs_iop_type_t type)
+{
+    if (!model_agent_read_lock (agent))
+        return 0;
+    double res = s_model_read_iop_as_double_unlocked (agent, name, type);
+    model_agent_read_unlock (agent);
+    return res;
+}
+
 double igsagent_input_double (igsagent_t *agent, const char *name)
 {
     assert (agent);
@@ -1083,11 +1344,11 @@ char *s_model_double_to_string (const double value)
     char *str = (char *) zmalloc (length + 1);
     snprintf (str, length + 1, "%lf", value);
     return str;
-}
-
-char *s_model_read_iop_as_string (igsagent_t *agent,
-                                  const char *name,
-                                  igs_iop_type_t type)
+}
+
+char *s_model_read_iop_as_string_unlocked (igsagent_t *agent,
+                                           const char *name,
+                                           igs_iop_type_t type)
 {
     char *res = NULL;
     igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
@@ -1123,6 +1384,17 @@ char *s_model_read_iop_as_string (igsagent_t *agent,
     }
 }
 
+char *s_model_read_iop_as_string (igsagent_t *agent,
+                                  const char *name,
+                                  igs_iop_type_t type)
+{
+    if (!model_agent_read_lock (agent))
+        return NULL;
+    char *res = s_model_read_iop_as_string_unlocked (agent, name, type);
+    model_agent_read_unlock (agent);
+    return res;
+}
+
 char *igsagent_input_string (igsagent_t *agent, const char *name)
 {
     assert (agent);
@@ -1139,11 +1411,14 @@ igs_result_t s_model_read_iop_as_data (igsagent_t *agent,
     assert (agent);
     assert (value);
     assert (size);
+    *value = NULL;
+    *size = 0;
+    if (!model_agent_read_lock (agent))
+        return IGS_FAILURE;
     igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
     if (iop == NULL) {
         igsagent_error (agent, "%s not found", name);
-        *value = NULL;
-        *size = 0;
+        model_agent_read_unlock (agent);
         return IGS_FAILURE;
     }
     if (iop->value_type == IGS_IMPULSION_T || iop->value_type == IGS_UNKNOWN_T
@@ -1155,6 +1430,7 @@ igs_result_t s_model_read_iop_as_data (igsagent_t *agent,
         *value = (void *) zmalloc (iop->value_size);
         memcpy (*value, s_model_get_value_for (agent, name, type), *size);
     }
+    model_agent_read_unlock (agent);
     return IGS_SUCCESS;
 }
 
@@ -1260,6 +1536,118 @@ igs_result_t igsagent_parameter_data (igsagent_t *agent,
     return s_model_read_iop_as_data (agent, name, IGS_PARAMETER_T, data, size);
 }
 
+static igs_result_t s_model_borrow_iop (igsagent_t *agent,
+                                        const char *name,
+                                        igs_iop_type_t type,
+                                        bool as_string,
+                                        const void **data,
+                                        size_t *size,
+                                        igs_value_t **token)
+{
+    assert (agent);
+    assert (name);
+    assert (data);
+    assert (size);
+    assert (token);
+    *data = NULL;
+    *size = 0;
+    *token = NULL;
+    if (!model_agent_read_lock (agent))
+        return IGS_FAILURE;
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (iop == NULL) {
+        igsagent_error (agent, "%s not found", name);
+        model_agent_read_unlock (agent);
+        return IGS_FAILURE;
+    }
+    if (iop->value_type == IGS_STRING_T
+        || (!as_string && iop->value_type == IGS_DATA_T)) {
+        // large values are shared as is, the next write will
+        // allocate new storage instead of modifying this one
+        *token = model_iop_value_share (iop);
+        if (*token) {
+            *data = (*token)->data;
+            *size = (*token == iop->value_block) ? iop->value_size
+                                                 : (*token)->capacity;
+        }
+    }
+    else if (as_string) {
+        char *str = s_model_read_iop_as_string_unlocked (agent, name, type);
+        if (str) {
+            *token = s_model_value_copy (str, strlen (str) + 1);
+            *data = (*token)->data;
+            *size = (*token)->capacity;
+            free (str);
+        }
+    }
+    else if (iop->value_type != IGS_IMPULSION_T
+             && iop->value_type != IGS_UNKNOWN_T) {
+        *token = s_model_value_copy (s_model_get_value_for (agent, name, type),
+                                     iop->value_size);
+        *data = (*token)->data;
+        *size = iop->value_size;
+    }
+    model_agent_read_unlock (agent);
+    return IGS_SUCCESS;
+}
+
+igs_result_t igsagent_input_data_borrow (igsagent_t *agent,
+                                         const char *name,
+                                         const void **data,
+                                         size_t *size,
+                                         igs_value_t **token)
+{
+    return s_model_borrow_iop (agent, name, IGS_INPUT_T, false, data, size, token);
+}
+
+igs_result_t igsagent_input_string_borrow (igsagent_t *agent,
+                                           const char *name,
+                                           const char **value,
+                                           igs_value_t **token)
+{
+    size_t size = 0;
+    return s_model_borrow_iop (agent, name, IGS_INPUT_T, true,
+                               (const void **) value, &size, token);
+}
+
+igs_result_t igsagent_output_data_borrow (igsagent_t *agent,
+                                          const char *name,
+                                          const void **data,
+                                          size_t *size,
+                                          igs_value_t **token)
+{
+    return s_model_borrow_iop (agent, name, IGS_OUTPUT_T, false, data, size, token);
+}
+
+igs_result_t igsagent_output_string_borrow (igsagent_t *agent,
+                                            const char *name,
+                                            const char **value,
+                                            igs_value_t **token)
+{
+    size_t size = 0;
+    return s_model_borrow_iop (agent, name, IGS_OUTPUT_T, true,
+                               (const void **) value, &size, token);
+}
+
+igs_result_t igsagent_parameter_data_borrow (igsagent_t *agent,
+                                             const char *name,
+                                             const void **data,
+                                             size_t *size,
+                                             igs_value_t **token)
+{
+    return s_model_borrow_iop (agent, name, IGS_PARAMETER_T, false, data, size, token);
+}
+
+igs_result_t igsagent_parameter_string_borrow (igsagent_t *agent,
+                                               const char *name,
+                                               const char **value,
+                                               igs_value_t **token)
+{
+    size_t size = 0;
+    return s_model_borrow_iop (agent, name, IGS_PARAMETER_T, true,
+                               (const void **) value, &size, token);
+}
+
 // --------------------------------  WRITE
 // ------------------------------------//
 
@@ -1322,28 +1710,37 @@ igs_result_t igsagent_input_set_data (igsagent_t *agent,
     return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
 }
 
-igs_result_t
-igsagent_output_set_bool (igsagent_t *agent, const char *name, bool value)
+// Writes and publishes an output, the agent being kept alive until its
+// publication even if it is destroyed meanwhile
+static igs_result_t s_model_write_output (igsagent_t *agent,
+                                          const char *name,
+                                          igs_iop_value_type_t value_type,
+                                          void *value,
+                                          size_t size)
 {
-    assert (agent);
-    assert (name);
+    model_agent_retain (agent);
     const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T,
-                                            IGS_BOOL_T, &value, sizeof (bool));
+                                            value_type, value, size);
     if (iop)
         network_publish_output (agent, iop);
+    model_agent_release (agent);
     return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
 }
 
+igs_result_t
+igsagent_output_set_bool (igsagent_t *agent, const char *name, bool value)
+{
+    assert (agent);
+    assert (name);
+    return s_model_write_output (agent, name, IGS_BOOL_T, &value, sizeof (bool));
+}
+
 igs_result_t
 igsagent_output_set_int (igsagent_t *agent, const char *name, int value)
 {
     assert (agent);
     assert (name);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T,
-                                            IGS_INTEGER_T, &value, sizeof (int));
-    if (iop)
-        network_publish_output (agent, iop);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return s_model_write_output (agent, name, IGS_INTEGER_T, &value, sizeof (int));
 }
 
 igs_result_t
@@ -1351,11 +1748,7 @@ igsagent_output_set_double (igsagent_t *agent, const char *name, double value)
 {
     assert (agent);
     assert (name);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T,
-                                            IGS_DOUBLE_T, &value, sizeof (double));
-    if (iop)
-        network_publish_output (agent, iop);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return s_model_write_output (agent, name, IGS_DOUBLE_T, &value, sizeof (double));
 }
 
 igs_result_t igsagent_output_set_string (igsagent_t *agent,
@@ -1365,11 +1758,7 @@ igs_result_t igsagent_output_set_string (igsagent_t *agent,
     assert (agent);
     assert (name);
     size_t length = (value == NULL) ? 0 : strlen (value) + 1;
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T,
-                                            IGS_STRING_T, (char *) value, length);
-    if (iop)
-        network_publish_output (agent, iop);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return s_model_write_output (agent, name, IGS_STRING_T, (char *) value, length);
 }
 
 igs_result_t igsagent_output_set_impulsion (igsagent_t *agent,
@@ -1377,10 +1766,7 @@ igs_result_t igsagent_output_set_impulsion (igsagent_t *agent,
 {
     assert (agent);
     assert (name);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T, IGS_IMPULSION_T, NULL, 0);
-    if (iop)
-        network_publish_output (agent, iop);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return s_model_write_output (agent, name, IGS_IMPULSION_T, NULL, 0);
 }
 
 igs_result_t igsagent_output_set_data (igsagent_t *agent,
@@ -1390,9 +1776,37 @@ igs_result_t igsagent_output_set_data (igsagent_t *agent,
 {
     assert (agent);
     assert (name);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T, IGS_DATA_T, value, size);
+    return s_model_write_output (agent, name, IGS_DATA_T, value, size);
+}
+
+igs_result_t igsagent_output_set_data_owned (igsagent_t *agent,
+                                              const char *name,
+                                              void *value,
+                                              size_t size,
+                                              igs_data_free_fn *free_fn)
+{
+    assert (agent);
+    assert (name);
+    if (value == NULL)
+        return igsagent_output_set_data (agent, name, NULL, size);
+    // released below, the output keeping its own reference if it adopts it
+    igs_value_t *adopted = s_model_value_adopt (value, size, free_fn);
+    const igs_iop_t *iop = NULL;
+    // observe callbacks and publication happen once the lock is released
+    model_agent_retain (agent);
+    if (model_agent_write_lock (agent)) {
+        igs_iop_t *output = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+        if (!output) {
+            igsagent_error (agent, "%s not found for writing", name);
+            model_agent_write_unlock (agent);
+        }
+        else
+            iop = s_model_write_iop_locked (agent, output, IGS_DATA_T, value, size, adopted);
+    }
     if (iop)
         network_publish_output (agent, iop);
+    model_agent_release (agent);
+    igs_value_release (&adopted);
     return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
 }
 
@@ -1405,11 +1819,37 @@ igsagent_output_set_zmsg (igsagent_t *agent, const char *name, zmsg_t *msg)
     zframe_t *frame = zmsg_encode (msg);
     void *value = zframe_data (frame);
     size_t size = zframe_size (frame);
-    const igs_iop_t *iop = model_write_iop (agent, name, IGS_OUTPUT_T, IGS_DATA_T, value, size);
-    if (iop)
-        network_publish_output (agent, iop);
+    igs_result_t result = s_model_write_output (agent, name, IGS_DATA_T, value, size);
     zframe_destroy (&frame);
-    return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+    return result;
+}
+
+igs_result_t igsagent_outputs_begin (igsagent_t *agent)
+{
+    assert (agent);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    if (agent->outputs_batch) {
+        igsagent_error (agent, "outputs batch already started");
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    agent->outputs_batch = network_publication_new ();
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+igs_result_t igsagent_outputs_commit (igsagent_t *agent)
+{
+    assert (agent);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_publication_t *batch = agent->outputs_batch;
+    agent->outputs_batch = NULL;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    if (!batch) {
+        igsagent_error (agent, "no outputs batch to commit");
+        return IGS_FAILURE;
+    }
+    return network_publish_outputs_batch (agent, &batch);
 }
 
 igs_result_t
@@ -1467,6 +1907,182 @@ igs_result_t igsagent_parameter_set_data (igsagent_t *agent,
     return (iop == NULL) ? IGS_FAILURE : IGS_SUCCESS;
 }
 
+// ------------------------------------//
+
+igs_iop_handle_t *s_model_new_handle (igsagent_t *agent,
+                                      const char *name,
+                                      igs_iop_type_t type)
+{
+    assert (agent);
+    assert (name);
+    if (!model_agent_read_lock (agent))
+        return NULL;
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, type);
+    if (iop == NULL) {
+        igsagent_error (agent, "%s not found", name);
+        model_agent_read_unlock (agent);
+        return NULL;
+    }
+    igs_iop_handle_t *handle = (igs_iop_handle_t *) zmalloc (sizeof (igs_iop_handle_t));
+    handle->agent = agent;
+    handle->name = strdup (name);
+    handle->type = type;
+    handle->iop = (igs_atomic_t) (intptr_t) iop;
+    handle->generation = (igs_atomic_t) agent->definition_generation;
+    model_agent_read_unlock (agent);
+    return handle;
+}
+
+// Returns the IOP behind the handle, resolving it again by name if the
+// definition changed since the last use. Must be called with the agent
+// lock held, in read or write mode, so that the definition cannot change
+// meanwhile. Threads sharing the read lock may resolve the handle at the
+// same time : they find the same IOP, stored before the generation so that
+// a current generation always comes with its IOP.
+static igs_iop_t *s_model_resolve_handle (igs_iop_handle_t *handle)
+{
+    igsagent_t *agent = handle->agent;
+    igs_atomic_t generation = (igs_atomic_t) agent->definition_generation;
+    if (IGS_ATOMIC_LOAD (handle->generation) == generation)
+        return (igs_iop_t *) (intptr_t) IGS_ATOMIC_LOAD (handle->iop);
+    igs_iop_t *iop = model_find_iop_by_name (agent, handle->name, handle->type);
+    IGS_ATOMIC_STORE (handle->iop, (igs_atomic_t) (intptr_t) iop);
+    IGS_ATOMIC_STORE (handle->generation, generation);
+    return iop;
+}
+
+igs_iop_handle_t *igsagent_input_handle (igsagent_t *agent, const char *name)
+{
+    return s_model_new_handle (agent, name, IGS_INPUT_T);
+}
+
+igs_iop_handle_t *igsagent_output_handle (igsagent_t *agent, const char *name)
+{
+    return s_model_new_handle (agent, name, IGS_OUTPUT_T);
+}
+
+igs_iop_handle_t *igsagent_parameter_handle (igsagent_t *agent, const char *name)
+{
+    return s_model_new_handle (agent, name, IGS_PARAMETER_T);
+}
+
+void igs_iop_handle_destroy (igs_iop_handle_t **handle)
+{
+    assert (handle);
+    if (*handle) {
+        free ((*handle)->name);
+        free (*handle);
+        *handle = NULL;
+    }
+}
+
+bool igs_iop_bool_h (igs_iop_handle_t *handle)
+{
+    assert (handle);
+    bool res = false;
+    if (!model_agent_read_lock (handle->agent))
+        return res;
+    igs_iop_t *iop = s_model_resolve_handle (handle);
+    if (iop)
+        res = s_model_iop_as_bool (handle->agent, iop);
+    else
+        igsagent_error (handle->agent, "%s not found", handle->name);
+    model_agent_read_unlock (handle->agent);
+    return res;
+}
+
+int igs_iop_int_h (igs_iop_handle_t *handle)
+{
+    assert (handle);
+    int res = 0;
+    if (!model_agent_read_lock (handle->agent))
+        return res;
+    igs_iop_t *iop = s_model_resolve_handle (handle);
+    if (iop)
+        res = s_model_iop_as_int (handle->agent, iop);
+    else
+        igsagent_error (handle->agent, "%s not found", handle->name);
+    model_agent_read_unlock (handle->agent);
+    return res;
+}
+
+double igs_iop_double_h (igs_iop_handle_t *handle)
+{
+    assert (handle);
+    double res = 0;
+    if (!model_agent_read_lock (handle->agent))
+        return res;
+    igs_iop_t *iop = s_model_resolve_handle (handle);
+    if (iop)
+        res = s_model_iop_as_double (handle->agent, iop);
+    else
+        igsagent_error (handle->agent, "%s not found", handle->name);
+    model_agent_read_unlock (handle->agent);
+    return res;
+}
+
+igs_result_t s_model_output_set_with_handle (igs_iop_handle_t *handle,
+                                             igs_iop_value_type_t value_type,
+                                             void *value,
+                                             size_t size)
+{
+    assert (handle);
+    igsagent_t *agent = handle->agent;
+    if (handle->type != IGS_OUTPUT_T) {
+        igsagent_error (agent, "%s is not an output", handle->name);
+        return IGS_FAILURE;
+    }
+    // observe callbacks and publication happen once the lock is released
+    model_agent_retain (agent);
+    if (!model_agent_write_lock (agent)) {
+        model_agent_release (agent);
+        return IGS_FAILURE;
+    }
+    igs_iop_t *iop = s_model_resolve_handle (handle);
+    if (!iop) {
+        igsagent_error (agent, "%s not found for writing", handle->name);
+        model_agent_write_unlock (agent);
+        model_agent_release (agent);
+        return IGS_FAILURE;
+    }
+    const igs_iop_t *written = s_model_write_iop_locked (agent, iop, value_type, value, size, NULL);
+    if (written)
+        network_publish_output (agent, written);
+    model_agent_release (agent);
+    return (written == NULL) ? IGS_FAILURE : IGS_SUCCESS;
+}
+
+igs_result_t igs_output_set_bool_h (igs_iop_handle_t *handle, bool value)
+{
+    return s_model_output_set_with_handle (handle, IGS_BOOL_T, &value, sizeof (bool));
+}
+
+igs_result_t igs_output_set_int_h (igs_iop_handle_t *handle, int value)
+{
+    return s_model_output_set_with_handle (handle, IGS_INTEGER_T, &value, sizeof (int));
+}
+
+igs_result_t igs_output_set_double_h (igs_iop_handle_t *handle, double value)
+{
+    return s_model_output_set_with_handle (handle, IGS_DOUBLE_T, &value, sizeof (double));
+}
+
+igs_result_t igs_output_set_string_h (igs_iop_handle_t *handle, const char *value)
+{
+    size_t length = (value == NULL) ? 0 : strlen (value) + 1;
+    return s_model_output_set_with_handle (handle, IGS_STRING_T, (char *) value, length);
+}
+
+igs_result_t igs_output_set_impulsion_h (igs_iop_handle_t *handle)
+{
+    return s_model_output_set_with_handle (handle, IGS_IMPULSION_T, NULL, 0);
+}
+
+igs_result_t igs_output_set_data_h (igs_iop_handle_t *handle, void *value, size_t size)
+{
+    return s_model_output_set_with_handle (handle, IGS_DATA_T, value, size);
+}
+
 igs_constraint_t* s_model_parse_constraint(igs_iop_value_type_t type,
                                            const char *expression,char **error){
     assert(expression);
@@ -2038,3 +2654,102 @@ bool igsagent_output_is_muted (igsagent_t *agent, const char *name)
     }
     return iop->is_muted;
 }
+
+void igsagent_output_set_publish_on_change (igsagent_t *agent,
+                                            const char *name,
+                                            bool on_change_only)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        igsagent_error (agent, "Output '%s' not found", name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return;
+    }
+    iop->publish_on_change_only = on_change_only;
+    iop->has_published_value = false;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+}
+
+bool igsagent_output_publish_on_change (igsagent_t *agent, const char *name)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        igsagent_warn (agent, "Output '%s' not found", name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return false;
+    }
+    bool res = iop->publish_on_change_only;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return res;
+}
+
+size_t igsagent_output_suppressed_publications (igsagent_t *agent,
+                                                const char *name)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        igsagent_warn (agent, "Output '%s' not found", name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return 0;
+    }
+    size_t res = iop->suppressed_publications;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return res;
+}
+
+igs_result_t igsagent_output_set_max_rate (igsagent_t *agent,
+                                           const char *name,
+                                           double max_rate)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        igsagent_error (agent, "Output '%s' not found", name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_FAILURE;
+    }
+    iop->publication_period = (max_rate > 0) ? (int64_t) (1000000.0 / max_rate) : 0;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return IGS_SUCCESS;
+}
+
+double igsagent_output_max_rate (igsagent_t *agent, const char *name)
+{
+    assert (agent);
+    assert (name);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_iop_t *iop = model_find_iop_by_name (agent, name, IGS_OUTPUT_T);
+    if (iop == NULL) {
+        igsagent_warn (agent, "Output '%s' not found", name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return 0;
+    }
+    double res = (iop->publication_period > 0) ? 1000000.0 / (double) iop->publication_period : 0;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return res;
+}
+
+size_t igsagent_suppressed_publications (igsagent_t *agent)
+{
+    assert (agent);
+    size_t res = 0;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    if (agent->definition) {
+        igs_iop_t *iop, *tmp;
+        HASH_ITER (hh, agent->definition->outputs_table, iop, tmp)
+            res += iop->suppressed_publications;
+    }
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return res;
+}
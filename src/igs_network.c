@@ -72,41 +72,559 @@ PIP_ADAPTER_UNICAST_ADDRESS p_unicast = NULL;
 
 #define IGS_DEFAULT_SECURITY_DIRECTORY "*"
 
+// Topic of publications carrying several outputs of an agent, i.e.
+// "<agent uuid>*", followed by name/type/value triplets. It does not
+// share any prefix with the "<agent uuid>-<output name>" topics.
+#define PUBLICATION_BATCH_SUFFIX "*"
+
+// Protocol v5 publications replace these textual topics and the decimal
+// type frames with a compact binary header:
+// - topic: PUBLICATION_V5_MARKER, then the 64-bit id of the textual topic,
+// - output header: the 64-bit id of the output topic, then its type byte,
+// possibly followed by an 8-byte sequence number if the type byte has
+// PUBLICATION_V5_SEQUENCE set.
+// A single output is sent as its topic directly followed by its type byte
+// and sequence, then its value. A batch is sent as its topic, then output
+// header/value pairs. Ids are big endian. The marker cannot start a
+// textual topic, so that filters of both protocols never overlap.
+#define PUBLICATION_V5_PROTOCOL 5
+#define PUBLICATION_V5_MARKER 0x05
+#define PUBLICATION_V5_TOPIC_LENGTH 9
+#define PUBLICATION_V5_HEADER_LENGTH 9
+#define PUBLICATION_V5_SEQUENCE 0x80
+
+// Agents reading our shared-memory ring subscribe on our ipc publisher to
+// the protocol v5 topics they want, with this marker instead of
+// PUBLICATION_V5_MARKER. We write the matching publications in the ring,
+// or send them on the ipc publisher with this marker if they do not fit,
+// followed by their number, which a placeholder in the ring also holds.
+#define PUBLICATION_SHM_MARKER 0x06
+
+// Protocol version announced by a peer in its zyre headers, 0 if none
+static int s_peer_protocol (igs_zyre_peer_t *peer)
+{
+    if (peer == NULL || peer->protocol == NULL || peer->protocol[0] != 'v')
+        return 0;
+    return atoi (peer->protocol + 1);
+}
+
+// 64-bit FNV-1a hash of a textual topic, used as its protocol v5 id
+static uint64_t s_topic_id (const char *topic)
+{
+    uint64_t id = 14695981039346656037ULL;
+    for (const byte *c = (const byte *) topic; *c; c++) {
+        id ^= *c;
+        id *= 1099511628211ULL;
+    }
+    return id;
+}
+
+static void s_write_topic_id (byte *buffer, uint64_t id)
+{
+    for (int i = 7; i >= 0; i--) {
+        buffer[i] = (byte) (id & 0xff);
+        id >>= 8;
+    }
+}
+
+static uint64_t s_read_topic_id (const byte *buffer)
+{
+    uint64_t id = 0;
+    for (int i = 0; i < 8; i++)
+        id = (id << 8) | buffer[i];
+    return id;
+}
+
+static void s_write_compact_topic (byte *buffer, uint64_t id)
+{
+    buffer[0] = PUBLICATION_V5_MARKER;
+    s_write_topic_id (buffer + 1, id);
+}
+
 #ifndef W_OK
 #define W_OK 02
 #endif
 
-// Removes filter to 'subscribe' socket for a spectific output of a given remote
-// agent
-//FIXME UNUSED
-void s_unsubscribe_to_remote_agent_output (igs_remote_agent_t *remote_agent,
-                                           const char *output_name)
+// Queues are bounded multi-producer queues, in which each cell holds a
+// sequence telling producers and the consumer whether it is free or filled
+// for their current position.
+static igs_queue_t *s_queue_new (size_t size)
 {
-    assert (remote_agent);
-    assert (output_name);
-    if (strlen (output_name) > 0) {
-        igs_mapping_filter_t *filter = NULL;
-        DL_FOREACH (remote_agent->mapping_filters, filter)
-        {
-            if (streq (filter->filter, output_name)) {
-                assert (remote_agent->peer->subscriber);
-                igs_debug ("unsubscribe to agent %s output %s",
-                           remote_agent->definition->name, output_name);
-                zsock_set_unsubscribe (remote_agent->peer->subscriber,
-                                       output_name);
-                free (filter->filter);
-                DL_DELETE (remote_agent->mapping_filters, filter);
-                free (filter);
+    int64_t capacity = 2;
+    while ((size_t) capacity < size)
+        capacity *= 2;
+    igs_queue_t *queue = (igs_queue_t *) zmalloc (sizeof (igs_queue_t));
+    queue->cells = (igs_queued_item_t *) zmalloc ((size_t) capacity * sizeof (igs_queued_item_t));
+    queue->mask = capacity - 1;
+    for (int64_t i = 0; i < capacity; i++)
+        IGS_ATOMIC_STORE (queue->cells[i].sequence, i);
+    return queue;
+}
+
+// Returns false if the queue is full
+static bool s_queue_push (igs_queue_t *queue, void *item, int flags)
+{
+    int64_t position = IGS_ATOMIC_LOAD (queue->enqueue_position);
+    igs_queued_item_t *cell = NULL;
+    while (true) {
+        cell = &queue->cells[position & queue->mask];
+        int64_t difference = IGS_ATOMIC_LOAD (cell->sequence) - position;
+        if (difference == 0) {
+            if (IGS_ATOMIC_CAS (queue->enqueue_position, position, position + 1))
                 break;
-            }
         }
+        else if (difference < 0)
+            return false;
+        position = IGS_ATOMIC_LOAD (queue->enqueue_position);
     }
+    cell->item = item;
+    cell->flags = flags;
+    IGS_ATOMIC_STORE (cell->sequence, position + 1);
+    return true;
+}
+
+// Returns NULL if the queue is empty. Only used by the consumer thread.
+static void *s_queue_pop (igs_queue_t *queue, int *flags)
+{
+    int64_t position = IGS_ATOMIC_LOAD (queue->dequeue_position);
+    igs_queued_item_t *cell = &queue->cells[position & queue->mask];
+    if (IGS_ATOMIC_LOAD (cell->sequence) != position + 1)
+        return NULL;
+    void *item = cell->item;
+    *flags = cell->flags;
+    IGS_ATOMIC_STORE (queue->dequeue_position, position + 1);
+    IGS_ATOMIC_STORE (cell->sequence, position + queue->mask + 1);
+    return item;
+}
+
+static size_t s_queue_depth (igs_queue_t *queue)
+{
+    int64_t depth = IGS_ATOMIC_LOAD (queue->enqueue_position)
+                    - IGS_ATOMIC_LOAD (queue->dequeue_position);
+    return (depth > 0) ? (size_t) depth : 0;
+}
+
+// Queue must have been emptied by its consumer
+static void s_queue_destroy (igs_queue_t **queue)
+{
+    assert (queue);
+    if (*queue == NULL)
+        return;
+    free ((*queue)->cells);
+    free (*queue);
+    *queue = NULL;
 }
 
 ////////////////////////////////////////////////////////////////////////
 // ZMQ callbacks
 ////////////////////////////////////////////////////////////////////////
 
+// Publications of our peers are received by the receiver threads, so that
+// parsing definitions and mappings on the network thread does not delay
+// them. The network thread creates the subscriber sockets and shm readers
+// of our peers, then hands them over to the receiver thread of each peer
+// through its queue, with these commands applied in order.
+#define RECEIVER_ADD_SUBSCRIBER 1 //starts reading a subscriber socket
+#define RECEIVER_ADD_SHM_READER 2 //starts reading a shm reader
+#define RECEIVER_REMOVE_PEER 3 //destroys the subscriber and shm reader of a peer
+#define RECEIVER_SUBSCRIBE 4
+#define RECEIVER_UNSUBSCRIBE 5
+#define RECEIVER_SET_AGENT 6 //adds or renames a remote agent
+#define RECEIVER_REMOVE_AGENT 7 //removes a remote agent and its topics
+#define RECEIVER_ADD_TOPIC 8 //adds a protocol v5 topic of a remote agent
+#define RECEIVER_SET_HWM 9 //sets the HWM of the subscriber sockets of a receiver
+
+#define RECEIVER_QUEUE_SIZE 1024
+
+typedef struct igs_receiver_command {
+    int type;
+    zsock_t *subscriber;
+    igs_shm_reader_t *shm_reader;
+    char uuid[IGS_AGENT_UUID_LENGTH + 1];
+    char *text; //filter, agent name or output name
+    size_t length; //of the filter
+    uint64_t topic_id;
+    int hwm;
+} igs_receiver_command_t;
+
+// remote agent as known by the receiver thread
+typedef struct igs_receiver_agent {
+    char uuid[IGS_AGENT_UUID_LENGTH + 1];
+    char *name;
+    UT_hash_handle hh;
+} igs_receiver_agent_t;
+
+// protocol v5 topic as known by the receiver thread
+typedef struct igs_receiver_topic {
+    uint64_t id;
+    igs_receiver_agent_t *agent;
+    char *output_name; //NULL for batches
+    UT_hash_handle hh;
+} igs_receiver_topic_t;
+
+// state of a receiver thread, only used by it
+typedef struct igs_receiver {
+    igs_core_context_t *context;
+    igs_queue_t *queue;
+    igs_loop_t *loop;
+    zlist_t *subscribers;
+    zlist_t *rings; //igs_receiver_ring_t
+    igs_receiver_agent_t *agents;
+    igs_receiver_topic_t *topics;
+} igs_receiver_t;
+
+// Publications of a peer with a shm ring come through the ring, except the
+// ones too large for it, which come through our subscriber. The publisher
+// then writes a placeholder in the ring, with the shm marker and the
+// number of the publication, which the IPC publication carries after its
+// topic. Ring publications are held from the placeholder until the IPC
+// publication arrives, so that the publications of the peer are written
+// to our inputs in the order it made them.
+#define RECEIVER_FALLBACK_TIMEOUT 100 //ms, before giving up an IPC publication
+
+typedef struct igs_receiver_ring {
+    igs_receiver_t *receiver;
+    igs_shm_reader_t *shm_reader;
+    zsock_t *subscriber; //of the same peer
+    uint64_t awaited; //number of the IPC publication we wait for, 0 if none
+    uint64_t last_placeholder; //number of the last placeholder read
+    int timer_id;
+    zlist_t *held; //ring publications read while waiting
+    zlist_t *early; //IPC publications received before their placeholder
+} igs_receiver_ring_t;
+
+// input of a local agent to be written with a received output, copied from
+// the reverse mapping index which may change while the model is unlocked
+typedef struct {
+    igsagent_t *agent;
+    char uuid[IGS_AGENT_UUID_LENGTH + 1];
+    char *input_name;
+} igs_publication_target_t;
+
+// one name/type/value triplet of a received publication, pointing into
+// the frames of the message
+typedef struct {
+    const char *name;
+    size_t name_length;
+    igs_iop_value_type_t value_type;
+    const void *value;
+    size_t size;
+} igs_publication_view_t;
+
+// output value captured for the agents of our process, either copied or
+// sharing the storage of the output
+typedef struct {
+    igs_iop_value_type_t value_type;
+    union {
+        int i;
+        double d;
+        bool b;
+        char bytes[IGS_IOP_INLINE_VALUE_SIZE + 1];
+    } value;
+    igs_value_t *shared;
+    void *data;
+    size_t size;
+} igs_local_publication_t;
+
+#define PUBLICATION_VIEWS_ON_STACK 16
+#define PUBLICATION_STRING_ON_STACK 256
+
+// Returns the value type given by the decimal type frame of a protocol v4
+// publication, 0 if invalid
+static int s_parse_value_type (zframe_t *type_frame)
+{
+    const byte *type = zframe_data (type_frame);
+    size_t type_size = zframe_size (type_frame);
+    int value_type = 0;
+    for (size_t i = 0; i < type_size && value_type <= IGS_DATA_T; i++) {
+        if (type[i] < '0' || type[i] > '9')
+            break;
+        value_type = 10 * value_type + (type[i] - '0');
+    }
+    if (value_type < IGS_INTEGER_T || value_type > IGS_DATA_T)
+        return 0;
+    return value_type;
+}
+
+// Decodes name/type/value triplets from msg, without copying them, and
+// returns the number of valid triplets found before the first invalid one
+static size_t s_decode_publication (zmsg_t *msg,
+                                    igs_publication_view_t *views,
+                                    size_t max_views)
+{
+    size_t nb_views = 0;
+    zframe_t *name_frame = zmsg_first (msg);
+    while (name_frame && nb_views < max_views) {
+        // Each message part must contain 3 elements
+        // 1 : output name
+        // 2 : output iopt_type
+        // 3 : value of the output as a string or zframe
+        zframe_t *type_frame = zmsg_next (msg);
+        if (type_frame == NULL) {
+            igs_error (
+              "output type is NULL in received publication : rejecting");
+            break;
+        }
+        zframe_t *value_frame = zmsg_next (msg);
+        if (value_frame == NULL) {
+            igs_error ("value is NULL in received publication : rejecting");
+            break;
+        }
+        if (zframe_size (name_frame) == 0
+            || zframe_size (name_frame) > IGS_MAX_IOP_NAME_LENGTH) {
+            igs_error (
+              "output name is invalid in received publication : rejecting");
+            break;
+        }
+        // type is sent as a decimal string
+        int value_type = s_parse_value_type (type_frame);
+        if (value_type == 0) {
+            igs_error ("output type is not valid in received "
+                       "publication : rejecting");
+            break;
+        }
+        igs_publication_view_t *view = &views[nb_views++];
+        view->name = (const char *) zframe_data (name_frame);
+        view->name_length = zframe_size (name_frame);
+        view->value_type = (igs_iop_value_type_t) value_type;
+        view->value = zframe_data (value_frame);
+        view->size = zframe_size (value_frame);
+        name_frame = zmsg_next (msg);
+    }
+    return nb_views;
+}
+
+// Writes a received or locally published output to the inputs of our
+// agents mapped on it. Must be called with the model mutex locked, which
+// is released while each input is written.
+static void s_write_mapped_inputs (igs_core_context_t *context,
+                                   const char *agent_name,
+                                   const char *output_name,
+                                   igs_iop_value_type_t value_type,
+                                   void *data,
+                                   size_t size)
+{
+    igs_mapping_target_t *mapped_targets =
+      mapping_index_targets (agent_name, output_name);
+    if (mapped_targets == NULL)
+        return;
+
+    // The model mutex is released while writing inputs, which
+    // lets the index change: targets are copied beforehand.
+    size_t nb_targets = 0;
+    igs_mapping_target_t *target = NULL;
+    LL_COUNT (mapped_targets, target, nb_targets);
+    igs_publication_target_t *targets =
+      (igs_publication_target_t *) zmalloc (nb_targets * sizeof (igs_publication_target_t));
+    size_t t = 0;
+    LL_FOREACH (mapped_targets, target){
+        targets[t].agent = target->agent;
+        snprintf (targets[t].uuid, IGS_AGENT_UUID_LENGTH + 1, "%s", target->agent->uuid);
+        targets[t].input_name = strdup (target->map_elmt->from_input);
+        t++;
+    }
+    for (t = 0; t < nb_targets; t++) {
+        const char *input_name = targets[t].input_name;
+        // check that this agent has not been deactivated or destroyed
+        // when we were unlocked
+        igsagent_t *agent = NULL;
+        HASH_FIND_STR (context->agents, targets[t].uuid, agent);
+        if (agent == NULL || agent != targets[t].agent)
+            continue;
+        // we have a match on emitting agent name and its ouput name :
+        // still need to check the targeted input existence in our
+        // definition
+        igs_iop_t *found_input = NULL;
+        if (agent->definition->inputs_table)
+            HASH_FIND_STR (agent->definition->inputs_table,
+                           input_name, found_input);
+        if (!found_input)
+            igsagent_warn (agent,
+                           "Input %s is missing in our definition but "
+                           "expected in our mapping with %s.%s",
+                           input_name, agent_name, output_name);
+        else {
+            // we have a fully matching mapping element : write from received
+            // output to our input, the reference taken under the model mutex
+            // keeping the agent alive if it is destroyed meanwhile
+            model_agent_retain (agent);
+            model_read_write_unlock (__FUNCTION__, __LINE__);
+            model_write_iop (agent, input_name, IGS_INPUT_T, value_type,
+                             data, size);
+            model_read_write_lock (__FUNCTION__, __LINE__);
+            model_agent_release (agent);
+        }
+    }
+    for (t = 0; t < nb_targets; t++)
+        free (targets[t].input_name);
+    free (targets);
+}
+
+// Writes the decoded outputs of a publication of agent_name to the inputs
+// of our agents mapped on them
+static void s_dispatch_views (igs_core_context_t *context,
+                              const char *agent_name,
+                              igs_publication_view_t *views,
+                              size_t nb_views)
+{
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // Publication does not provide information about the targeted agents.
+    // The reverse mapping index gives the inputs of our agents mapped on
+    // each received output.
+    for (size_t v = 0; v < nb_views; v++) {
+        char output[IGS_MAX_IOP_NAME_LENGTH + 1];
+        memcpy (output, views[v].name, views[v].name_length);
+        output[views[v].name_length] = '\0';
+        if (mapping_index_targets (agent_name, output) == NULL)
+            continue;
+
+        // strings are received without their terminating null character
+        void *data = (void *) views[v].value;
+        size_t size = views[v].size;
+        char string_on_stack[PUBLICATION_STRING_ON_STACK];
+        char *string = NULL;
+        if (views[v].value_type == IGS_STRING_T) {
+            string = (size < PUBLICATION_STRING_ON_STACK) ? string_on_stack
+                                                          : (char *) zmalloc (size + 1);
+            memcpy (string, views[v].value, size);
+            string[size] = '\0';
+            data = string;
+            size = strlen (string) + 1;
+        }
+        s_write_mapped_inputs (context, agent_name, output,
+                               views[v].value_type, data, size);
+        if (string && string != string_on_stack)
+            free (string);
+    }
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+}
+
+// Writes the name/type/value triplets of msg, published by agent_name,
+// to the inputs of our agents mapped on them
+static void s_dispatch_publication (igs_core_context_t *context,
+                                    const char *agent_name,
+                                    zmsg_t *msg)
+{
+    // the message is decoded once for all our agents
+    igs_publication_view_t views_on_stack[PUBLICATION_VIEWS_ON_STACK];
+    igs_publication_view_t *views = views_on_stack;
+    size_t max_views = zmsg_size (msg) / 3 + 1;
+    if (max_views > PUBLICATION_VIEWS_ON_STACK)
+        views = (igs_publication_view_t *) zmalloc (max_views * sizeof (igs_publication_view_t));
+    size_t nb_views = s_decode_publication (msg, views, max_views);
+    s_dispatch_views (context, agent_name, views, nb_views);
+    if (views != views_on_stack)
+        free (views);
+}
+
+// Fills view with the output designated by a protocol v5 header and
+// returns the length of the header, 0 if it is invalid
+static size_t s_decode_compact_header (const byte *header,
+                                       size_t size,
+                                       const char *output_name,
+                                       igs_publication_view_t *view)
+{
+    if (size < 1)
+        return 0;
+    int value_type = header[0] & ~PUBLICATION_V5_SEQUENCE;
+    size_t length = (header[0] & PUBLICATION_V5_SEQUENCE) ? 9 : 1;
+    if (size < length || value_type < IGS_INTEGER_T || value_type > IGS_DATA_T)
+        return 0;
+    view->name = output_name;
+    view->name_length = strlen (output_name);
+    view->value_type = (igs_iop_value_type_t) value_type;
+    return length;
+}
+
+// Decodes a protocol v5 publication of remote_agent, whose topic has been
+// checked by the caller, without copying its values. Outputs we did not
+// subscribe to are skipped.
+static size_t s_decode_compact_publication (igs_receiver_t *receiver,
+                                            zmsg_t *msg,
+                                            igs_receiver_topic_t *remote_topic,
+                                            igs_publication_view_t *views,
+                                            size_t max_views)
+{
+    zframe_t *topic_frame = zmsg_first (msg);
+    if (remote_topic->output_name) {
+        // single output: type byte follows the topic
+        zframe_t *value_frame = zmsg_next (msg);
+        if (value_frame == NULL
+            || s_decode_compact_header (zframe_data (topic_frame) + PUBLICATION_V5_TOPIC_LENGTH,
+                                        zframe_size (topic_frame) - PUBLICATION_V5_TOPIC_LENGTH,
+                                        remote_topic->output_name, &views[0]) == 0) {
+            igs_error ("invalid protocol v5 publication received : rejecting");
+            return 0;
+        }
+        views[0].value = zframe_data (value_frame);
+        views[0].size = zframe_size (value_frame);
+        return 1;
+    }
+    size_t nb_views = 0;
+    zframe_t *header_frame = zmsg_next (msg);
+    while (header_frame && nb_views < max_views) {
+        zframe_t *value_frame = zmsg_next (msg);
+        if (value_frame == NULL || zframe_size (header_frame) < PUBLICATION_V5_HEADER_LENGTH) {
+            igs_error ("invalid protocol v5 batch received : rejecting");
+            break;
+        }
+        const byte *header = zframe_data (header_frame);
+        uint64_t id = s_read_topic_id (header);
+        igs_receiver_topic_t *output_topic = NULL;
+        HASH_FIND (hh, receiver->topics, &id, sizeof (uint64_t), output_topic);
+        if (output_topic && output_topic->output_name
+            && output_topic->agent == remote_topic->agent) {
+            if (s_decode_compact_header (header + 8, zframe_size (header_frame) - 8,
+                                         output_topic->output_name,
+                                         &views[nb_views]) == 0) {
+                igs_error ("invalid protocol v5 batch received : rejecting");
+                break;
+            }
+            views[nb_views].value = zframe_data (value_frame);
+            views[nb_views].size = zframe_size (value_frame);
+            nb_views++;
+        }
+        header_frame = zmsg_next (msg);
+    }
+    return nb_views;
+}
+
+// Handles a protocol v5 publication from one of the remote agents we
+// subscribed to
+static void s_handle_compact_publication (igs_receiver_t *receiver, zmsg_t *msg)
+{
+    igs_core_context_t *context = receiver->context;
+    zframe_t *topic_frame = zmsg_first (msg);
+    if (zframe_size (topic_frame) < PUBLICATION_V5_TOPIC_LENGTH) {
+        igs_error ("protocol v5 topic is too short in received publication : rejecting");
+        return;
+    }
+    uint64_t id = s_read_topic_id (zframe_data (topic_frame) + 1);
+    igs_receiver_topic_t *remote_topic = NULL;
+    HASH_FIND (hh, receiver->topics, &id, sizeof (uint64_t), remote_topic);
+    if (remote_topic == NULL) {
+        igs_debug ("received publication for an unknown protocol v5 topic : rejecting");
+        return;
+    }
+    const char *agent_name = remote_topic->agent->name;
+    if (context->is_frozen == true) {
+        igs_debug ("Message received from %s but all traffic in our process is "
+                   "currently frozen",
+                   agent_name);
+        return;
+    }
+    igs_publication_view_t views_on_stack[PUBLICATION_VIEWS_ON_STACK];
+    igs_publication_view_t *views = views_on_stack;
+    size_t max_views = zmsg_size (msg) / 2 + 1;
+    if (max_views > PUBLICATION_VIEWS_ON_STACK)
+        views = (igs_publication_view_t *) zmalloc (max_views * sizeof (igs_publication_view_t));
+    size_t nb_views = s_decode_compact_publication (receiver, msg, remote_topic,
+                                                    views, max_views);
+    s_dispatch_views (context, agent_name, views, nb_views);
+    if (views != views_on_stack)
+        free (views);
+}
+
 // function actually handling messages from one of the remote agents we
 // subscribed to
 void s_handle_publication_from_remote_agent (zmsg_t *msg,
@@ -121,137 +639,13 @@ void s_handle_publication_from_remote_agent (zmsg_t *msg,
                    remote_agent->definition->name);
         return;
     }
-
-    model_read_write_lock (__FUNCTION__, __LINE__);
-    // Publication does not provide information about the targeted agents.
-    // At this stage, we only know that one or more of our agents are targeted.
-    // We need to iterate through our agents and their mapping to check which
-    // inputs need to be updated on which agent.
-    igsagent_t *agent, *tmp_agent;
-    HASH_ITER (hh, remote_agent->context->agents, agent, tmp_agent){
-        if (!agent || !agent->uuid || (strlen (agent->uuid) == 0))
-            continue;
-
-        zmsg_t *dup = zmsg_dup (msg);
-        size_t msg_size = zmsg_size (dup);
-        char *output = NULL;
-        char *v_type = NULL;
-        igs_iop_value_type_t value_type = 0;
-        unsigned long i = 0;
-        for (i = 0; i < msg_size; i += 3) {
-            // Each message part must contain 3 elements
-            // 1 : output name
-            // 2 : output iopt_type
-            // 3 : value of the output as a string or zframe
-            output = zmsg_popstr (dup);
-            if (output == NULL) {
-                igs_error (
-                  "output name is NULL in received publication : rejecting");
-                break;
-            }
-            v_type = zmsg_popstr (dup);
-            if (v_type == NULL) {
-                igs_error (
-                  "output type is NULL in received publication : rejecting");
-                free (output);
-                break;
-            }
-            value_type = atoi (v_type);
-            if (value_type < IGS_INTEGER_T || value_type > IGS_DATA_T) {
-                igs_error ("output type is not valid (%d) in received "
-                           "publication : rejecting",
-                           value_type);
-                free (output);
-                free (v_type);
-                break;
-            }
-            free (v_type);
-            v_type = NULL;
-
-            zframe_t *frame = NULL;
-            void *data = NULL;
-            size_t size = 0;
-            char *value = NULL;
-            // get data before iterating to all the mapping elements using it
-            if (value_type == IGS_STRING_T) {
-                value = zmsg_popstr (dup);
-                if (value == NULL) {
-                    igs_error (
-                      "value is NULL in received publication : rejecting");
-                    break;
-                }
-            }
-            else {
-                frame = zmsg_pop (dup);
-                if (frame == NULL) {
-                    igs_error (
-                      "value is NULL in received publication : rejecting");
-                    break;
-                }
-                data = zframe_data (frame);
-                size = zframe_size (frame);
-            }
-            // try to find mapping elements matching with this subscriber's output
-            // and update mapped input(s) value accordingly
-            // TODO : optimize mapping storage to avoid iterating
-            igs_map_t *elmt, *tmp;
-            // check that this agent has not been destroyed when we were locked
-            if (agent->mapping) {
-                HASH_ITER (hh, agent->mapping->map_elements, elmt, tmp){
-                    if (streq (elmt->to_agent, remote_agent->definition->name)
-                        && streq (elmt->to_output, output)) {
-                        // we have a match on emitting agent name and its ouput name :
-                        // still need to check the targeted input existence in our
-                        // definition
-                        igs_iop_t *found_input = NULL;
-                        if (agent->definition->inputs_table)
-                            HASH_FIND_STR (agent->definition->inputs_table,
-                                           elmt->from_input, found_input);
-                        if (!found_input)
-                            igsagent_warn (agent,
-                                           "Input %s is missing in our definition but "
-                                           "expected in our mapping with %s.%s",
-                                           elmt->from_input, elmt->to_agent,
-                                           elmt->to_output);
-                        else {
-                            // we have a fully matching mapping element : write from received
-                            // output to our input
-                            if (value_type == IGS_STRING_T) {
-                                model_read_write_unlock (__FUNCTION__, __LINE__);
-                                model_write_iop (agent, elmt->from_input,
-                                                 IGS_INPUT_T, value_type, value,
-                                                 strlen (value) + 1);
-                                model_read_write_lock (__FUNCTION__, __LINE__);
-
-                            }
-                            else {
-                                model_read_write_unlock (__FUNCTION__, __LINE__);
-                                model_write_iop (agent, elmt->from_input,
-                                                 IGS_INPUT_T, value_type, data,
-                                                 size);
-                                model_read_write_lock (__FUNCTION__, __LINE__);
-                            }
-                            if (!agent->uuid)
-                                break;
-                        }
-                    }
-                }
-            }
-            if (frame)
-                zframe_destroy (&frame);
-            if (value)
-                free (value);
-            free (output);
-            output = NULL;
-        }
-        zmsg_destroy (&dup);
-    }
-    model_read_write_unlock (__FUNCTION__, __LINE__);
+    s_dispatch_publication (remote_agent->context,
+                            remote_agent->definition->name, msg);
 }
 
 // Timer callback to send GET_CURRENT_OUTPUTS notification for an agent we
 // subscribed to
-int s_trigger_outputs_request_to_newcomer (zloop_t *loop,
+int s_trigger_outputs_request_to_newcomer (igs_loop_t *loop,
                                            int timer_id,
                                            void *arg)
 {
@@ -261,6 +655,7 @@ int s_trigger_outputs_request_to_newcomer (zloop_t *loop,
     assert (remote_agent);
     assert (remote_agent->context);
     assert (remote_agent->context->node);
+    remote_agent->timer_id = -1; //one-shot, its id may be reused
 
     if (remote_agent->shall_send_outputs_request) {
         s_lock_zyre_peer (__FUNCTION__, __LINE__);
@@ -275,21 +670,212 @@ int s_trigger_outputs_request_to_newcomer (zloop_t *loop,
     return 0;
 }
 
-// manage incoming messages from one of the remote agents we subscribed to
-int s_manage_remote_publication (zloop_t *loop, zsock_t *socket, void *arg)
+#if defined(IGS_SHM_RING)
+// Number of a publication sent using IPC instead of the ring, or of its
+// placeholder, 0 if invalid
+static uint64_t s_fallback_number (zmsg_t *msg)
+{
+    zframe_t *frame = zmsg_first (msg);
+    frame = (frame) ? zmsg_next (msg) : NULL;
+    uint64_t number = 0;
+    if (frame && zframe_size (frame) == sizeof (uint64_t))
+        memcpy (&number, zframe_data (frame), sizeof (uint64_t));
+    return number;
+}
+
+// Handles a publication sent using IPC instead of the ring, without its
+// number
+static void s_handle_fallback_publication (igs_receiver_t *receiver, zmsg_t **msg)
+{
+    zframe_t *topic = zmsg_pop (*msg);
+    zframe_t *number = zmsg_pop (*msg);
+    zframe_destroy (&number);
+    zmsg_prepend (*msg, &topic);
+    s_handle_compact_publication (receiver, *msg);
+    zmsg_destroy (msg);
+}
+
+// Handles the early IPC publications numbered before number, whose
+// placeholders were lost
+static void s_ring_handle_early (igs_receiver_ring_t *ring, uint64_t number)
+{
+    zmsg_t *msg = (zmsg_t *) zlist_first (ring->early);
+    while (msg && s_fallback_number (msg) < number) {
+        zlist_remove (ring->early, msg);
+        s_handle_fallback_publication (ring->receiver, &msg);
+        msg = (zmsg_t *) zlist_first (ring->early);
+    }
+}
+
+static int s_ring_fallback_timeout (igs_loop_t *loop, int timer_id, void *arg);
+
+// Handles a publication read from the ring of a peer, or holds it while
+// waiting for an IPC publication
+static void s_ring_handle (igs_receiver_ring_t *ring, zmsg_t **msg)
+{
+    if (ring->awaited) {
+        zlist_append (ring->held, *msg);
+        *msg = NULL;
+        return;
+    }
+    zframe_t *topic_frame = zmsg_first (*msg);
+    if (topic_frame == NULL || zframe_size (topic_frame) == 0
+        || zframe_data (topic_frame)[0] != PUBLICATION_SHM_MARKER) {
+        s_handle_compact_publication (ring->receiver, *msg);
+        zmsg_destroy (msg);
+        return;
+    }
+    // placeholder of an IPC publication
+    uint64_t number = s_fallback_number (*msg);
+    zmsg_destroy (msg);
+    if (number == 0)
+        return;
+    ring->last_placeholder = number;
+    s_ring_handle_early (ring, number);
+    zmsg_t *early = (zmsg_t *) zlist_first (ring->early);
+    if (early && s_fallback_number (early) == number) {
+        zlist_remove (ring->early, early);
+        s_handle_fallback_publication (ring->receiver, &early);
+    }
+    else {
+        ring->awaited = number;
+        ring->timer_id = loop_timer (ring->receiver->loop, RECEIVER_FALLBACK_TIMEOUT,
+                                     1, s_ring_fallback_timeout, ring);
+    }
+}
+
+// Stops waiting for an IPC publication and handles the ring publications
+// held meanwhile, until the next placeholder to wait for
+static void s_ring_resume (igs_receiver_ring_t *ring)
+{
+    if (ring->timer_id > 0)
+        loop_timer_end (ring->receiver->loop, ring->timer_id);
+    ring->timer_id = -1;
+    ring->awaited = 0;
+    while (ring->awaited == 0 && zlist_size (ring->held) > 0) {
+        zmsg_t *msg = (zmsg_t *) zlist_pop (ring->held);
+        s_ring_handle (ring, &msg);
+    }
+}
+
+static int s_ring_fallback_timeout (igs_loop_t *loop, int timer_id, void *arg)
 {
     IGS_UNUSED (loop)
-    igs_core_context_t *context = (igs_core_context_t *) arg;
+    IGS_UNUSED (timer_id)
+    igs_receiver_ring_t *ring = (igs_receiver_ring_t *) arg;
+    ring->timer_id = -1; //one-shot, its id may be reused
+    igs_warn ("publication sent using IPC instead of a shared memory ring was "
+              "lost or is late");
+    s_ring_resume (ring);
+    return 0;
+}
+
+// Handles a publication sent by a peer using IPC instead of its ring, in
+// the order of its placeholder in the ring
+static void s_ring_handle_fallback (igs_receiver_ring_t *ring, zmsg_t **msg)
+{
+    uint64_t number = s_fallback_number (*msg);
+    if (number == 0) {
+        igs_error ("publication sent using IPC instead of a shared memory ring "
+                   "has no number : rejecting");
+        zmsg_destroy (msg);
+    }
+    else if (number == ring->awaited) {
+        s_handle_fallback_publication (ring->receiver, msg);
+        s_ring_resume (ring);
+    }
+    else if (number <= ring->last_placeholder)
+        // its place was given up
+        s_handle_fallback_publication (ring->receiver, msg);
+    else {
+        zlist_append (ring->early, *msg);
+        *msg = NULL;
+    }
+}
+
+static igs_receiver_ring_t *s_receiver_ring_by_subscriber (igs_receiver_t *receiver,
+                                                           zsock_t *subscriber)
+{
+    igs_receiver_ring_t *ring = (igs_receiver_ring_t *) zlist_first (receiver->rings);
+    while (ring && ring->subscriber != subscriber)
+        ring = (igs_receiver_ring_t *) zlist_next (receiver->rings);
+    return ring;
+}
+
+static void s_receiver_ring_destroy (igs_receiver_ring_t **ring)
+{
+    assert (ring);
+    if (*ring == NULL)
+        return;
+    if ((*ring)->timer_id > 0)
+        loop_timer_end ((*ring)->receiver->loop, (*ring)->timer_id);
+    zmsg_t *msg = (zmsg_t *) zlist_pop ((*ring)->held);
+    while (msg) {
+        zmsg_destroy (&msg);
+        msg = (zmsg_t *) zlist_pop ((*ring)->held);
+    }
+    msg = (zmsg_t *) zlist_pop ((*ring)->early);
+    while (msg) {
+        zmsg_destroy (&msg);
+        msg = (zmsg_t *) zlist_pop ((*ring)->early);
+    }
+    zlist_destroy (&(*ring)->held);
+    zlist_destroy (&(*ring)->early);
+    shm_reader_destroy (&(*ring)->shm_reader);
+    free (*ring);
+    *ring = NULL;
+}
+
+// manage incoming messages from the shm ring of one of our peers, in the
+// receiver thread
+static int s_manage_ring_publication (igs_loop_t *loop, zsock_t *socket, void *arg)
+{
+    IGS_UNUSED (loop)
+    igs_receiver_ring_t *ring = (igs_receiver_ring_t *) arg;
+    zmsg_t *msg = zmsg_recv (socket);
+    if (msg)
+        s_ring_handle (ring, &msg);
+    return 0;
+}
+#endif
+
+// manage incoming messages from one of the remote agents we subscribed to,
+// in the receiver thread
+int s_manage_remote_publication (igs_loop_t *loop, zsock_t *socket, void *arg)
+{
+    IGS_UNUSED (loop)
+    igs_receiver_t *receiver = (igs_receiver_t *) arg;
     assert (socket);
-    assert (context);
+    assert (receiver);
 
     zmsg_t *msg = zmsg_recv (socket);
+    if (msg == NULL)
+        return 0;
+    zframe_t *topic_frame = zmsg_first (msg);
+#if defined(IGS_SHM_RING)
+    if (topic_frame && zframe_size (topic_frame) > 0
+        && zframe_data (topic_frame)[0] == PUBLICATION_SHM_MARKER) {
+        igs_receiver_ring_t *ring = s_receiver_ring_by_subscriber (receiver, socket);
+        if (ring)
+            s_ring_handle_fallback (ring, &msg);
+        else
+            s_handle_fallback_publication (receiver, &msg);
+        return 0;
+    }
+#endif
+    if (topic_frame && zframe_size (topic_frame) > 0
+        && zframe_data (topic_frame)[0] == PUBLICATION_V5_MARKER) {
+        s_handle_compact_publication (receiver, msg);
+        zmsg_destroy (&msg);
+        return 0;
+    }
     // The output name now includes the agent uuid as prefix.
     // We merged them to keep the ZeroMQ PUB/SUB filters working
     // in a context where a peer now possibly hosts multiple agents.
     char *output_name = zmsg_popstr (msg);
     if (output_name == NULL) {
         igs_error ("output name is NULL in received publication : rejecting");
+        zmsg_destroy (&msg);
         return 0;
     }
     char uuid[IGS_AGENT_UUID_LENGTH + 1] = "";
@@ -297,87 +883,615 @@ int s_manage_remote_publication (zloop_t *loop, zsock_t *socket, void *arg)
         igs_error ("output name '%s' is missing information : rejecting",
                    output_name);
         free (output_name);
+        zmsg_destroy (&msg);
         return 0;
     }
     snprintf (uuid, IGS_AGENT_UUID_LENGTH + 1, "%s", output_name);
-    char *real_output_name = output_name + IGS_AGENT_UUID_LENGTH + 1;
-
-    // NB: We push the output name again at the beginning of
-    // the message for proper use by s_handle_publication_from_remote_agent
-    zmsg_pushstr (msg, real_output_name);
+    if (!streq (output_name + IGS_AGENT_UUID_LENGTH, PUBLICATION_BATCH_SUFFIX)) {
+        char *real_output_name = output_name + IGS_AGENT_UUID_LENGTH + 1;
+        // NB: We push the output name again at the beginning of
+        // the message for proper use by s_dispatch_publication
+        zmsg_pushstr (msg, real_output_name);
+    }
+    // else: batches already are a sequence of name/type/value triplets
     free (output_name);
 
-    igs_remote_agent_t *remote_agent = NULL;
-    HASH_FIND_STR (context->remote_agents, uuid, remote_agent);
+    igs_receiver_agent_t *remote_agent = NULL;
+    HASH_FIND_STR (receiver->agents, uuid, remote_agent);
     if (remote_agent == NULL) {
         igs_error ("no remote agent with uuid '%s' : rejecting", uuid);
+        zmsg_destroy (&msg);
         return 0;
     }
-    s_handle_publication_from_remote_agent (msg, remote_agent);
+    if (receiver->context->is_frozen == true)
+        igs_debug ("Message received from %s but all traffic in our process is "
+                   "currently frozen",
+                   remote_agent->name);
+    else
+        s_dispatch_publication (receiver->context, remote_agent->name, msg);
     zmsg_destroy (&msg);
     return 0;
 }
 
-void s_clean_and_free_zyre_peer (igs_zyre_peer_t **zyre_peer, zloop_t *loop)
+static void s_receiver_remove_agent (igs_receiver_t *receiver, const char *uuid)
 {
-    assert (zyre_peer);
-    assert (*zyre_peer);
-    assert (loop);
-    igs_debug ("cleaning peer %s (%s)", (*zyre_peer)->name,
-               (*zyre_peer)->peer_id);
-    if ((*zyre_peer)->peer_id)
-        free ((*zyre_peer)->peer_id);
-    if ((*zyre_peer)->name)
-        free ((*zyre_peer)->name);
-    if ((*zyre_peer)->protocol)
-        free ((*zyre_peer)->protocol);
-    if ((*zyre_peer)->subscriber) {
-        zloop_reader_end (loop, (*zyre_peer)->subscriber);
-        zsock_destroy (&((*zyre_peer)->subscriber));
+    igs_receiver_agent_t *remote_agent = NULL;
+    HASH_FIND_STR (receiver->agents, uuid, remote_agent);
+    if (remote_agent == NULL)
+        return;
+    igs_receiver_topic_t *topic, *tmp;
+    HASH_ITER (hh, receiver->topics, topic, tmp){
+        if (topic->agent == remote_agent) {
+            HASH_DEL (receiver->topics, topic);
+            free (topic->output_name);
+            free (topic);
+        }
     }
-    free (*zyre_peer);
-    *zyre_peer = NULL;
+    HASH_DEL (receiver->agents, remote_agent);
+    free (remote_agent->name);
+    free (remote_agent);
 }
 
-#define NOTIFY_REMOTE_AGENT_TIMER 500
-
-// Adds proper filter to 'subscribe' socket for a spectific output of a given
-// remote agent
-void s_subscribe_to_remote_agent_output (igs_remote_agent_t *remote_agent,
-                                         const char *output_name)
+static void s_receiver_apply (igs_receiver_t *receiver,
+                              igs_receiver_command_t *command)
 {
-    assert (remote_agent);
-    assert (output_name);
-    if (strlen (output_name) > 0) {
-        char filter_value[IGS_MAX_IOP_NAME_LENGTH + IGS_AGENT_UUID_LENGTH + 1] =
-          "";
-        snprintf (filter_value,
-                  IGS_MAX_IOP_NAME_LENGTH + IGS_AGENT_UUID_LENGTH + 1, "%s-%s",
-                  remote_agent->uuid, output_name);
-        bool filter_already_exists = false;
-        igs_mapping_filter_t *filter = NULL;
-        DL_FOREACH (remote_agent->mapping_filters, filter)
-        {
-            if (streq (filter->filter, filter_value)) {
-                filter_already_exists = true;
-                break;
-            }
+    switch (command->type) {
+        case RECEIVER_ADD_SUBSCRIBER:
+            loop_reader (receiver->loop, command->subscriber,
+                         s_manage_remote_publication, receiver);
+            zlist_append (receiver->subscribers, command->subscriber);
+            break;
+#if defined(IGS_SHM_RING)
+        case RECEIVER_ADD_SHM_READER: {
+            igs_receiver_ring_t *ring =
+              (igs_receiver_ring_t *) zmalloc (sizeof (igs_receiver_ring_t));
+            ring->receiver = receiver;
+            ring->shm_reader = command->shm_reader;
+            ring->subscriber = command->subscriber;
+            ring->timer_id = -1;
+            ring->held = zlist_new ();
+            ring->early = zlist_new ();
+            loop_reader (receiver->loop, shm_reader_sock (ring->shm_reader),
+                         s_manage_ring_publication, ring);
+            zlist_append (receiver->rings, ring);
+            break;
+        }
+#endif
+        case RECEIVER_REMOVE_PEER:
+            if (command->subscriber) {
+                loop_reader_end (receiver->loop, command->subscriber);
+                zlist_remove (receiver->subscribers, command->subscriber);
+                zsock_destroy (&command->subscriber);
+            }
+#if defined(IGS_SHM_RING)
+            if (command->shm_reader) {
+                igs_receiver_ring_t *ring =
+                  (igs_receiver_ring_t *) zlist_first (receiver->rings);
+                while (ring && ring->shm_reader != command->shm_reader)
+                    ring = (igs_receiver_ring_t *) zlist_next (receiver->rings);
+                if (ring) {
+                    loop_reader_end (receiver->loop, shm_reader_sock (ring->shm_reader));
+                    zlist_remove (receiver->rings, ring);
+                    s_receiver_ring_destroy (&ring);
+                }
+            }
+#endif
+            break;
+        case RECEIVER_SUBSCRIBE:
+        case RECEIVER_UNSUBSCRIBE:
+            zmq_setsockopt (zsock_resolve (command->subscriber),
+                            (command->type == RECEIVER_SUBSCRIBE) ? ZMQ_SUBSCRIBE : ZMQ_UNSUBSCRIBE,
+                            command->text, command->length);
+#if defined(IGS_SHM_RING)
+            // the ring reader only copies the publications we subscribed to
+            if (command->shm_reader && command->length > 0
+                && (byte) command->text[0] == PUBLICATION_SHM_MARKER)
+                shm_reader_subscribe (command->shm_reader, command->text, command->length,
+                                      (command->type == RECEIVER_SUBSCRIBE));
+#endif
+            break;
+        case RECEIVER_SET_AGENT: {
+            igs_receiver_agent_t *remote_agent = NULL;
+            HASH_FIND_STR (receiver->agents, command->uuid, remote_agent);
+            if (remote_agent == NULL) {
+                remote_agent = (igs_receiver_agent_t *) zmalloc (sizeof (igs_receiver_agent_t));
+                snprintf (remote_agent->uuid, IGS_AGENT_UUID_LENGTH + 1, "%s", command->uuid);
+                HASH_ADD_STR (receiver->agents, uuid, remote_agent);
+            }
+            free (remote_agent->name);
+            remote_agent->name = command->text;
+            command->text = NULL;
+            break;
+        }
+        case RECEIVER_REMOVE_AGENT:
+            s_receiver_remove_agent (receiver, command->uuid);
+            break;
+        case RECEIVER_ADD_TOPIC: {
+            igs_receiver_agent_t *remote_agent = NULL;
+            HASH_FIND_STR (receiver->agents, command->uuid, remote_agent);
+            igs_receiver_topic_t *topic = NULL;
+            HASH_FIND (hh, receiver->topics, &command->topic_id, sizeof (uint64_t), topic);
+            if (remote_agent && topic == NULL) {
+                topic = (igs_receiver_topic_t *) zmalloc (sizeof (igs_receiver_topic_t));
+                topic->id = command->topic_id;
+                topic->agent = remote_agent;
+                topic->output_name = command->text;
+                command->text = NULL;
+                HASH_ADD (hh, receiver->topics, id, sizeof (uint64_t), topic);
+            }
+            break;
+        }
+        case RECEIVER_SET_HWM: {
+            zsock_t *subscriber = (zsock_t *) zlist_first (receiver->subscribers);
+            while (subscriber) {
+                zsock_set_rcvhwm (subscriber, command->hwm);
+                subscriber = (zsock_t *) zlist_next (receiver->subscribers);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    free (command->text);
+    free (command);
+}
+
+// Applies the commands of the receiver queue, then announces that the
+// receiver thread waits for a signal and checks the queue again, so that
+// a command queued meanwhile is either seen or signaled
+static void s_receiver_drain (igs_receiver_t *receiver)
+{
+    igs_queue_t *queue = receiver->queue;
+    int flags = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        igs_receiver_command_t *command =
+          (igs_receiver_command_t *) s_queue_pop (queue, &flags);
+        while (command) {
+            s_receiver_apply (receiver, command);
+            command = (igs_receiver_command_t *) s_queue_pop (queue, &flags);
+        }
+        IGS_ATOMIC_STORE (queue->is_waiting, 1);
+    }
+}
+
+// Signals from the network thread tell that commands are queued
+static int s_manage_receiver_pipe (igs_loop_t *loop, zsock_t *pipe, void *arg)
+{
+    IGS_UNUSED (loop)
+    igs_receiver_t *receiver = (igs_receiver_t *) arg;
+    int result = 0;
+    zmsg_t *msg = zmsg_recv (pipe);
+    if (msg == NULL)
+        result = -1;
+    else if (zmsg_signal (msg) < 0) {
+        char *command = zmsg_popstr (msg);
+        if (command && streq (command, "$TERM"))
+            result = -1;
+        free (command);
+    }
+    zmsg_destroy (&msg);
+    s_receiver_drain (receiver);
+    return result;
+}
+
+// Receiver thread: reads the subscriber sockets and shm readers of its
+// peers and writes their publications to the inputs of our agents
+static void s_receiver_actor (zsock_t *pipe, void *args)
+{
+    igs_receiver_thread_t *receiver_thread = (igs_receiver_thread_t *) args;
+    igs_receiver_t receiver = {0};
+    receiver.context = receiver_thread->context;
+    receiver.queue = receiver_thread->queue;
+    receiver.loop = loop_new ();
+    assert (receiver.loop);
+    receiver.subscribers = zlist_new ();
+    receiver.rings = zlist_new ();
+    loop_reader (receiver.loop, pipe, s_manage_receiver_pipe, &receiver);
+    s_receiver_drain (&receiver);
+    zsock_signal (pipe, 0);
+
+    loop_start (receiver.loop);
+
+    // peers are normally removed by the network thread before stopping us
+    s_receiver_drain (&receiver);
+    zsock_t *subscriber = (zsock_t *) zlist_pop (receiver.subscribers);
+    while (subscriber) {
+        zsock_destroy (&subscriber);
+        subscriber = (zsock_t *) zlist_pop (receiver.subscribers);
+    }
+#if defined(IGS_SHM_RING)
+    igs_receiver_ring_t *ring = (igs_receiver_ring_t *) zlist_pop (receiver.rings);
+    while (ring) {
+        s_receiver_ring_destroy (&ring);
+        ring = (igs_receiver_ring_t *) zlist_pop (receiver.rings);
+    }
+#endif
+    igs_receiver_agent_t *remote_agent, *tmp;
+    HASH_ITER (hh, receiver.agents, remote_agent, tmp)
+        s_receiver_remove_agent (&receiver, remote_agent->uuid);
+    zlist_destroy (&receiver.subscribers);
+    zlist_destroy (&receiver.rings);
+    loop_destroy (&receiver.loop);
+}
+
+// Commands queued by the network thread while the queue of a receiver is
+// full wait in its backlog, which is flushed by the next commands or by a
+// timer. Returns true if the backlog is empty.
+static bool s_flush_receiver_commands (igs_receiver_thread_t *receiver)
+{
+    igs_receiver_command_t *command =
+      (igs_receiver_command_t *) zlist_first (receiver->backlog);
+    while (command && s_queue_push (receiver->queue, command, 0)) {
+        zlist_remove (receiver->backlog, command);
+        command = (igs_receiver_command_t *) zlist_first (receiver->backlog);
+    }
+    if (IGS_ATOMIC_EXCHANGE (receiver->queue->is_waiting, 0))
+        zsock_signal (zactor_sock (receiver->actor), 0);
+    return (command == NULL);
+}
+
+static int s_flush_receiver_backlog (igs_loop_t *loop, int timer_id, void *arg)
+{
+    IGS_UNUSED (timer_id)
+    igs_receiver_thread_t *receiver = (igs_receiver_thread_t *) arg;
+    if (!s_flush_receiver_commands (receiver))
+        loop_timer (loop, 1, 1, s_flush_receiver_backlog, receiver);
+    return 0;
+}
+
+// Queues a command for a receiver thread. Only used by the network
+// thread, which never waits for the receiver threads, as they may wait
+// for the model mutex meanwhile.
+static void s_receiver_send (igs_receiver_thread_t *receiver,
+                             igs_receiver_command_t *command)
+{
+    assert (receiver->actor);
+    bool had_backlog = (zlist_size (receiver->backlog) > 0);
+    zlist_append (receiver->backlog, command);
+    if (!s_flush_receiver_commands (receiver) && !had_backlog)
+        loop_timer (receiver->context->loop, 1, 1, s_flush_receiver_backlog, receiver);
+}
+
+// Receiver thread of a peer, given by the hash of its id, so that all the
+// publications of the peer are handled in order by the same thread
+static igs_receiver_thread_t *s_peer_receiver (igs_core_context_t *context,
+                                               igs_zyre_peer_t *peer)
+{
+    assert (context->nb_receivers > 0);
+    return &context->receivers[s_topic_id (peer->peer_id) % context->nb_receivers];
+}
+
+static igs_receiver_command_t *s_receiver_command_new (int type)
+{
+    igs_receiver_command_t *command =
+      (igs_receiver_command_t *) zmalloc (sizeof (igs_receiver_command_t));
+    command->type = type;
+    return command;
+}
+
+// Queues a command about a remote agent for the receiver thread of its peer
+static void s_receiver_send_for_agent (igs_remote_agent_t *remote_agent,
+                                       igs_receiver_command_t *command)
+{
+    snprintf (command->uuid, IGS_AGENT_UUID_LENGTH + 1, "%s", remote_agent->uuid);
+    command->subscriber = remote_agent->peer->subscriber;
+    command->shm_reader = remote_agent->peer->shm_reader;
+    s_receiver_send (s_peer_receiver (remote_agent->context, remote_agent->peer),
+                     command);
+}
+
+// Subscribes or unsubscribes the subscriber socket of the peer of a remote
+// agent to a filter, and its shm ring reader to the shm filters
+static void s_receiver_send_filter (igs_remote_agent_t *remote_agent,
+                                    int type,
+                                    const char *filter,
+                                    size_t length)
+{
+    igs_receiver_command_t *command = s_receiver_command_new (type);
+    command->text = (char *) zmalloc (length + 1);
+    memcpy (command->text, filter, length);
+    command->length = length;
+    s_receiver_send_for_agent (remote_agent, command);
+}
+
+// Adds a remote agent to the receiver thread of its peer, or updates its
+// name
+static void s_receiver_send_agent (igs_remote_agent_t *remote_agent)
+{
+    igs_receiver_command_t *command = s_receiver_command_new (RECEIVER_SET_AGENT);
+    command->text = strdup (remote_agent->definition->name);
+    s_receiver_send_for_agent (remote_agent, command);
+}
+
+// Opens our subscriber socket to the publisher of a peer, and its
+// shared-memory ring if any, and hands them over to the receiver thread of
+// the peer. Returns false if the peer does not publish.
+static bool s_open_peer_subscriber (igs_core_context_t *context,
+                                    igs_zyre_peer_t *zyre_peer)
+{
+    if (zyre_peer->subscriber)
+        return true;
+    if (zyre_peer->publisher_endpoint == NULL)
+        return false;
+    zyre_peer->subscriber = zsock_new_sub (zyre_peer->publisher_endpoint, NULL);
+    assert (zyre_peer->subscriber);
+    zsock_set_rcvhwm (zyre_peer->subscriber, context->network_hwm_value);
+    if (zyre_peer->public_key) {
+        zcert_apply (context->security_cert, zyre_peer->subscriber);
+        zsock_set_curve_serverkey (zyre_peer->subscriber, zyre_peer->public_key);
+    }
+    igs_debug ("Subscription created for %s at %s", zyre_peer->name,
+               zyre_peer->publisher_endpoint);
+    igs_receiver_command_t *command = s_receiver_command_new (RECEIVER_ADD_SUBSCRIBER);
+    command->subscriber = zyre_peer->subscriber;
+    s_receiver_send (s_peer_receiver (context, zyre_peer), command);
+#if defined(IGS_SHM_RING)
+    if (zyre_peer->shm_path) {
+        zyre_peer->shm_reader = shm_reader_new (zyre_peer->shm_path);
+        if (zyre_peer->shm_reader) {
+            command = s_receiver_command_new (RECEIVER_ADD_SHM_READER);
+            command->subscriber = zyre_peer->subscriber;
+            command->shm_reader = zyre_peer->shm_reader;
+            s_receiver_send (s_peer_receiver (context, zyre_peer), command);
+            igs_debug ("Shared-memory ring of %s read at %s", zyre_peer->name,
+                       zyre_peer->shm_path);
+        }
+    }
+#endif
+    return true;
+}
+
+// Closes our subscriber socket and shared-memory ring reader of a peer
+static void s_close_peer_subscriber (igs_core_context_t *context,
+                                     igs_zyre_peer_t *zyre_peer)
+{
+    if (zyre_peer->subscriber == NULL && zyre_peer->shm_reader == NULL)
+        return;
+    // sockets are destroyed by the receiver thread, which uses them
+    igs_receiver_command_t *command = s_receiver_command_new (RECEIVER_REMOVE_PEER);
+    command->subscriber = zyre_peer->subscriber;
+    command->shm_reader = zyre_peer->shm_reader;
+    s_receiver_send (s_peer_receiver (context, zyre_peer), command);
+    zyre_peer->subscriber = NULL;
+    zyre_peer->shm_reader = NULL;
+    igs_debug ("Subscription closed for %s", zyre_peer->name);
+}
+
+// Counts a subscription filter removed from a remote agent and closes the
+// subscriber socket of its peer with the last one
+static void s_remove_peer_filter (igs_remote_agent_t *remote_agent)
+{
+    assert (remote_agent->peer->nb_filters > 0);
+    if (--remote_agent->peer->nb_filters == 0)
+        s_close_peer_subscriber (remote_agent->context, remote_agent->peer);
+}
+
+void s_clean_and_free_zyre_peer (igs_zyre_peer_t **zyre_peer,
+                                 igs_core_context_t *context)
+{
+    assert (zyre_peer);
+    assert (*zyre_peer);
+    assert (context);
+    igs_debug ("cleaning peer %s (%s)", (*zyre_peer)->name,
+               (*zyre_peer)->peer_id);
+    if ((*zyre_peer)->peer_id)
+        free ((*zyre_peer)->peer_id);
+    if ((*zyre_peer)->name)
+        free ((*zyre_peer)->name);
+    if ((*zyre_peer)->protocol)
+        free ((*zyre_peer)->protocol);
+    s_close_peer_subscriber (context, *zyre_peer);
+    free ((*zyre_peer)->publisher_endpoint);
+    free ((*zyre_peer)->public_key);
+    free ((*zyre_peer)->shm_path);
+    free (*zyre_peer);
+    *zyre_peer = NULL;
+}
+
+#define NOTIFY_REMOTE_AGENT_TIMER 500
+
+// Adds a filter to the 'subscribe' socket of a given remote agent, once
+static void s_add_subscription_filter (igs_remote_agent_t *remote_agent,
+                                       const char *filter_value,
+                                       size_t length)
+{
+    bool filter_already_exists = false;
+    igs_mapping_filter_t *filter = NULL;
+    DL_FOREACH (remote_agent->mapping_filters, filter)
+    {
+        if (filter->length == length
+            && memcmp (filter->filter, filter_value, length) == 0) {
+            filter_already_exists = true;
+            break;
+        }
+    }
+    if (!filter_already_exists) {
+        // Set subscriber to the output filter
+        assert (remote_agent->peer->subscriber);
+        remote_agent->peer->nb_filters++;
+        igs_mapping_filter_t *f = (igs_mapping_filter_t *) zmalloc (
+          sizeof (igs_mapping_filter_t));
+        f->filter = (char *) zmalloc (length + 1);
+        memcpy (f->filter, filter_value, length);
+        f->length = length;
+        if (s_peer_protocol (remote_agent->peer) >= PUBLICATION_V5_PROTOCOL)
+            igs_debug ("subscribe to agent %s with a protocol v5 filter",
+                       remote_agent->definition->name);
+        else
+            igs_debug ("subscribe to agent %s with filter %s",
+                       remote_agent->definition->name, f->filter);
+        s_receiver_send_filter (remote_agent, RECEIVER_SUBSCRIBE, f->filter, length);
+        DL_APPEND (remote_agent->mapping_filters, f);
+    }
+}
+
+// Adds the protocol v5 filter for a topic of a given remote agent and
+// remembers the output it stands for
+static void s_add_compact_subscription_filter (igs_remote_agent_t *remote_agent,
+                                               const char *topic,
+                                               const char *output_name)
+{
+    uint64_t id = s_topic_id (topic);
+    igs_remote_topic_t *remote_topic = NULL;
+    HASH_FIND (hh, remote_agent->context->remote_topics, &id, sizeof (uint64_t), remote_topic);
+    if (remote_topic == NULL) {
+        remote_topic = (igs_remote_topic_t *) zmalloc (sizeof (igs_remote_topic_t));
+        remote_topic->id = id;
+        remote_topic->remote_agent = remote_agent;
+        if (output_name)
+            remote_topic->output_name = strdup (output_name);
+        HASH_ADD (hh, remote_agent->context->remote_topics, id, sizeof (uint64_t), remote_topic);
+        igs_receiver_command_t *command = s_receiver_command_new (RECEIVER_ADD_TOPIC);
+        command->topic_id = id;
+        if (output_name)
+            command->text = strdup (output_name);
+        s_receiver_send_for_agent (remote_agent, command);
+    }
+    else if (remote_topic->remote_agent != remote_agent
+             || (output_name == NULL) != (remote_topic->output_name == NULL)
+             || (output_name && !streq (output_name, remote_topic->output_name))) {
+        igs_warn ("protocol v5 topic of %s is already used by another output : "
+                  "ignoring it",
+                  topic);
+        return;
+    }
+    byte filter[PUBLICATION_V5_TOPIC_LENGTH];
+    s_write_compact_topic (filter, id);
+    if (remote_agent->peer->shm_reader)
+        filter[0] = PUBLICATION_SHM_MARKER;
+    s_add_subscription_filter (remote_agent, (const char *) filter,
+                               PUBLICATION_V5_TOPIC_LENGTH);
+}
+
+// Adds proper filter to 'subscribe' socket for a spectific output of a given
+// remote agent, and for the batches of outputs this agent may publish.
+// The subscriber of the peer is opened with its first filter: like any
+// subscription made after connecting, the values published before it
+// reaches the peer are lost, which the outputs request sent after mapping
+// makes up for (see igs_mapping_set_outputs_request).
+void s_subscribe_to_remote_agent_output (igs_remote_agent_t *remote_agent,
+                                         const char *output_name)
+{
+    assert (remote_agent);
+    assert (output_name);
+    if (strlen (output_name) > 0) {
+        if (!s_open_peer_subscriber (remote_agent->context, remote_agent->peer)) {
+            igs_warn ("%s does not publish : cannot subscribe to its output %s",
+                      remote_agent->definition->name, output_name);
+            return;
         }
-        if (!filter_already_exists) {
-            // Set subscriber to the output filter
-            assert (remote_agent->peer->subscriber);
-            igs_debug ("subscribe to agent %s output %s (%s)",
-                       remote_agent->definition->name, output_name,
-                       filter_value);
-            zsock_set_subscribe (remote_agent->peer->subscriber, filter_value);
-            igs_mapping_filter_t *f = (igs_mapping_filter_t *) zmalloc (
-              sizeof (igs_mapping_filter_t));
-            f->filter = strdup (filter_value);
-            DL_APPEND (remote_agent->mapping_filters, f);
+        char filter_value[IGS_MAX_IOP_NAME_LENGTH + IGS_AGENT_UUID_LENGTH + 1] =
+          "";
+        char batch_filter_value[IGS_AGENT_UUID_LENGTH + 2] = "";
+        snprintf (filter_value,
+                  IGS_MAX_IOP_NAME_LENGTH + IGS_AGENT_UUID_LENGTH + 1, "%s-%s",
+                  remote_agent->uuid, output_name);
+        snprintf (batch_filter_value, IGS_AGENT_UUID_LENGTH + 2, "%s%s",
+                  remote_agent->uuid, PUBLICATION_BATCH_SUFFIX);
+        if (s_peer_protocol (remote_agent->peer) >= PUBLICATION_V5_PROTOCOL) {
+            s_add_compact_subscription_filter (remote_agent, filter_value, output_name);
+            s_add_compact_subscription_filter (remote_agent, batch_filter_value, NULL);
         }
         else {
-            // printf("\n****************\nFILTER BIS %s - %s\n***************\n",
-            // subscriber->agent->name, output_name);
+            s_add_subscription_filter (remote_agent, filter_value, strlen (filter_value));
+            s_add_subscription_filter (remote_agent, batch_filter_value,
+                                       strlen (batch_filter_value));
+        }
+        // no filter may have been added, see s_add_compact_subscription_filter
+        if (remote_agent->peer->nb_filters == 0)
+            s_close_peer_subscriber (remote_agent->context, remote_agent->peer);
+    }
+}
+
+// True if a mapping element of our agent maps one of its inputs on an
+// output of a remote agent
+static bool s_map_element_is_active (igsagent_t *agent,
+                                     igs_remote_agent_t *remote_agent,
+                                     igs_map_t *el)
+{
+    if (!streq (remote_agent->definition->name, el->to_agent)
+        && !streq (el->to_agent, "*"))
+        return false;
+    // mapping element is compatible with subscriber name
+    // check if we find a compatible output in subscriber definition
+    igs_iop_t *found_output = NULL;
+    if (remote_agent->definition)
+        HASH_FIND_STR (remote_agent->definition->outputs_table,
+                       el->to_output, found_output);
+
+    // check if we find a valid input in our own definition
+    igs_iop_t *found_input = NULL;
+    if (agent->definition)
+        HASH_FIND_STR (agent->definition->inputs_table,
+                       el->from_input, found_input);
+
+    // check type compatibility between input and output value types
+    // including implicit conversions
+    return (found_output && found_input
+            && mapping_check_input_output_compatibility (agent, found_input,
+                                                         found_output));
+}
+
+// True if a subscription filter of a remote agent stands for a topic, given
+// as in s_subscribe_to_remote_agent_output. Protocol v5 filters are
+// compared whatever their marker, which depends on the shm ring reader.
+static bool s_filter_matches_topic (igs_mapping_filter_t *filter,
+                                    const char *topic)
+{
+    if (filter->length == PUBLICATION_V5_TOPIC_LENGTH
+        && ((byte) filter->filter[0] == PUBLICATION_V5_MARKER
+            || (byte) filter->filter[0] == PUBLICATION_SHM_MARKER)) {
+        byte compact_topic[PUBLICATION_V5_TOPIC_LENGTH];
+        s_write_compact_topic (compact_topic, s_topic_id (topic));
+        return (memcmp (filter->filter + 1, compact_topic + 1,
+                        PUBLICATION_V5_TOPIC_LENGTH - 1) == 0);
+    }
+    return (filter->length == strlen (topic)
+            && memcmp (filter->filter, topic, filter->length) == 0);
+}
+
+// Removes from the subscriber of its peer the filters of a remote agent
+// which are not used by the mappings of our agents anymore. The subscriber
+// is closed with the last filter of the peer.
+static void s_unsubscribe_to_unmapped_outputs (igs_core_context_t *context,
+                                               igs_remote_agent_t *remote_agent)
+{
+    char topic[IGS_MAX_IOP_NAME_LENGTH + IGS_AGENT_UUID_LENGTH + 1] = "";
+    char batch_topic[IGS_AGENT_UUID_LENGTH + 2] = "";
+    snprintf (batch_topic, IGS_AGENT_UUID_LENGTH + 2, "%s%s",
+              remote_agent->uuid, PUBLICATION_BATCH_SUFFIX);
+    igs_mapping_filter_t *filter, *filter_tmp;
+    DL_FOREACH_SAFE (remote_agent->mapping_filters, filter, filter_tmp)
+    {
+        bool is_used = false;
+        igsagent_t *agent, *tmp;
+        HASH_ITER (hh, context->agents, agent, tmp){
+            if (!agent->mapping)
+                continue;
+            igs_map_t *el, *el_tmp;
+            HASH_ITER (hh, agent->mapping->map_elements, el, el_tmp){
+                if (!s_map_element_is_active (agent, remote_agent, el))
+                    continue;
+                snprintf (topic, IGS_MAX_IOP_NAME_LENGTH + IGS_AGENT_UUID_LENGTH + 1,
+                          "%s-%s", remote_agent->uuid, el->to_output);
+                if (s_filter_matches_topic (filter, batch_topic)
+                    || s_filter_matches_topic (filter, topic)) {
+                    is_used = true;
+                    break;
+                }
+            }
+            if (is_used)
+                break;
+        }
+        if (!is_used) {
+            igs_debug ("unsubscribe from a filter of agent %s",
+                       remote_agent->definition->name);
+            s_receiver_send_filter (remote_agent, RECEIVER_UNSUBSCRIBE,
+                                    filter->filter, filter->length);
+            DL_DELETE (remote_agent->mapping_filters, filter);
+            free (filter->filter);
+            free (filter);
+            s_remove_peer_filter (remote_agent);
         }
     }
 }
@@ -391,48 +1505,28 @@ int s_network_configure_mapping_to_remote_agent (
     if (agent->mapping) {
         HASH_ITER (hh, agent->mapping->map_elements, el, tmp)
         {
-            if (streq (remote_agent->definition->name, el->to_agent)
-                || streq (el->to_agent, "*")) {
-                // mapping element is compatible with subscriber name
-                // check if we find a compatible output in subscriber definition
-                igs_iop_t *found_output = NULL;
-                if (remote_agent->definition)
-                    HASH_FIND_STR (remote_agent->definition->outputs_table,
-                                   el->to_output, found_output);
-
-                // check if we find a valid input in our own definition
-                igs_iop_t *found_input = NULL;
-                if (agent->definition)
-                    HASH_FIND_STR (agent->definition->inputs_table,
-                                   el->from_input, found_input);
-
-                // check type compatibility between input and output value types
-                // including implicit conversions
-                if (found_output && found_input
-                    && mapping_check_input_output_compatibility (
-                      agent, found_input, found_output)) {
-                    // we have validated input, agent and output names : we can map
-                    // NOTE: the call below may happen several times if our agent uses
-                    // the remote agent ouput on several of its inputs. This should not
-                    // have any consequence.
-                    s_subscribe_to_remote_agent_output (remote_agent,
-                                                        el->to_output);
-
-                    // mapping was successful : we set timer to notify remote agent if not
-                    // already done
-                    if (!remote_agent->shall_send_outputs_request
-                        && agent->network_request_outputs_from_mapped_agents) {
-                        remote_agent->shall_send_outputs_request = true;
-                        remote_agent->timer_id = zloop_timer (
-                          core_context->loop, NOTIFY_REMOTE_AGENT_TIMER, 1,
-                          s_trigger_outputs_request_to_newcomer, remote_agent);
-                    }
+            if (s_map_element_is_active (agent, remote_agent, el)) {
+                // we have validated input, agent and output names : we can map
+                // NOTE: the call below may happen several times if our agent uses
+                // the remote agent ouput on several of its inputs. This should not
+                // have any consequence.
+                s_subscribe_to_remote_agent_output (remote_agent,
+                                                    el->to_output);
+
+                // mapping was successful : we set timer to notify remote agent if not
+                // already done
+                if (!remote_agent->shall_send_outputs_request
+                    && agent->network_request_outputs_from_mapped_agents) {
+                    remote_agent->shall_send_outputs_request = true;
+                    remote_agent->timer_id = loop_timer (
+                      core_context->loop, NOTIFY_REMOTE_AGENT_TIMER, 1,
+                      s_trigger_outputs_request_to_newcomer, remote_agent);
                 }
-                // NOTE: we do not clean subscriptions here because we cannot check if
-                // an output is not used in another mapping element
             }
         }
     }
+    // filters of outputs not mapped anymore by any of our agents are removed
+    s_unsubscribe_to_unmapped_outputs (remote_agent->context, remote_agent);
     return 0;
 }
 
@@ -620,2120 +1714,2374 @@ void s_clean_and_free_remote_agent (igs_remote_agent_t **remote_agent)
         mapping_free_mapping (&(*remote_agent)->mapping);
 
     // clean the remote_agent itself
+    igs_remote_topic_t *remote_topic, *remote_topic_tmp;
+    HASH_ITER (hh, (*remote_agent)->context->remote_topics, remote_topic, remote_topic_tmp){
+        if (remote_topic->remote_agent == *remote_agent) {
+            HASH_DEL ((*remote_agent)->context->remote_topics, remote_topic);
+            free (remote_topic->output_name);
+            free (remote_topic);
+        }
+    }
+    s_receiver_send_for_agent (*remote_agent,
+                               s_receiver_command_new (RECEIVER_REMOVE_AGENT));
     igs_mapping_filter_t *elt, *tmp;
     DL_FOREACH_SAFE ((*remote_agent)->mapping_filters, elt, tmp)
     {
-        zsock_set_unsubscribe ((*remote_agent)->peer->subscriber, elt->filter);
+        s_receiver_send_filter (*remote_agent, RECEIVER_UNSUBSCRIBE,
+                                elt->filter, elt->length);
         DL_DELETE ((*remote_agent)->mapping_filters, elt);
         free (elt->filter);
         free (elt);
+        s_remove_peer_filter (*remote_agent);
     }
     if ((*remote_agent)->uuid)
         free ((*remote_agent)->uuid);
     if ((*remote_agent)->context->loop
         && (*remote_agent)->timer_id > 0) {
-        zloop_timer_end ((*remote_agent)->context->loop,
-                         (*remote_agent)->timer_id);
+        loop_timer_end ((*remote_agent)->context->loop,
+                        (*remote_agent)->timer_id);
         (*remote_agent)->timer_id = -2;
     }
     free (*remote_agent);
     *remote_agent = NULL;
 }
 
-// manage messages received on the private channel
-int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
+// Results of WHISPER message handlers: rejected messages skip the zyre
+// callbacks, like messages stopping our loop
+#define WHISPER_HANDLED 0
+#define WHISPER_REJECTED 1
+#define WHISPER_STOP_LOOP -1
+
+// WHISPER message handlers parse the message, whose title has already
+// been popped, and may consume it
+typedef int (igs_whisper_handler_fn) (igs_core_context_t *context,
+                                      const char *name,
+                                      const char *peerUUID,
+                                      const char *title,
+                                      zmsg_t *msg);
+typedef struct igs_whisper_handler {
+    const char *title;
+    igs_whisper_handler_fn *handler;
+    UT_hash_handle hh;
+} igs_whisper_handler_t;
+
+static int s_handle_remote_peer_knows_agent (igs_core_context_t *context,
+                                             const char *name,
+                                             const char *peerUUID,
+                                             const char *title,
+                                             zmsg_t *msg)
 {
-    IGS_UNUSED (socket)
-    igs_core_context_t *context = (igs_core_context_t *) arg;
-    assert (context);
-    zyre_t *node = context->node;
-    assert (node);
+    // distant peer has received one of our agents definition
+    // => all agents in this peer know us
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error (
+          "no valid uuid in %s message received from %s(%s): rejecting",
+          title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent) {
+        igs_agent_event_wrapper_t *cb;
+        DL_FOREACH (agent->agent_event_callbacks, cb)
+        {
+            // iterate on all remote agents *for this peer* : all its agents know
+            // this agent
+            igs_remote_agent_t *r, *rtmp;
+            HASH_ITER (hh, core_context->remote_agents, r, rtmp)
+            {
+                if (streq (r->peer->peer_id, peerUUID))
+                    cb->callback_ptr (agent, IGS_AGENT_KNOWS_US,
+                                      r->uuid, r->definition->name,
+                                      NULL, cb->my_data);
+            }
+        }
+    } // else agent has disappeared on our side (disabled or destroyed)
+    free (uuid);
+    return WHISPER_HANDLED;
+}
 
-    zyre_event_t *zyre_event = zyre_event_new (node);
-    const char *event = zyre_event_type (zyre_event);
-    const char *peerUUID = zyre_event_peer_uuid (zyre_event);
-    const char *name = zyre_event_peer_name (zyre_event);
-    const char *address = zyre_event_peer_addr (zyre_event);
-    zhash_t *headers = zyre_event_headers (zyre_event);
-    const char *group = zyre_event_group (zyre_event);
-    zmsg_t *msg = zyre_event_msg (zyre_event);
-    zmsg_t *msg_duplicate = zmsg_dup (msg);
+static int s_handle_external_definition (igs_core_context_t *context,
+                                         const char *name,
+                                         const char *peerUUID,
+                                         const char *title,
+                                         zmsg_t *msg)
+{
+    // identify remote agent or create it if unknown.
+    // NB: we suppose that remote agent creation is achieved when
+    // the agent sends its definition for the first time.
+    // Agents without definition are considered impossible.
+    char *str_definition = zmsg_popstr (msg);
+    if (str_definition == NULL) {
+        igs_error ("no valid definition in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error (
+          "no valid uuid in %s message received from %s(%s): rejecting",
+          title, name, peerUUID);
+        free (str_definition);
+        return WHISPER_REJECTED;
+    }
+    char *remote_agent_name = zmsg_popstr (msg);
+    if (remote_agent_name == NULL) {
+        igs_error ("no valid agent name in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (str_definition);
+        free (uuid);
+        return WHISPER_REJECTED;
+    }
 
-    // parse event
-    if (streq (event, "ENTER")) {
-        igs_debug (
-          "->%s has entered the network with peer id %s and endpoint %s", name,
-          peerUUID, address);
-        igs_zyre_peer_t *zyre_peer = NULL;
-        HASH_FIND_STR (context->zyre_peers, peerUUID, zyre_peer);
-        if (zyre_peer == NULL) {
-            zyre_peer = (igs_zyre_peer_t *) zmalloc (sizeof (igs_zyre_peer_t));
-            zyre_peer->peer_id = s_strndup (peerUUID, IGS_MAX_PEER_ID_LENGTH);
-            HASH_ADD_STR (context->zyre_peers, peer_id, zyre_peer);
-            zyre_peer->name = s_strndup (name, IGS_MAX_AGENT_NAME_LENGTH);
-            zlist_t *keys = zhash_keys (headers);
-            size_t s = zlist_size (keys);
-            if (s > 0) {
-                igs_debug ("Handling headers for peer %s (%s)", name, peerUUID);
-                char *k = zlist_first (keys);
-                const char *v;
-                while (k) {
-                    v = zyre_event_header (zyre_event, k);
-                    igs_debug ("\t%s -> %s", k, v);
-                    k = zlist_next (keys);
-                }
-                zlist_destroy (&keys);
-            }
+    // Load definition from string content
+    igs_definition_t *new_definition =
+      parser_load_definition (str_definition);
+    if (new_definition && new_definition->name) {
+        bool is_agent_new = false;
+        igs_remote_agent_t *remote_agent = NULL;
+        HASH_FIND_STR (context->remote_agents, uuid, remote_agent);
+        if (remote_agent == NULL) {
+            remote_agent = (igs_remote_agent_t *) zmalloc (
+              sizeof (igs_remote_agent_t));
+            remote_agent->context = context;
+            remote_agent->uuid = strdup (uuid);
+            igs_zyre_peer_t *zyre_peer = NULL;
+            HASH_FIND_STR (context->zyre_peers, peerUUID, zyre_peer);
+            assert (zyre_peer);
+            remote_agent->peer = zyre_peer;
+            remote_agent->definition = new_definition;
+            HASH_ADD_STR (context->remote_agents, uuid, remote_agent);
+            igs_debug ("registering agent %s(%s)", uuid,
+                       remote_agent_name);
+            is_agent_new = true;
+        }
+        else {
+            // else we already know this agent, its definition (possibly including
+            // name) has been updated
+            igs_debug (
+              "Definition already exists for remote agent %s : new "
+              "definition will overwrite the previous one...",
+              remote_agent->definition->name);
+            if (strneq (remote_agent->definition->name,
+                        new_definition->name))
+                igs_debug (
+                  "Remote agent is changing name from %s to %s",
+                  remote_agent->definition->name, new_definition->name);
 
-            const char *peer_public_key = zyre_event_header (zyre_event, "X-PUBLICKEY");
-            const char *protocol_version = zyre_event_header (zyre_event, "protocol");
-            if (protocol_version)
-                zyre_peer->protocol = s_strndup (protocol_version, 16);
+            igs_definition_t *old_def = remote_agent->definition;
+            remote_agent->definition = new_definition;
+            definition_free_definition (&old_def);
+        }
+        assert (remote_agent);
+        s_receiver_send_agent (remote_agent);
+
+        igs_debug ("store definition for remote agent %s(%s)",
+                   remote_agent->definition->name, remote_agent->uuid);
+        // Check the involvement of this new remote agent and its definition in
+        // our agent mappings and update subscriptions. We check here because
+        // remote agent definition is required to handle received data.
+        igsagent_t *agent, *tmp;
+        HASH_ITER (hh, context->agents, agent, tmp)
+            s_network_configure_mapping_to_remote_agent (agent, remote_agent);
+
+        if (is_agent_new) {
+            s_agent_propagate_agent_event (IGS_AGENT_ENTERED, uuid,
+                                           remote_agent_name, NULL);
+
+            // Additonal notification flag means that the remote agent has been
+            // started during runtime: remote peer init has already been done and
+            // this remote agent knows our agents already => propagate to our
+            // agents immediately.
+            char *notification = zmsg_popstr (msg);
+            if (notification) {
+                s_agent_propagate_agent_event (IGS_AGENT_KNOWS_US, uuid,
+                                               remote_agent_name, NULL);
+                free (notification);
+            }
 
-            const char *publisher_port = zyre_event_header (zyre_event, "publisher");
-            if (publisher_port) {
-                // we extract the publisher adress to subscribe to from the zyre message
-                // header
-                char endpoint_address[128];
-                strncpy (endpoint_address, address, 127);
+            // notify remote agent that our agents knows it
+            s_lock_zyre_peer (__FUNCTION__, __LINE__);
+            zmsg_t *msg_know = zmsg_new ();
+            zmsg_addstr (msg_know, REMOTE_PEER_KNOWS_AGENT_MSG);
+            zmsg_addstr (msg_know, uuid);
+            zyre_whisper (context->node, peerUUID, &msg_know);
+            s_unlock_zyre_peer (__FUNCTION__, __LINE__);
 
-                // IP adress extraction
-                char *insert = endpoint_address + strlen (endpoint_address);
-                bool extractOK = true;
-                while (*insert != ':') {
-                    insert--;
-                    if (insert == endpoint_address) {
-                        igs_error ("Could not extract port from address %s", address);
-                        extractOK = false;
+            // Send ready message for splitter creation if a split exist with
+            // the new remote agent.
+            igsagent_t *elt_agent, *tmp_agent;
+            HASH_ITER (hh, context->agents, elt_agent, tmp_agent)
+            {
+                bool found_split_element = false;
+                char *input_split_element;
+                char *output_split_element;
+                igs_split_t *elt, *tmp_split;
+                HASH_ITER (hh, elt_agent->mapping->split_elements,
+                           elt, tmp_split)
+                {
+                    if (elt
+                        && streq (elt->to_agent,
+                                  remote_agent->definition->name)) {
+                        found_split_element = true;
+                        input_split_element = elt->from_input;
+                        output_split_element = elt->to_output;
                         break;
                     }
                 }
+                if (found_split_element) {
+                    zmsg_t *ready_message = zmsg_new ();
+                    zmsg_addstr (ready_message, WORKER_HELLO_MSG);
+                    zmsg_addstr (ready_message, elt_agent->uuid);
+                    zmsg_addstr (ready_message, input_split_element);
+                    zmsg_addstr (ready_message,
+                                 output_split_element);
+                    zmsg_addstrf (ready_message, "%i",
+                                  IGS_DEFAULT_WORKER_CREDIT);
+                    igs_channel_whisper_zmsg (remote_agent->uuid,
+                                              &ready_message);
+                }
+            }
+        }
+        else
+            s_agent_propagate_agent_event (IGS_AGENT_UPDATED_DEFINITION,
+                                           uuid, remote_agent_name,
+                                           NULL);
+    }
+    else {
+        if (new_definition && !new_definition->name)
+            igs_error (
+              "received definition from remote agent %s(%s) does not "
+              "contain a name : rejecting",
+              remote_agent_name, uuid);
+        else
+            igs_error ("received definition from remote agent %s(%s) "
+                       "is empty or "
+                       "invalid : agent will not be registered",
+                       remote_agent_name, uuid);
+    }
+    free (str_definition);
+    free (uuid);
+    free (remote_agent_name);
+    return WHISPER_HANDLED;
+}
 
-                if (extractOK) {
-                    // we found a possible publisher to subscribe to
-                    *(insert + 1) =
-                      '\0'; // close endpoint_address string after ':' location
+static int s_handle_external_mapping (igs_core_context_t *context,
+                                      const char *name,
+                                      const char *peerUUID,
+                                      const char *title,
+                                      zmsg_t *msg)
+{
+    // identify remote agent
+    char *str_mapping = zmsg_popstr (msg);
+    if (str_mapping == NULL) {
+        igs_error ("no valid mapping in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error (
+          "uuid is NULL in %s message received from %s(%s): rejecting",
+          title, name, peerUUID);
+        free (str_mapping);
+        return WHISPER_REJECTED;
+    }
+    igs_remote_agent_t *remote_agent = NULL;
+    HASH_FIND_STR (context->remote_agents, uuid, remote_agent);
+    if (remote_agent == NULL) {
+        igs_error ("no known remote agent with uuid '%s': rejecting",
+                   uuid);
+        free (str_mapping);
+        free (uuid);
+        return WHISPER_REJECTED;
+    }
 
-                    // check towards our own ip address (without port)
-                    char *incoming_ip_address =
-                      endpoint_address + 6; // ignore tcp://
-                    *insert = '\0';
-                    bool useIPC = false;
-                    bool use_inproc = false;
-                    const char *ipc_address = NULL;
-                    const char *inproc_address = NULL;
-                    if (streq (context->ip_address, incoming_ip_address)) {
-                        // same IP address : we can try to use ipc (or loopback on windows)
-                        // instead of TCP or we can use inproc if both agents are in the same
-                        // process
-                        int pid = atoi (zyre_event_header (zyre_event, "pid"));
-                        if (context->process_id == pid) {
-                            // FIXME: certainly useless with new architecture
-                            // same ip address and same process : we can use inproc
-                            inproc_address = zyre_event_header (zyre_event, "inproc");
-                            if (inproc_address) {
-                                use_inproc = true;
-                                igs_debug ("Use address %s to subscribe to %s", inproc_address, name);
-                            }
-                        }
-                        else {
-                            // try to recover agent ipc/loopback address
-#if defined(__UNIX__)
-                            ipc_address = zyre_event_header (zyre_event, "ipc");
-#elif defined(__WINDOWS__)
-                            ipc_address = zyre_event_header (zyre_event, "loopback");
-#endif
-                            if (ipc_address) {
-                                useIPC = true;
-                                igs_debug ("Use address %s to subscribe to %s", ipc_address, name);
-                            }
-                        }
-                    }
-                    *insert = ':';
-                    // add port to the endpoint to compose it fully
-                    strcat (endpoint_address, publisher_port);
-                    if (context->network_allow_inproc && use_inproc) {
-                        zyre_peer->subscriber = zsock_new_sub (inproc_address, NULL);
-                        zsock_set_rcvhwm (zyre_peer->subscriber, context->network_hwm_value);
-                        igs_debug ("Subscription created for %s at %s (inproc)",
-                                   zyre_peer->name, inproc_address);
-                    }
-                    else
-                    if (context->network_allow_ipc && useIPC) {
-                        zyre_peer->subscriber = zsock_new_sub (ipc_address, NULL);
-                        zsock_set_rcvhwm (zyre_peer->subscriber, context->network_hwm_value);
-                        igs_debug ("Subscription created for %s at %s (ipc)",
-                                   zyre_peer->name, ipc_address);
-                    }
-                    else {
-                        zyre_peer->subscriber = zsock_new_sub (endpoint_address, NULL);
-                        zsock_set_rcvhwm (zyre_peer->subscriber, context->network_hwm_value);
-                        igs_debug ("Subscription created for %s at %s (tcp)",
-                                   zyre_peer->name, endpoint_address);
-                    }
-                    assert (zyre_peer->subscriber);
+    igs_mapping_t *new_mapping = NULL;
+    if (strlen (str_mapping) > 0) {
+        // load mapping from string content
+        new_mapping = parser_load_mapping (str_mapping);
+        if (new_mapping == NULL)
+            igs_error ("received mapping for agent %s(%s) could not be "
+                       "parsed properly",
+                       remote_agent->definition->name,
+                       remote_agent->uuid);
+    }
+    else {
+        igs_debug ("received mapping from agent %s(%s) is empty",
+                   remote_agent->definition->name, remote_agent->uuid);
+        if (remote_agent && remote_agent->mapping) {
+            mapping_free_mapping (&remote_agent->mapping);
+            remote_agent->mapping = NULL;
+            s_agent_propagate_agent_event (
+              IGS_AGENT_UPDATED_MAPPING, uuid,
+              remote_agent->definition->name, NULL);
+        }
+    }
 
-                    if (context->security_is_enabled && peer_public_key) {
-                        zcert_apply (context->security_cert, zyre_peer->subscriber);
-                        zsock_set_curve_serverkey (zyre_peer->subscriber, peer_public_key);
-                    }
-                    zloop_reader (loop, zyre_peer->subscriber, s_manage_remote_publication, context);
-                    zloop_reader_set_tolerant (loop, zyre_peer->subscriber);
-                }
-            }
-            zhash_t *headers_bis = zhash_dup (headers);
-            s_agent_propagate_agent_event (IGS_PEER_ENTERED, peerUUID, name, headers_bis);
-            zhash_destroy (&headers_bis);
+    if (new_mapping && remote_agent) {
+        // look if this agent already has a mapping
+        if (remote_agent->mapping) {
+            igs_debug (
+              "mapping already exists for agent %s(%s) : new mapping "
+              "will overwrite the previous one...",
+              remote_agent->definition->name, remote_agent->uuid);
+            mapping_free_mapping (&remote_agent->mapping);
         }
-        else {
-            // Agent already exists, we set its reconnected flag
-            //(this is used below to avoid agent destruction on EXIT received after
-            //timeout)
-            zyre_peer->reconnected++;
+
+        igs_debug ("store mapping for agent %s(%s)",
+                   remote_agent->definition->name, remote_agent->uuid);
+        remote_agent->mapping = new_mapping;
+        s_agent_propagate_agent_event (IGS_AGENT_UPDATED_MAPPING, uuid,
+                                       remote_agent->definition->name,
+                                       NULL);
+    }
+    free (str_mapping);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_load_definition (igs_core_context_t *context,
+                                     const char *name,
+                                     const char *peerUUID,
+                                     const char *title,
+                                     zmsg_t *msg)
+{
+    // identify agent
+    char *str_definition = zmsg_popstr (msg);
+    if (str_definition == NULL) {
+        igs_error ("no valid definition in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error (
+          "no valid uuid in %s message received from %s(%s): rejecting",
+          title, name, peerUUID);
+        free (str_definition);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from %s(%s): "
+          "rejecting",
+          uuid, title, name, peerUUID);
+        free (str_definition);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+
+    // load definition
+    if (igsagent_definition_load_str (agent, str_definition)
+        == IGS_SUCCESS) {
+        // recheck mapping towards our new definition
+        igs_remote_agent_t *remote, *tmp;
+        HASH_ITER (hh, context->remote_agents, remote, tmp)
+        {
+            s_network_configure_mapping_to_remote_agent (agent,
+                                                          remote);
         }
     }
-    else
-    if (streq (event, "JOIN")) {
-        igs_debug ("+%s has joined %s", name, group);
-        if (streq (group, IGS_PRIVATE_CHANNEL)) {
-            // send information for all our agents to the newcomer
-            igs_zyre_peer_t *zyre_peer = NULL;
-            HASH_FIND_STR (context->zyre_peers, peerUUID, zyre_peer);
-            assert (zyre_peer);
+    free (str_definition);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
 
-            igsagent_t *agent, *tmp;
-            char *definition_str = NULL;
-            char *mapping_str = NULL;
-            HASH_ITER (hh, context->agents, agent, tmp)
-            {
-                // definition is sent to every newcomer on the channel (whether it is a
-                // ingescape agent or not)
-                if (zyre_peer->protocol
-                    && (streq (zyre_peer->protocol, "v2")
-                        || streq (zyre_peer->protocol, "v3")))
-                    definition_str = parser_export_definition_legacy (agent->definition);
-                else
-                    definition_str =
-                      parser_export_definition (agent->definition);
-                if (definition_str) {
-                    s_send_definition_to_zyre_peer (agent, peerUUID,
-                                                    definition_str, false);
-                    free (definition_str);
-                    definition_str = NULL;
-                }
-                else
-                    s_send_definition_to_zyre_peer (agent, peerUUID, "", false);
-                // and so is our mapping
-                if (zyre_peer->protocol && streq (zyre_peer->protocol, "v2"))
-                    mapping_str = parser_export_mapping_legacy (agent->mapping);
-                else
-                    mapping_str = parser_export_mapping (agent->mapping);
-                if (mapping_str) {
-                    s_send_mapping_to_zyre_peer (agent, peerUUID, mapping_str);
-                    free (mapping_str);
-                    mapping_str = NULL;
-                }
-                else
-                    s_send_mapping_to_zyre_peer (agent, peerUUID, "");
-                // and so is the state of our internal variables
-                s_send_state_to (agent, peerUUID, true);
-            }
-            zyre_peer->has_joined_private_channel = true;
+static int s_handle_load_mapping (igs_core_context_t *context,
+                                  const char *name,
+                                  const char *peerUUID,
+                                  const char *title,
+                                  zmsg_t *msg)
+{
+    // identify agent
+    char *str_mapping = zmsg_popstr (msg);
+    if (str_mapping == NULL) {
+        igs_error ("no valid mapping in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error (
+          "no valid uuid in %s message received from %s(%s): rejecting",
+          title, name, peerUUID);
+        free (str_mapping);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from %s(%s): "
+          "rejecting",
+          uuid, title, name, peerUUID);
+        free (str_mapping);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+
+    // Load mapping from string content
+    igs_mapping_t *new_mapping = parser_load_mapping (str_mapping);
+    if (new_mapping) {
+        model_read_write_lock (__FUNCTION__, __LINE__);
+        if (agent->mapping) {
+            mapping_index_remove_all (agent);
+            mapping_free_mapping (&agent->mapping);
+        }
+        agent->mapping = new_mapping;
+        mapping_index_add_all (agent);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        // check and activate mapping
+        igs_remote_agent_t *remote, *tmp;
+        HASH_ITER (hh, context->remote_agents, remote, tmp)
+        {
+            s_network_configure_mapping_to_remote_agent (agent,
+                                                          remote);
         }
+        agent->network_need_to_send_mapping_update = true;
     }
-    else
-    if (streq (event, "SHOUT")) {
-        if (streq (group, context->replay_channel)) {
-            // this is a replay message for one of our inputs
-            char *agent_name = zmsg_popstr (msg_duplicate);
-            char *input = zmsg_popstr (msg_duplicate);
-            if (agent_name == NULL) {
-                igs_error ("agent name is NULL for replay message from %s(%s): "
-                           "rejecting",
-                           name, peerUUID);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
-            if (input == NULL) {
-                igs_error (
-                  "input is NULL for replay message from %s(%s): rejecting",
-                  name, peerUUID);
-                free (agent_name);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
+    free (str_mapping);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
 
-            char *value = NULL;
-            zframe_t *frame = NULL;
-            void *data = NULL;
-            size_t size = 0;
-            igsagent_t *target_agent, *targettmp;
-            HASH_ITER (hh, context->agents, target_agent, targettmp)
-            {
-                if (streq (agent_name, target_agent->definition->name)) {
-                    igs_iop_value_type_t input_type =
-                      igsagent_input_type (target_agent, input);
-                    if (zmsg_size (msg_duplicate) > 0) {
-                        igs_debug ("replaying %s.%s", agent_name, input);
-                        if (input_type == IGS_STRING_T) {
-                            value = zmsg_popstr (msg_duplicate);
-                            if (value == NULL) {
-                                igs_error ("value is NULL for replay message "
-                                           "from %s(%s): rejecting",
-                                           name, peerUUID);
-                                free (agent_name);
-                                free (input);
-                                zmsg_destroy (&msg_duplicate);
-                                zyre_event_destroy (&zyre_event);
-                                return 0;
-                            }
-                            igsagent_input_set_string (target_agent, input,
-                                                        value);
-                            free (value);
-                        }
-                        else {
-                            frame = zmsg_pop (msg_duplicate);
-                            if (frame == NULL) {
-                                igs_error ("value is NULL for replay message "
-                                           "from %s(%s): rejecting",
-                                           name, peerUUID);
-                                free (agent_name);
-                                free (input);
-                                zmsg_destroy (&msg_duplicate);
-                                zyre_event_destroy (&zyre_event);
-                                return 0;
-                            }
-                            data = zframe_data (frame);
-                            size = zframe_size (frame);
-                            model_write_iop (target_agent, input, IGS_INPUT_T,
-                                             input_type, data, size);
-                            zframe_destroy (&frame);
-                        }
-                    }
-                    else
-                        igsagent_error (target_agent,
-                                         "replay message for input %s is not "
-                                         "correct and was ignored",
-                                         input);
-                }
-            }
-            free (agent_name);
-            free (input);
+static int s_handle_get_current_outputs (igs_core_context_t *context,
+                                         const char *name,
+                                         const char *peerUUID,
+                                         const char *title,
+                                         zmsg_t *msg)
+{
+    // identify agent
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        free (uuid);
+        return WHISPER_REJECTED;
+    }
+    model_agent_read_lock (agent);
+    zmsg_t *msg_to_send = zmsg_new ();
+    zmsg_addstr (msg_to_send, CURRENT_OUTPUTS_MSG);
+    zmsg_addstr (msg_to_send, agent->uuid);
+    igs_iop_t *outputs = agent->definition->outputs_table;
+    igs_iop_t *current = NULL;
+    for (current = outputs; current;
+         current = current->hh.next) {
+        switch (current->value_type) {
+            case IGS_INTEGER_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, &(current->value.i),
+                             sizeof (int));
+                break;
+            case IGS_DOUBLE_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, &(current->value.d),
+                             sizeof (double));
+                break;
+            case IGS_STRING_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addstr (msg_to_send, current->value.s);
+                break;
+            case IGS_BOOL_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, &(current->value.b),
+                             sizeof (bool));
+                break;
+            case IGS_IMPULSION_T:
+                // FIXME: we had to disable outputs sending for data and impulsions
+                // but this is not consistent with inputs and parameters disabled
+                //                                    zmsg_addstr(msg_to_send,
+                //                                    found_iop->name);
+                //                                    zmsg_addstrf(msg_to_send,
+                //                                    "%d", found_iop->value_type);
+                //                                    zmsg_addmem(msg_to_send, NULL,
+                //                                    0);
+                break;
+            case IGS_DATA_T:
+                // disabled
+                //                                    zmsg_addstr(msg_to_send,
+                //                                    found_iop->name);
+                //                                    zmsg_addstrf(msg_to_send,
+                //                                    "%d", found_iop->value_type);
+                //                                    zmsg_addmem(msg_to_send,
+                //                                    (found_iop->value.data),
+                //                                    found_iop->value_size);
+                break;
+
+            default:
+                break;
+        }
+    }
+    model_agent_read_unlock (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    s_lock_zyre_peer (__FUNCTION__, __LINE__);
+    igs_debug ("send output values to %s", peerUUID);
+    zyre_whisper (context->node, peerUUID, &msg_to_send);
+    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_current_outputs (igs_core_context_t *context,
+                                     const char *name,
+                                     const char *peerUUID,
+                                     const char *title,
+                                     zmsg_t *msg)
+{
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igs_remote_agent_t *remote_agent = NULL;
+    HASH_FIND_STR (context->remote_agents, uuid, remote_agent);
+    if (remote_agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+    igs_debug ("privately received output values from %s (%s)",
+               remote_agent->definition->name, remote_agent->uuid);
+    s_handle_publication_from_remote_agent (msg,
+                                          remote_agent);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_get_current_inputs (igs_core_context_t *context,
+                                        const char *name,
+                                        const char *peerUUID,
+                                        const char *title,
+                                        zmsg_t *msg)
+{
+    // identify agent
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        free (uuid);
+        return WHISPER_REJECTED;
+    }
+    model_agent_read_lock (agent);
+    zmsg_t *msg_to_send = zmsg_new ();
+    zmsg_addstr (msg_to_send, CURRENT_INPUTS_MSG);
+    zmsg_addstr (msg_to_send, agent->uuid);
+    igs_iop_t *outputs = agent->definition->inputs_table;
+    igs_iop_t *current = NULL;
+    for (current = outputs; current;
+         current = current->hh.next) {
+        switch (current->value_type) {
+            case IGS_INTEGER_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, &(current->value.i),
+                             sizeof (int));
+                break;
+            case IGS_DOUBLE_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, &(current->value.d),
+                             sizeof (double));
+                break;
+            case IGS_STRING_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addstr (msg_to_send, current->value.s);
+                break;
+            case IGS_BOOL_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, &(current->value.b),
+                             sizeof (bool));
+                break;
+            case IGS_IMPULSION_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, NULL, 0);
+                break;
+            case IGS_DATA_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, (current->value.data),
+                             current->value_size);
+                break;
+
+            default:
+                break;
+        }
+    }
+    model_agent_read_unlock (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    s_lock_zyre_peer (__FUNCTION__, __LINE__);
+    igs_debug ("send input values to %s", peerUUID);
+    zyre_whisper (context->node, peerUUID, &msg_to_send);
+    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_get_current_parameters (igs_core_context_t *context,
+                                            const char *name,
+                                            const char *peerUUID,
+                                            const char *title,
+                                            zmsg_t *msg)
+{
+    // identify agent
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!agent || !(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        free (uuid);
+        return WHISPER_REJECTED;
+    }
+    model_agent_read_lock (agent);
+    zmsg_t *msg_to_send = zmsg_new ();
+    zmsg_addstr (msg_to_send, CURRENT_PARAMETERS_MSG);
+    zmsg_addstr (msg_to_send, agent->uuid);
+    igs_iop_t *outputs = agent->definition->params_table;
+    igs_iop_t *current = NULL;
+    for (current = outputs; current;
+         current = current->hh.next) {
+        switch (current->value_type) {
+            case IGS_INTEGER_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, &(current->value.i),
+                             sizeof (int));
+                break;
+            case IGS_DOUBLE_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, &(current->value.d),
+                             sizeof (double));
+                break;
+            case IGS_STRING_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addstr (msg_to_send, current->value.s);
+                break;
+            case IGS_BOOL_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, &(current->value.b),
+                             sizeof (bool));
+                break;
+            case IGS_IMPULSION_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, NULL, 0);
+                break;
+            case IGS_DATA_T:
+                zmsg_addstr (msg_to_send, current->name);
+                zmsg_addstrf (msg_to_send, "%d",
+                              current->value_type);
+                zmsg_addmem (msg_to_send, (current->value.data),
+                             current->value_size);
+                break;
+
+            default:
+                break;
+        }
+    }
+    model_agent_read_unlock (agent);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    s_lock_zyre_peer (__FUNCTION__, __LINE__);
+    igs_debug ("send parameters values to %s", peerUUID);
+    zyre_whisper (context->node, peerUUID, &msg_to_send);
+    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_start_agent (igs_core_context_t *context,
+                                 const char *name,
+                                 const char *peerUUID,
+                                 const char *title,
+                                 zmsg_t *msg)
+{
+    IGS_UNUSED (context)
+    char *agent_name = zmsg_popstr (msg);
+    if (agent_name == NULL) {
+        igs_error ("no agent name in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+
+    igs_debug ("received 'START_AGENT %s' command from %s (%s)",
+               agent_name, name, peerUUID);
+    igsagent_t *a = zhash_first (core_context->created_agents);
+    while (a) {
+        if (streq (a->definition->name, agent_name)) {
+            igs_info ("activating agent %s (%s)",
+                      a->definition->name, a->uuid);
+            igsagent_activate (a);
+        }
+        a = zhash_next (core_context->created_agents);
+    }
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_stop_agent (igs_core_context_t *context,
+                                const char *name,
+                                const char *peerUUID,
+                                const char *title,
+                                zmsg_t *msg)
+{
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+    igs_debug ("received 'STOP_AGENT %s' command from %s (%s)",
+               uuid, name, peerUUID);
+    igs_info ("deactivating agent %s (%s)", agent->definition->name,
+              agent->uuid);
+    igsagent_deactivate (agent);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_stop_peer (igs_core_context_t *context,
+                               const char *name,
+                               const char *peerUUID,
+                               const char *title,
+                               zmsg_t *msg)
+{
+    IGS_UNUSED (title)
+    IGS_UNUSED (msg)
+    context->external_stop = true;
+    igs_debug ("received STOP_PEER command from %s (%s)", name,
+               peerUUID);
+    // stop our zyre loop by returning -1 : this will start the cleaning
+    // process
+    return WHISPER_STOP_LOOP;
+}
+
+static int s_handle_clear_mapping (igs_core_context_t *context,
+                                   const char *name,
+                                   const char *peerUUID,
+                                   const char *title,
+                                   zmsg_t *msg)
+{
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+
+    igs_debug ("received CLEAR_MAPPING command from %s (%s)", name,
+               peerUUID);
+    igsagent_clear_mappings (agent);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_freeze (igs_core_context_t *context,
+                            const char *name,
+                            const char *peerUUID,
+                            const char *title,
+                            zmsg_t *msg)
+{
+    IGS_UNUSED (context)
+    IGS_UNUSED (title)
+    IGS_UNUSED (msg)
+    igs_debug ("received FREEZE command from %s (%s)", name,
+               peerUUID);
+    igs_freeze ();
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_unfreeze (igs_core_context_t *context,
+                              const char *name,
+                              const char *peerUUID,
+                              const char *title,
+                              zmsg_t *msg)
+{
+    IGS_UNUSED (context)
+    IGS_UNUSED (title)
+    IGS_UNUSED (msg)
+    igs_debug ("received UNFREEZE command from %s (%s)", name,
+               peerUUID);
+    igs_unfreeze ();
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_mute_all (igs_core_context_t *context,
+                              const char *name,
+                              const char *peerUUID,
+                              const char *title,
+                              zmsg_t *msg)
+{
+    IGS_UNUSED (title)
+    IGS_UNUSED (msg)
+    igs_debug ("received MUTE_ALL command from %s (%s)", name,
+               peerUUID);
+    igsagent_t *agent, *tmp;
+    HASH_ITER (hh, context->agents, agent, tmp)
+    {
+        igsagent_mute (agent);
+    }
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_unmute_all (igs_core_context_t *context,
+                                const char *name,
+                                const char *peerUUID,
+                                const char *title,
+                                zmsg_t *msg)
+{
+    IGS_UNUSED (title)
+    IGS_UNUSED (msg)
+    igs_debug ("received UNMUTE_ALL command from %s (%s)", name,
+               peerUUID);
+    igsagent_t *agent, *tmp;
+    HASH_ITER (hh, context->agents, agent, tmp)
+    {
+        igsagent_unmute (agent);
+    }
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_mute_agent (igs_core_context_t *context,
+                                const char *name,
+                                const char *peerUUID,
+                                const char *title,
+                                zmsg_t *msg)
+{
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+    igs_debug ("received MUTE_AGENT command from %s (%s)", name,
+               peerUUID);
+    igsagent_mute (agent);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_unmute_agent (igs_core_context_t *context,
+                                  const char *name,
+                                  const char *peerUUID,
+                                  const char *title,
+                                  zmsg_t *msg)
+{
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+    igs_debug ("received UNMUTE_AGENT command from %s (%s)", name,
+               peerUUID);
+    igsagent_unmute (agent);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_mute_output (igs_core_context_t *context,
+                                 const char *name,
+                                 const char *peerUUID,
+                                 const char *title,
+                                 zmsg_t *msg)
+{
+    char *iop_name = zmsg_popstr (msg);
+    if (iop_name == NULL) {
+        igs_error ("no valid iop name in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (iop_name);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        free (iop_name);
+        return WHISPER_REJECTED;
+    }
+
+    igs_debug ("received MUTE command from %s (%s)", name,
+               peerUUID);
+    igsagent_output_mute (agent, iop_name);
+    free (iop_name);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_unmute_output (igs_core_context_t *context,
+                                   const char *name,
+                                   const char *peerUUID,
+                                   const char *title,
+                                   zmsg_t *msg)
+{
+    char *iop_name = zmsg_popstr (msg);
+    if (iop_name == NULL) {
+        igs_error ("no valid iop name in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (iop_name);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        free (iop_name);
+        return WHISPER_REJECTED;
+    }
+
+    igs_debug ("received UNMUTE command from %s (%s)", name,
+               peerUUID);
+    igsagent_output_unmute (agent, iop_name);
+    free (iop_name);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_set_input (igs_core_context_t *context,
+                               const char *name,
+                               const char *peerUUID,
+                               const char *title,
+                               zmsg_t *msg)
+{
+    char *iop_name = zmsg_popstr (msg);
+    if (iop_name == NULL) {
+        igs_error ("no valid iop name in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *value = zmsg_popstr (msg);
+    if (value == NULL) {
+        igs_error ("no valid value in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (iop_name);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (iop_name);
+        free (value);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        free (iop_name);
+        free (value);
+        return WHISPER_REJECTED;
+    }
+
+    igs_debug ("received SET_INPUT command from %s (%s)", name,
+               peerUUID);
+    if (iop_name && value)
+        igsagent_input_set_string (agent, iop_name, value);
+    free (iop_name);
+    free (value);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_set_output (igs_core_context_t *context,
+                                const char *name,
+                                const char *peerUUID,
+                                const char *title,
+                                zmsg_t *msg)
+{
+    char *iop_name = zmsg_popstr (msg);
+    if (iop_name == NULL) {
+        igs_error ("no valid iop name in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *value = zmsg_popstr (msg);
+    if (value == NULL) {
+        igs_error ("no valid value in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (iop_name);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (iop_name);
+        free (value);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        free (iop_name);
+        free (value);
+        return WHISPER_REJECTED;
+    }
+
+    igs_debug ("received SET_OUTPUT command from %s (%s)", name,
+               peerUUID);
+    if (iop_name && value)
+        igsagent_output_set_string (agent, iop_name, value);
+    free (iop_name);
+    free (value);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_set_parameter (igs_core_context_t *context,
+                                   const char *name,
+                                   const char *peerUUID,
+                                   const char *title,
+                                   zmsg_t *msg)
+{
+    char *iop_name = zmsg_popstr (msg);
+    if (iop_name == NULL) {
+        igs_error ("no valid iop name in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *value = zmsg_popstr (msg);
+    if (value == NULL) {
+        igs_error ("no valid value in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (iop_name);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (iop_name);
+        free (value);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        free (iop_name);
+        free (value);
+        return WHISPER_REJECTED;
+    }
+
+    igs_debug ("received SET_PARAMETER command from %s (%s)", name,
+               peerUUID);
+    if (iop_name && value)
+        igsagent_parameter_set_string (agent, iop_name, value);
+    free (iop_name);
+    free (value);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_map (igs_core_context_t *context,
+                         const char *name,
+                         const char *peerUUID,
+                         const char *title,
+                         zmsg_t *msg)
+{
+    char *input = zmsg_popstr (msg);
+    if (input == NULL) {
+        igs_error ("no valid input in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *remote_agent = zmsg_popstr (msg);
+    if (remote_agent == NULL) {
+        igs_error (
+          "no valid agent name in %s message received from %s(%s): "
+          "rejecting",
+          title, name, peerUUID);
+        free (input);
+        return WHISPER_REJECTED;
+    }
+    char *output = zmsg_popstr (msg);
+    if (output == NULL) {
+        igs_error ("no valid output in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (input);
+        free (remote_agent);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (input);
+        free (remote_agent);
+        free (output);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        free (input);
+        free (remote_agent);
+        free (output);
+        return WHISPER_REJECTED;
+    }
 
-        }
-        else
-        if (streq (group, IGS_PRIVATE_CHANNEL)) {
-            char *title = zmsg_popstr (msg_duplicate);
-            if (streq (title, REMOTE_AGENT_EXIT_MSG)) {
-                char *uuid = zmsg_popstr (msg_duplicate);
-                igs_remote_agent_t *remote = NULL;
-                HASH_FIND_STR (context->remote_agents, uuid, remote);
-                if (remote) {
-                    igs_debug ("<-%s (%s) exited", remote->definition->name,
-                               uuid);
-                    split_remove_worker (context, uuid, NULL);
-                    HASH_DEL (context->remote_agents, remote);
-                    s_agent_propagate_agent_event (
-                      IGS_AGENT_EXITED, uuid, remote->definition->name, NULL);
-                    s_clean_and_free_remote_agent (&remote);
-                }
-                else
-                    igs_error ("%s is not a known remote agent", uuid);
-                if (uuid)
-                    free (uuid);
-            }
-            free (title);
-        }
+    igs_debug ("received MAP command from %s (%s)", name, peerUUID);
+    if (input && remote_agent && output)
+        igsagent_mapping_add (agent, input, remote_agent, output);
+    free (input);
+    free (remote_agent);
+    free (output);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_unmap (igs_core_context_t *context,
+                           const char *name,
+                           const char *peerUUID,
+                           const char *title,
+                           zmsg_t *msg)
+{
+    char *input = zmsg_popstr (msg);
+    if (input == NULL) {
+        igs_error ("no valid input in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *remote_agent = zmsg_popstr (msg);
+    if (remote_agent == NULL) {
+        igs_error (
+          "no valid agent name in %s message received from %s(%s): "
+          "rejecting",
+          title, name, peerUUID);
+        free (input);
+        return WHISPER_REJECTED;
+    }
+    char *output = zmsg_popstr (msg);
+    if (output == NULL) {
+        igs_error ("no valid output in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (input);
+        free (remote_agent);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (input);
+        free (remote_agent);
+        free (output);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        free (input);
+        free (remote_agent);
+        free (output);
+        return WHISPER_REJECTED;
     }
-    else
-    if (streq (event, "WHISPER")) {
-        char *title = zmsg_popstr (msg_duplicate);
-        if (title == NULL) {
-            igs_error ("no header in message received from %s(%s): rejecting",
-                       name, peerUUID);
-            zmsg_destroy (&msg_duplicate);
-            zyre_event_destroy (&zyre_event);
-            return 0;
-        }
 
-        if (streq (title, REMOTE_PEER_KNOWS_AGENT_MSG)) {
-            // distant peer has received one of our agents definition
-            // => all agents in this peer know us
-            char *uuid = zmsg_popstr (msg_duplicate);
-            if (uuid == NULL) {
-                igs_error (
-                  "no valid uuid in %s message received from %s(%s): rejecting",
-                  title, name, peerUUID);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
-            igsagent_t *agent = NULL;
-            HASH_FIND_STR (context->agents, uuid, agent);
-            if (agent) {
-                igs_agent_event_wrapper_t *cb;
-                DL_FOREACH (agent->agent_event_callbacks, cb)
-                {
-                    // iterate on all remote agents *for this peer* : all its agents know
-                    // this agent
-                    igs_remote_agent_t *r, *rtmp;
-                    HASH_ITER (hh, core_context->remote_agents, r, rtmp)
-                    {
-                        if (streq (r->peer->peer_id, peerUUID))
-                            cb->callback_ptr (agent, IGS_AGENT_KNOWS_US,
-                                              r->uuid, r->definition->name,
-                                              NULL, cb->my_data);
-                    }
-                }
-            } // else agent has disappeared on our side (disabled or destroyed)
+    igs_debug ("received UNMAP command from %s (%s)", name,
+               peerUUID);
+    if (input && remote_agent && output)
+        igsagent_mapping_remove_with_name (agent, input,
+                                            remote_agent, output);
+    free (input);
+    free (remote_agent);
+    free (output);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_add_split_entry (igs_core_context_t *context,
+                                     const char *name,
+                                     const char *peerUUID,
+                                     const char *title,
+                                     zmsg_t *msg)
+{
+    char *input = zmsg_popstr (msg);
+    if (input == NULL) {
+        igs_error ("no valid input in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *remote_agent = zmsg_popstr (msg);
+    if (remote_agent == NULL) {
+        igs_error (
+          "no valid agent name in %s message received from %s(%s): "
+          "rejecting",
+          title, name, peerUUID);
+        free (input);
+        return WHISPER_REJECTED;
+    }
+    char *output = zmsg_popstr (msg);
+    if (output == NULL) {
+        igs_error ("no valid output in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (input);
+        free (remote_agent);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (input);
+        free (remote_agent);
+        free (output);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
             free (uuid);
-        }
-        else
-        if (streq (title, EXTERNAL_DEFINITION_MSG)) {
-            // identify remote agent or create it if unknown.
-            // NB: we suppose that remote agent creation is achieved when
-            // the agent sends its definition for the first time.
-            // Agents without definition are considered impossible.
-            char *str_definition = zmsg_popstr (msg_duplicate);
-            if (str_definition == NULL) {
-                igs_error ("no valid definition in %s message received from "
-                           "%s(%s): rejecting",
-                           title, name, peerUUID);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
-            char *uuid = zmsg_popstr (msg_duplicate);
-            if (uuid == NULL) {
-                igs_error (
-                  "no valid uuid in %s message received from %s(%s): rejecting",
-                  title, name, peerUUID);
-                free (str_definition);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
-            char *remote_agent_name = zmsg_popstr (msg_duplicate);
-            if (remote_agent_name == NULL) {
-                igs_error ("no valid agent name in %s message received from "
-                           "%s(%s): rejecting",
-                           title, name, peerUUID);
-                free (str_definition);
-                free (uuid);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
+        free (input);
+        free (remote_agent);
+        free (output);
+        return WHISPER_REJECTED;
+    }
 
-            // Load definition from string content
-            igs_definition_t *new_definition =
-              parser_load_definition (str_definition);
-            if (new_definition && new_definition->name) {
-                bool is_agent_new = false;
-                igs_remote_agent_t *remote_agent = NULL;
-                HASH_FIND_STR (context->remote_agents, uuid, remote_agent);
-                if (remote_agent == NULL) {
-                    remote_agent = (igs_remote_agent_t *) zmalloc (
-                      sizeof (igs_remote_agent_t));
-                    remote_agent->context = context;
-                    remote_agent->uuid = strdup (uuid);
-                    igs_zyre_peer_t *zyre_peer = NULL;
-                    HASH_FIND_STR (context->zyre_peers, peerUUID, zyre_peer);
-                    assert (zyre_peer);
-                    remote_agent->peer = zyre_peer;
-                    remote_agent->definition = new_definition;
-                    HASH_ADD_STR (context->remote_agents, uuid, remote_agent);
-                    igs_debug ("registering agent %s(%s)", uuid,
-                               remote_agent_name);
-                    is_agent_new = true;
-                }
-                else {
-                    // else we already know this agent, its definition (possibly including
-                    // name) has been updated
-                    igs_debug (
-                      "Definition already exists for remote agent %s : new "
-                      "definition will overwrite the previous one...",
-                      remote_agent->definition->name);
-                    if (strneq (remote_agent->definition->name,
-                                new_definition->name))
-                        igs_debug (
-                          "Remote agent is changing name from %s to %s",
-                          remote_agent->definition->name, new_definition->name);
-
-                    igs_definition_t *old_def = remote_agent->definition;
-                    remote_agent->definition = new_definition;
-                    definition_free_definition (&old_def);
-                }
-                assert (remote_agent);
-
-                igs_debug ("store definition for remote agent %s(%s)",
-                           remote_agent->definition->name, remote_agent->uuid);
-                // Check the involvement of this new remote agent and its definition in
-                // our agent mappings and update subscriptions. We check here because
-                // remote agent definition is required to handle received data.
-                igsagent_t *agent, *tmp;
-                HASH_ITER (hh, context->agents, agent, tmp)
-                    s_network_configure_mapping_to_remote_agent (agent, remote_agent);
-
-                if (is_agent_new) {
-                    s_agent_propagate_agent_event (IGS_AGENT_ENTERED, uuid,
-                                                   remote_agent_name, NULL);
-
-                    // Additonal notification flag means that the remote agent has been
-                    // started during runtime: remote peer init has already been done and
-                    // this remote agent knows our agents already => propagate to our
-                    // agents immediately.
-                    char *notification = zmsg_popstr (msg_duplicate);
-                    if (notification) {
-                        s_agent_propagate_agent_event (IGS_AGENT_KNOWS_US, uuid,
-                                                       remote_agent_name, NULL);
-                        free (notification);
-                    }
+    igs_debug ("received ADD_SPLIT_ENTRY command from %s (%s)",
+               name, peerUUID);
+    if (input && remote_agent && output)
+        igsagent_split_add (agent, input, remote_agent, output);
+    free (input);
+    free (remote_agent);
+    free (output);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
 
-                    // notify remote agent that our agents knows it
-                    s_lock_zyre_peer (__FUNCTION__, __LINE__);
-                    zmsg_t *msg_know = zmsg_new ();
-                    zmsg_addstr (msg_know, REMOTE_PEER_KNOWS_AGENT_MSG);
-                    zmsg_addstr (msg_know, uuid);
-                    zyre_whisper (node, peerUUID, &msg_know);
-                    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
-
-                    // Send ready message for splitter creation if a split exist with
-                    // the new remote agent.
-                    igsagent_t *elt_agent, *tmp_agent;
-                    HASH_ITER (hh, context->agents, elt_agent, tmp_agent)
-                    {
-                        bool found_split_element = false;
-                        char *input_split_element;
-                        char *output_split_element;
-                        igs_split_t *elt, *tmp_split;
-                        HASH_ITER (hh, elt_agent->mapping->split_elements,
-                                   elt, tmp_split)
-                        {
-                            if (elt
-                                && streq (elt->to_agent,
-                                          remote_agent->definition->name)) {
-                                found_split_element = true;
-                                input_split_element = elt->from_input;
-                                output_split_element = elt->to_output;
-                                break;
-                            }
-                        }
-                        if (found_split_element) {
-                            zmsg_t *ready_message = zmsg_new ();
-                            zmsg_addstr (ready_message, WORKER_HELLO_MSG);
-                            zmsg_addstr (ready_message, elt_agent->uuid);
-                            zmsg_addstr (ready_message, input_split_element);
-                            zmsg_addstr (ready_message,
-                                         output_split_element);
-                            zmsg_addstrf (ready_message, "%i",
-                                          IGS_DEFAULT_WORKER_CREDIT);
-                            igs_channel_whisper_zmsg (remote_agent->uuid,
-                                                      &ready_message);
-                        }
-                    }
-                }
-                else
-                    s_agent_propagate_agent_event (IGS_AGENT_UPDATED_DEFINITION,
-                                                   uuid, remote_agent_name,
-                                                   NULL);
-            }
-            else {
-                if (new_definition && !new_definition->name)
-                    igs_error (
-                      "received definition from remote agent %s(%s) does not "
-                      "contain a name : rejecting",
-                      remote_agent_name, uuid);
-                else
-                    igs_error ("received definition from remote agent %s(%s) "
-                               "is empty or "
-                               "invalid : agent will not be registered",
-                               remote_agent_name, uuid);
-            }
-            free (str_definition);
+static int s_handle_remove_split_entry (igs_core_context_t *context,
+                                        const char *name,
+                                        const char *peerUUID,
+                                        const char *title,
+                                        zmsg_t *msg)
+{
+    char *input = zmsg_popstr (msg);
+    if (input == NULL) {
+        igs_error ("no valid input in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *remote_agent = zmsg_popstr (msg);
+    if (remote_agent == NULL) {
+        igs_error (
+          "no valid agent name in %s message received from %s(%s): "
+          "rejecting",
+          title, name, peerUUID);
+        free (input);
+        return WHISPER_REJECTED;
+    }
+    char *output = zmsg_popstr (msg);
+    if (output == NULL) {
+        igs_error ("no valid output in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (input);
+        free (remote_agent);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (input);
+        free (remote_agent);
+        free (output);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
             free (uuid);
-            free (remote_agent_name);
-        }
-        else
-        if (streq (title, EXTERNAL_MAPPING_MSG)) {
-            // identify remote agent
-            char *str_mapping = zmsg_popstr (msg_duplicate);
-            if (str_mapping == NULL) {
-                igs_error ("no valid mapping in %s message received from "
-                           "%s(%s): rejecting",
-                           title, name, peerUUID);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
-            char *uuid = zmsg_popstr (msg_duplicate);
-            if (uuid == NULL) {
-                igs_error (
-                  "uuid is NULL in %s message received from %s(%s): rejecting",
-                  title, name, peerUUID);
-                free (str_mapping);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
-            igs_remote_agent_t *remote_agent = NULL;
-            HASH_FIND_STR (context->remote_agents, uuid, remote_agent);
-            if (remote_agent == NULL) {
-                igs_error ("no known remote agent with uuid '%s': rejecting",
-                           uuid);
-                free (str_mapping);
-                free (uuid);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
+        free (input);
+        free (remote_agent);
+        free (output);
+        return WHISPER_REJECTED;
+    }
 
-            igs_mapping_t *new_mapping = NULL;
-            if (strlen (str_mapping) > 0) {
-                // load mapping from string content
-                new_mapping = parser_load_mapping (str_mapping);
-                if (new_mapping == NULL)
-                    igs_error ("received mapping for agent %s(%s) could not be "
-                               "parsed properly",
-                               remote_agent->definition->name,
-                               remote_agent->uuid);
-            }
-            else {
-                igs_debug ("received mapping from agent %s(%s) is empty",
-                           remote_agent->definition->name, remote_agent->uuid);
-                if (remote_agent && remote_agent->mapping) {
-                    mapping_free_mapping (&remote_agent->mapping);
-                    remote_agent->mapping = NULL;
-                    s_agent_propagate_agent_event (
-                      IGS_AGENT_UPDATED_MAPPING, uuid,
-                      remote_agent->definition->name, NULL);
-                }
-            }
+    igs_debug (
+      "received REMOVE_SPLIT_ENTRY_MSG command from %s (%s)", name,
+      peerUUID);
+    if (input && remote_agent && output)
+        igsagent_split_remove_with_name (agent, input,
+                                          remote_agent, output);
+    free (input);
+    free (remote_agent);
+    free (output);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
 
-            if (new_mapping && remote_agent) {
-                // look if this agent already has a mapping
-                if (remote_agent->mapping) {
-                    igs_debug (
-                      "mapping already exists for agent %s(%s) : new mapping "
-                      "will overwrite the previous one...",
-                      remote_agent->definition->name, remote_agent->uuid);
-                    mapping_free_mapping (&remote_agent->mapping);
-                }
+static int s_handle_enable_log_stream (igs_core_context_t *context,
+                                       const char *name,
+                                       const char *peerUUID,
+                                       const char *title,
+                                       zmsg_t *msg)
+{
+    IGS_UNUSED (context)
+    IGS_UNUSED (title)
+    IGS_UNUSED (msg)
+    igs_debug ("received ENABLE_LOG_STREAM command from %s (%s)",
+               name, peerUUID);
+    igs_log_set_stream (true);
+    return WHISPER_HANDLED;
+}
 
-                igs_debug ("store mapping for agent %s(%s)",
-                           remote_agent->definition->name, remote_agent->uuid);
-                remote_agent->mapping = new_mapping;
-                s_agent_propagate_agent_event (IGS_AGENT_UPDATED_MAPPING, uuid,
-                                               remote_agent->definition->name,
-                                               NULL);
-            }
-            free (str_mapping);
+static int s_handle_disable_log_stream (igs_core_context_t *context,
+                                        const char *name,
+                                        const char *peerUUID,
+                                        const char *title,
+                                        zmsg_t *msg)
+{
+    IGS_UNUSED (context)
+    IGS_UNUSED (title)
+    IGS_UNUSED (msg)
+    igs_debug ("received DISABLE_LOG_STREAM command from %s (%s)",
+               name, peerUUID);
+    igs_log_set_stream (false);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_enable_log_file (igs_core_context_t *context,
+                                     const char *name,
+                                     const char *peerUUID,
+                                     const char *title,
+                                     zmsg_t *msg)
+{
+    IGS_UNUSED (context)
+    IGS_UNUSED (title)
+    IGS_UNUSED (msg)
+    igs_debug ("received ENABLE_LOG_FILE command from %s (%s)",
+               name, peerUUID);
+    igs_log_set_file (true, core_context->log_file_path);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_disable_log_file (igs_core_context_t *context,
+                                      const char *name,
+                                      const char *peerUUID,
+                                      const char *title,
+                                      zmsg_t *msg)
+{
+    IGS_UNUSED (context)
+    IGS_UNUSED (title)
+    IGS_UNUSED (msg)
+    igs_debug ("received DISABLE_LOG_FILE command from %s (%s)",
+               name, peerUUID);
+    igs_log_set_file (false, core_context->log_file_path);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_set_log_path (igs_core_context_t *context,
+                                  const char *name,
+                                  const char *peerUUID,
+                                  const char *title,
+                                  zmsg_t *msg)
+{
+    IGS_UNUSED (context)
+    IGS_UNUSED (title)
+    char *log_path = zmsg_popstr (msg);
+    igs_debug ("received SET_LOG_PATH command from %s (%s)", name,
+               peerUUID);
+    igs_log_set_file(igs_log_file(), log_path);
+    return WHISPER_HANDLED;
+}
+
+static int s_handle_set_definition_path (igs_core_context_t *context,
+                                         const char *name,
+                                         const char *peerUUID,
+                                         const char *title,
+                                         zmsg_t *msg)
+{
+    char *definition_path = zmsg_popstr (msg);
+    if (definition_path == NULL) {
+        igs_error (
+          "no valid definition path in %s message received from "
+          "%s(%s): rejecting",
+          title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (definition_path);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
             free (uuid);
-        }
-        else
-        if (streq (title, LOAD_DEFINITION_MSG)) {
-            // identify agent
-            char *str_definition = zmsg_popstr (msg_duplicate);
-            if (str_definition == NULL) {
-                igs_error ("no valid definition in %s message received from "
-                           "%s(%s): rejecting",
-                           title, name, peerUUID);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
-            char *uuid = zmsg_popstr (msg_duplicate);
-            if (uuid == NULL) {
-                igs_error (
-                  "no valid uuid in %s message received from %s(%s): rejecting",
-                  title, name, peerUUID);
-                free (str_definition);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
-            igsagent_t *agent = NULL;
-            HASH_FIND_STR (context->agents, uuid, agent);
-            if (agent == NULL) {
-                igs_error (
-                  "no agent with uuid '%s' in %s message received from %s(%s): "
-                  "rejecting",
-                  uuid, title, name, peerUUID);
-                free (str_definition);
-                if (uuid)
-                    free (uuid);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
+        free (definition_path);
+        return WHISPER_REJECTED;
+    }
+    igs_debug ("received SET_DEFINITION_PATH command from %s (%s)",
+               name, peerUUID);
+    igsagent_definition_set_path (agent, definition_path);
+    free (definition_path);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
 
-            // load definition
-            if (igsagent_definition_load_str (agent, str_definition)
-                == IGS_SUCCESS) {
-                // recheck mapping towards our new definition
-                igs_remote_agent_t *remote, *tmp;
-                HASH_ITER (hh, context->remote_agents, remote, tmp)
-                {
-                    s_network_configure_mapping_to_remote_agent (agent,
-                                                                  remote);
-                }
-            }
-            free (str_definition);
+static int s_handle_set_mapping_path (igs_core_context_t *context,
+                                      const char *name,
+                                      const char *peerUUID,
+                                      const char *title,
+                                      zmsg_t *msg)
+{
+    char *mapping_path = zmsg_popstr (msg);
+    if (mapping_path == NULL) {
+        igs_error ("no valid mapping path in %s message received "
+                   "from %s(%s): "
+                   "rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (mapping_path);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
             free (uuid);
-        }
-        else
-        if (streq (title, LOAD_MAPPING_MSG)) {
-            // identify agent
-            char *str_mapping = zmsg_popstr (msg_duplicate);
-            if (str_mapping == NULL) {
-                igs_error ("no valid mapping in %s message received from "
-                           "%s(%s): rejecting",
-                           title, name, peerUUID);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
-            char *uuid = zmsg_popstr (msg_duplicate);
-            if (uuid == NULL) {
-                igs_error (
-                  "no valid uuid in %s message received from %s(%s): rejecting",
-                  title, name, peerUUID);
-                free (str_mapping);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
-            igsagent_t *agent = NULL;
-            HASH_FIND_STR (context->agents, uuid, agent);
-            if (agent == NULL) {
-                igs_error (
-                  "no agent with uuid '%s' in %s message received from %s(%s): "
-                  "rejecting",
-                  uuid, title, name, peerUUID);
-                free (str_mapping);
-                if (uuid)
-                    free (uuid);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                return 0;
-            }
+        free (mapping_path);
+        return WHISPER_REJECTED;
+    }
+    igs_debug ("received SET_MAPPING_PATH command from %s (%s)",
+               name, peerUUID);
+    igsagent_mapping_set_path (agent, mapping_path);
+    free (mapping_path);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
 
-            // Load mapping from string content
-            igs_mapping_t *new_mapping = parser_load_mapping (str_mapping);
-            if (new_mapping) {
-                if (agent->mapping)
-                    mapping_free_mapping (&agent->mapping);
-                agent->mapping = new_mapping;
-                // check and activate mapping
-                igs_remote_agent_t *remote, *tmp;
-                HASH_ITER (hh, context->remote_agents, remote, tmp)
-                {
-                    s_network_configure_mapping_to_remote_agent (agent,
-                                                                  remote);
-                }
-                agent->network_need_to_send_mapping_update = true;
-            }
-            free (str_mapping);
+static int s_handle_save_definition_to_path (igs_core_context_t *context,
+                                             const char *name,
+                                             const char *peerUUID,
+                                             const char *title,
+                                             zmsg_t *msg)
+{
+    // identify agent
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
             free (uuid);
-        }
-        else {
-            //
-            // OTHER SUPPORTED MESSAGES
-            //
-            if (streq (title, GET_CURRENT_OUTPUTS_MSG)) {
-                // identify agent
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+        return WHISPER_REJECTED;
+    }
+    igs_debug (
+      "received SAVE_DEFINITION_TO_PATH command from %s (%s)", name,
+      peerUUID);
+    igsagent_definition_save (agent);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
 
-                model_read_write_lock (__FUNCTION__, __LINE__);
-                // check that this agent has not been destroyed when we were locked
-                if (!agent || !(agent->uuid)) {
-                    model_read_write_unlock (__FUNCTION__, __LINE__);
-                    return 0;
-                }
-                zmsg_t *msg_to_send = zmsg_new ();
-                zmsg_addstr (msg_to_send, CURRENT_OUTPUTS_MSG);
-                zmsg_addstr (msg_to_send, agent->uuid);
-                igs_iop_t *outputs = agent->definition->outputs_table;
-                igs_iop_t *current = NULL;
-                for (current = outputs; current;
-                     current = current->hh.next) {
-                    switch (current->value_type) {
-                        case IGS_INTEGER_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, &(current->value.i),
-                                         sizeof (int));
-                            break;
-                        case IGS_DOUBLE_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, &(current->value.d),
-                                         sizeof (double));
-                            break;
-                        case IGS_STRING_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addstr (msg_to_send, current->value.s);
-                            break;
-                        case IGS_BOOL_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, &(current->value.b),
-                                         sizeof (bool));
-                            break;
-                        case IGS_IMPULSION_T:
-                            // FIXME: we had to disable outputs sending for data and impulsions
-                            // but this is not consistent with inputs and parameters disabled
-                            //                                    zmsg_addstr(msg_to_send,
-                            //                                    found_iop->name);
-                            //                                    zmsg_addstrf(msg_to_send,
-                            //                                    "%d", found_iop->value_type);
-                            //                                    zmsg_addmem(msg_to_send, NULL,
-                            //                                    0);
-                            break;
-                        case IGS_DATA_T:
-                            // disabled
-                            //                                    zmsg_addstr(msg_to_send,
-                            //                                    found_iop->name);
-                            //                                    zmsg_addstrf(msg_to_send,
-                            //                                    "%d", found_iop->value_type);
-                            //                                    zmsg_addmem(msg_to_send,
-                            //                                    (found_iop->value.data),
-                            //                                    found_iop->value_size);
-                            break;
-
-                        default:
-                            break;
-                    }
-                }
-                model_read_write_unlock (__FUNCTION__, __LINE__);
-                s_lock_zyre_peer (__FUNCTION__, __LINE__);
-                igs_debug ("send output values to %s", peerUUID);
-                zyre_whisper (node, peerUUID, &msg_to_send);
-                s_unlock_zyre_peer (__FUNCTION__, __LINE__);
-                free (uuid);
-            }
-            else
-            if (streq (title, CURRENT_OUTPUTS_MSG)) {
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igs_remote_agent_t *remote_agent = NULL;
-                HASH_FIND_STR (context->remote_agents, uuid, remote_agent);
-                if (remote_agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igs_debug ("privately received output values from %s (%s)",
-                           remote_agent->definition->name, remote_agent->uuid);
-                s_handle_publication_from_remote_agent (msg_duplicate,
-                                                      remote_agent);
-                zmsg_destroy (&msg_duplicate);
-                free (uuid);
-            }
-            else
-            if (streq (title, GET_CURRENT_INPUTS_MSG)) {
-                // identify agent
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+static int s_handle_save_mapping_to_path (igs_core_context_t *context,
+                                          const char *name,
+                                          const char *peerUUID,
+                                          const char *title,
+                                          zmsg_t *msg)
+{
+    // identify agent
+    char *uuid = zmsg_popstr (msg);
+    if (uuid == NULL) {
+        igs_error ("no valid uuid in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        return WHISPER_REJECTED;
+    }
+    igsagent_t *agent = NULL;
+    HASH_FIND_STR (context->agents, uuid, agent);
+    if (agent == NULL) {
+        igs_error (
+          "no agent with uuid '%s' in %s message received from "
+          "%s(%s): rejecting",
+          uuid, title, name, peerUUID);
+        if (uuid)
+            free (uuid);
+        return WHISPER_REJECTED;
+    }
+    igs_debug ("received SAVE_MAPPING_TO_PATH command from %s (%s)",
+               name, peerUUID);
+    igsagent_mapping_save (agent);
+    free (uuid);
+    return WHISPER_HANDLED;
+}
 
-                model_read_write_lock (__FUNCTION__, __LINE__);
-                // check that this agent has not been destroyed when we were locked
-                if (!agent || !(agent->uuid)) {
-                    model_read_write_unlock (__FUNCTION__, __LINE__);
-                    return 0;
-                }
-                zmsg_t *msg_to_send = zmsg_new ();
-                zmsg_addstr (msg_to_send, CURRENT_INPUTS_MSG);
-                zmsg_addstr (msg_to_send, agent->uuid);
-                igs_iop_t *outputs = agent->definition->inputs_table;
-                igs_iop_t *current = NULL;
-                for (current = outputs; current;
-                     current = current->hh.next) {
-                    switch (current->value_type) {
-                        case IGS_INTEGER_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, &(current->value.i),
-                                         sizeof (int));
-                            break;
-                        case IGS_DOUBLE_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, &(current->value.d),
-                                         sizeof (double));
-                            break;
-                        case IGS_STRING_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addstr (msg_to_send, current->value.s);
-                            break;
-                        case IGS_BOOL_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, &(current->value.b),
-                                         sizeof (bool));
-                            break;
-                        case IGS_IMPULSION_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, NULL, 0);
-                            break;
-                        case IGS_DATA_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, (current->value.data),
-                                         current->value_size);
-                            break;
-
-                        default:
-                            break;
-                    }
-                }
-                model_read_write_unlock (__FUNCTION__, __LINE__);
-                s_lock_zyre_peer (__FUNCTION__, __LINE__);
-                igs_debug ("send input values to %s", peerUUID);
-                zyre_whisper (node, peerUUID, &msg_to_send);
-                s_unlock_zyre_peer (__FUNCTION__, __LINE__);
-                free (uuid);
-            }
-            else
-            if (streq (title, GET_CURRENT_PARAMETERS_MSG)) {
-                // identify agent
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+static int s_handle_call_service (igs_core_context_t *context,
+                                  const char *name,
+                                  const char *peerUUID,
+                                  const char *title,
+                                  zmsg_t *msg)
+{
+
+    // identify agent
+    char *caller_uuid = zmsg_popstr (msg);
+    char *callee_uuid = zmsg_popstr (msg);
+
+    const char *caller_name = name; // default caller name is the one of the peer
+
+    if (streq (title, CALL_SERVICE_MSG_DEPRECATED))
+        igs_warn ("Remote agent %s(%s) uses an older version of Ingescape with deprecated messages. Please upgrade this agent.", caller_name, caller_uuid);
+
+    igs_remote_agent_t *caller_agent = NULL;
+    HASH_FIND_STR (context->remote_agents, caller_uuid, caller_agent);
+    if (caller_agent) {
+        // replace caller name by the one of an actual agent
+        // NB: this will happen all the time, except when ingeprobe
+        //(which is not an agent) emulates a call.
+        caller_name = caller_agent->definition->name;
+    }
+
+    igsagent_t *callee_agent = NULL;
+    HASH_FIND_STR (context->agents, callee_uuid, callee_agent);
+    if (callee_agent == NULL) {
+        igs_error (
+          "no callee agent with uuid '%s' in %s message received "
+          "from %s(%s): rejecting",
+          callee_uuid, title, name, peerUUID);
+        if (callee_uuid)
+            free (callee_uuid);
+        if (caller_uuid)
+            free (caller_uuid);
+        return WHISPER_REJECTED;
+    }
+
+    char *service_name = zmsg_popstr (msg);
+    if (service_name == NULL) {
+        igs_error ("no service name in %s message received from "
+                   "%s(%s): rejecting",
+                   title, name, peerUUID);
+        free (caller_uuid);
+        free (callee_uuid);
+        return WHISPER_REJECTED;
+    }
 
-                model_read_write_lock (__FUNCTION__, __LINE__);
-                // check that this agent has not been destroyed when we were locked
-                if (!agent || !(agent->uuid)) {
-                    model_read_write_unlock (__FUNCTION__, __LINE__);
-                    return 0;
-                }
-                zmsg_t *msg_to_send = zmsg_new ();
-                zmsg_addstr (msg_to_send, CURRENT_PARAMETERS_MSG);
-                zmsg_addstr (msg_to_send, agent->uuid);
-                igs_iop_t *outputs = agent->definition->params_table;
-                igs_iop_t *current = NULL;
-                for (current = outputs; current;
-                     current = current->hh.next) {
-                    switch (current->value_type) {
-                        case IGS_INTEGER_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, &(current->value.i),
-                                         sizeof (int));
-                            break;
-                        case IGS_DOUBLE_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, &(current->value.d),
-                                         sizeof (double));
-                            break;
-                        case IGS_STRING_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addstr (msg_to_send, current->value.s);
-                            break;
-                        case IGS_BOOL_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, &(current->value.b),
-                                         sizeof (bool));
-                            break;
-                        case IGS_IMPULSION_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, NULL, 0);
-                            break;
-                        case IGS_DATA_T:
-                            zmsg_addstr (msg_to_send, current->name);
-                            zmsg_addstrf (msg_to_send, "%d",
-                                          current->value_type);
-                            zmsg_addmem (msg_to_send, (current->value.data),
-                                         current->value_size);
-                            break;
-
-                        default:
-                            break;
-                    }
-                }
-                model_read_write_unlock (__FUNCTION__, __LINE__);
+    char *token = zmsg_popstr (msg);
+    if (token == NULL) {
+        igs_error (
+          "no token in %s message received from %s(%s): rejecting",
+          title, name, peerUUID);
+        free (caller_uuid);
+        free (callee_uuid);
+        free (service_name);
+        return WHISPER_REJECTED;
+    }
+
+    if (callee_agent->definition
+        && callee_agent->definition->services_table) {
+        igs_service_t *service = NULL;
+        HASH_FIND_STR (callee_agent->definition->services_table,
+                       service_name, service);
+        if (service) {
+            if (service->cb) {
                 s_lock_zyre_peer (__FUNCTION__, __LINE__);
-                igs_debug ("send parameters values to %s", peerUUID);
-                zyre_whisper (node, peerUUID, &msg_to_send);
+                zyre_shouts (context->node,
+                             callee_agent->igs_channel,
+                             "CALLED %s from %s (%s)", service_name,
+                             caller_name, caller_uuid);
                 s_unlock_zyre_peer (__FUNCTION__, __LINE__);
-                free (uuid);
-            }
-            else
-            if (streq (title, START_AGENT_MSG)) {
-                char *agent_name = zmsg_popstr (msg_duplicate);
-                if (agent_name == NULL) {
-                    igs_error ("no agent name in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
+                size_t nb_args = 0;
+                igs_service_arg_t *_arg = NULL;
+                LL_COUNT (service->arguments, _arg, nb_args);
+                if (service_add_values_to_arguments_from_message (service_name,
+                                                                  service->arguments,
+                                                                  msg) == IGS_SUCCESS) {
+                    if (core_context->enable_service_logging)
+                        service_log_received_service (callee_agent, caller_name, caller_uuid, service_name, service->arguments);
+                    (service->cb) (callee_agent, caller_name,
+                                   caller_uuid, service_name,
+                                   service->arguments, nb_args,
+                                   token, service->cb_data);
+                    service_free_values_in_arguments (service->arguments);
                 }
+            } else
+                igsagent_warn (callee_agent, "no defined callback to handle received service %s", service_name);
+        } else if (!core_context->allow_undefined_services)
+            igsagent_warn (callee_agent,
+                           "agent %s(%s) has no service named %s",
+                           callee_agent->definition->name,
+                           callee_uuid, service_name);
+    }
+    free (caller_uuid);
+    free (callee_uuid);
+    free (service_name);
+    if (token)
+        free (token);
+    return WHISPER_HANDLED;
+}
 
-                igs_debug ("received 'START_AGENT %s' command from %s (%s)",
-                           agent_name, name, peerUUID);
-                igsagent_t *a = zhash_first (core_context->created_agents);
-                while (a) {
-                    if (streq (a->definition->name, agent_name)) {
-                        igs_info ("activating agent %s (%s)",
-                                  a->definition->name, a->uuid);
-                        igsagent_activate (a);
-                    }
-                    a = zhash_next (core_context->created_agents);
-                }
-            }
-            else
-            if (streq (title, STOP_AGENT_MSG)) {
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igs_debug ("received 'STOP_AGENT %s' command from %s (%s)",
-                           uuid, name, peerUUID);
-                igs_info ("deactivating agent %s (%s)", agent->definition->name,
-                          agent->uuid);
-                igsagent_deactivate (agent);
-            }
-            else
-            if (streq (title, STOP_PEER_MSG)) {
-                context->external_stop = true;
-                igs_debug ("received STOP_PEER command from %s (%s)", name,
-                           peerUUID);
-                free (title);
-                zmsg_destroy (&msg_duplicate);
-                zyre_event_destroy (&zyre_event);
-                // stop our zyre loop by returning -1 : this will start the cleaning
-                // process
-                return -1;
-            }
-            else
-            if (streq (title, CLEAR_MAPPING_MSG)) {
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+static int s_handle_ping (igs_core_context_t *context,
+                          const char *name,
+                          const char *peerUUID,
+                          const char *title,
+                          zmsg_t *msg)
+{
+    IGS_UNUSED (name)
+    IGS_UNUSED (title)
+    // we are pinged by another agent
+    zframe_t *countF = zmsg_pop (msg);
+    size_t count = 0;
+    memcpy (&count, zframe_data (countF), sizeof (size_t));
+    zframe_t *payload = zmsg_pop (msg);
+    // igsagent_info(agent, "ping %zu from %s", count, peer);
+    zmsg_t *back = zmsg_new ();
+    zmsg_addstr (back, PONG_MSG);
+    zmsg_addmem (back, &count, sizeof (size_t));
+    zmsg_append (back, &payload);
+    s_lock_zyre_peer (__FUNCTION__, __LINE__);
+    zyre_whisper (context->node, peerUUID, &back);
+    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+    return WHISPER_HANDLED;
+}
 
-                igs_debug ("received CLEAR_MAPPING command from %s (%s)", name,
-                           peerUUID);
-                igsagent_clear_mappings (agent);
-                free (uuid);
-            }
-            else
-            if (streq (title, FREEZE_MSG)) {
-                igs_debug ("received FREEZE command from %s (%s)", name,
-                           peerUUID);
-                igs_freeze ();
-            }
-            else
-            if (streq (title, UNFREEZE_MSG)) {
-                igs_debug ("received UNFREEZE command from %s (%s)", name,
-                           peerUUID);
-                igs_unfreeze ();
-            }
-            else
-            if (streq (title, MUTE_ALL_MSG)) {
-                igs_debug ("received MUTE_ALL command from %s (%s)", name,
-                           peerUUID);
-                igsagent_t *agent, *tmp;
-                HASH_ITER (hh, context->agents, agent, tmp)
-                {
-                    igsagent_mute (agent);
-                }
-            }
-            else
-            if (streq (title, UNMUTE_ALL_MSG)) {
-                igs_debug ("received UNMUTE_ALL command from %s (%s)", name,
-                           peerUUID);
-                igsagent_t *agent, *tmp;
-                HASH_ITER (hh, context->agents, agent, tmp)
-                {
-                    igsagent_unmute (agent);
-                }
-            }
-            else
-            if (streq (title, MUTE_AGENT_MSG)) {
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igs_debug ("received MUTE_AGENT command from %s (%s)", name,
-                           peerUUID);
-                igsagent_mute (agent);
-            }
-            else
-            if (streq (title, UNMUTE_AGENT_MSG)) {
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igs_debug ("received UNMUTE_AGENT command from %s (%s)", name,
-                           peerUUID);
-                igsagent_unmute (agent);
-            }
-            else
-            if (streq (title, MUTE_OUTPUT_MSG)) {
-                char *iop_name = zmsg_popstr (msg_duplicate);
-                if (iop_name == NULL) {
-                    igs_error ("no valid iop name in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (iop_name);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (iop_name);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+static int s_handle_pong (igs_core_context_t *context,
+                          const char *name,
+                          const char *peerUUID,
+                          const char *title,
+                          zmsg_t *msg)
+{
+    IGS_UNUSED (name)
+    IGS_UNUSED (title)
+    // continue performance measurement
+    zframe_t *countF = zmsg_pop (msg);
+    size_t count = 0;
+    memcpy (&count, zframe_data (countF), sizeof (size_t));
+    zframe_t *payload = zmsg_pop (msg);
+    // igsagent_info(agent, "pong %zu from %s", count, peer);
+    if (count != context->performance_msg_counter)
+        igs_error ("pong message lost at index %zu from %s", count,
+                   peerUUID);
+    else
+    if (count == context->performance_msg_count_target) {
+        // last message received
+        context->performance_stop = zclock_usecs ();
+        igs_info ("message size: %zu bytes",
+                  context->performance_msg_size);
+        igs_info ("roundtrip count: %zu",
+                  context->performance_msg_count_target);
+        igs_info ("average latency: %.3f µs",
+                  ((double) context->performance_stop
+                   - (double) context->performance_start)
+                    / context->performance_msg_count_target);
+        size_t throughput =
+          (size_t) ((double) context->performance_msg_count_target
+                    / ((double) context->performance_stop
+                       - (double) context->performance_start)
+                    * 1000000);
+        double megabytes = (double) throughput
+                           * context->performance_msg_size
+                           / (1024 * 1024);
+        igs_info ("average roundtrip throughput: %zu msg/s",
+                  (size_t) throughput);
+        igs_info ("average roundtrip throughput: %.3f MB/s",
+                  megabytes);
+        context->performance_msg_count_target = 0;
+    }
+    else {
+        context->performance_msg_counter++;
+        zmsg_t *back = zmsg_new ();
+        zmsg_addstr (back, PING_MSG);
+        zmsg_addmem (back, &context->performance_msg_counter,
+                     sizeof (size_t));
+        zmsg_append (back, &payload);
+        s_lock_zyre_peer (__FUNCTION__, __LINE__);
+        zyre_whisper (context->node, peerUUID, &back);
+        s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+    }
+    return WHISPER_HANDLED;
+}
 
-                igs_debug ("received MUTE command from %s (%s)", name,
-                           peerUUID);
-                igsagent_output_mute (agent, iop_name);
-                free (iop_name);
-                free (uuid);
-            }
-            else
-            if (streq (title, UNMUTE_OUTPUT_MSG)) {
-                char *iop_name = zmsg_popstr (msg_duplicate);
-                if (iop_name == NULL) {
-                    igs_error ("no valid iop name in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (iop_name);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (iop_name);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+static int s_handle_worker_message (igs_core_context_t *context,
+                                    const char *name,
+                                    const char *peerUUID,
+                                    const char *title,
+                                    zmsg_t *msg)
+{
+    IGS_UNUSED (name)
+    IGS_UNUSED (peerUUID)
+    split_message_from_worker ((char *) title, msg, context);
+    return WHISPER_HANDLED;
+}
 
-                igs_debug ("received UNMUTE command from %s (%s)", name,
-                           peerUUID);
-                igsagent_output_unmute (agent, iop_name);
-                free (iop_name);
-                free (uuid);
-            }
-            else
-            if (streq (title, SET_INPUT_MSG)) {
-                char *iop_name = zmsg_popstr (msg_duplicate);
-                if (iop_name == NULL) {
-                    igs_error ("no valid iop name in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *value = zmsg_popstr (msg_duplicate);
-                if (value == NULL) {
-                    igs_error ("no valid value in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (iop_name);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (iop_name);
-                    free (value);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (iop_name);
-                    free (value);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+static int s_handle_splitter_work (igs_core_context_t *context,
+                                   const char *name,
+                                   const char *peerUUID,
+                                   const char *title,
+                                   zmsg_t *msg)
+{
+    IGS_UNUSED (name)
+    IGS_UNUSED (peerUUID)
+    IGS_UNUSED (title)
+    split_message_from_splitter (msg, context);
+    return WHISPER_HANDLED;
+}
 
-                igs_debug ("received SET_INPUT command from %s (%s)", name,
-                           peerUUID);
-                if (iop_name && value)
-                    igsagent_input_set_string (agent, iop_name, value);
-                free (iop_name);
-                free (value);
-                free (uuid);
-            }
-            else
-            if (streq (title, SET_OUTPUT_MSG)) {
-                char *iop_name = zmsg_popstr (msg_duplicate);
-                if (iop_name == NULL) {
-                    igs_error ("no valid iop name in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *value = zmsg_popstr (msg_duplicate);
-                if (value == NULL) {
-                    igs_error ("no valid value in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (iop_name);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (iop_name);
-                    free (value);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (iop_name);
-                    free (value);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+// Handlers of the WHISPER messages received on our zyre node, by title
+static igs_whisper_handler_t s_whisper_handlers[] = {
+    {REMOTE_PEER_KNOWS_AGENT_MSG, s_handle_remote_peer_knows_agent, {0}},
+    {EXTERNAL_DEFINITION_MSG, s_handle_external_definition, {0}},
+    {EXTERNAL_MAPPING_MSG, s_handle_external_mapping, {0}},
+    {LOAD_DEFINITION_MSG, s_handle_load_definition, {0}},
+    {LOAD_MAPPING_MSG, s_handle_load_mapping, {0}},
+    {GET_CURRENT_OUTPUTS_MSG, s_handle_get_current_outputs, {0}},
+    {CURRENT_OUTPUTS_MSG, s_handle_current_outputs, {0}},
+    {GET_CURRENT_INPUTS_MSG, s_handle_get_current_inputs, {0}},
+    {GET_CURRENT_PARAMETERS_MSG, s_handle_get_current_parameters, {0}},
+    {START_AGENT_MSG, s_handle_start_agent, {0}},
+    {STOP_AGENT_MSG, s_handle_stop_agent, {0}},
+    {STOP_PEER_MSG, s_handle_stop_peer, {0}},
+    {CLEAR_MAPPING_MSG, s_handle_clear_mapping, {0}},
+    {FREEZE_MSG, s_handle_freeze, {0}},
+    {UNFREEZE_MSG, s_handle_unfreeze, {0}},
+    {MUTE_ALL_MSG, s_handle_mute_all, {0}},
+    {UNMUTE_ALL_MSG, s_handle_unmute_all, {0}},
+    {MUTE_AGENT_MSG, s_handle_mute_agent, {0}},
+    {UNMUTE_AGENT_MSG, s_handle_unmute_agent, {0}},
+    {MUTE_OUTPUT_MSG, s_handle_mute_output, {0}},
+    {UNMUTE_OUTPUT_MSG, s_handle_unmute_output, {0}},
+    {SET_INPUT_MSG, s_handle_set_input, {0}},
+    {SET_OUTPUT_MSG, s_handle_set_output, {0}},
+    {SET_PARAMETER_MSG, s_handle_set_parameter, {0}},
+    {MAP_MSG, s_handle_map, {0}},
+    {UNMAP_MSG, s_handle_unmap, {0}},
+    {ADD_SPLIT_ENTRY_MSG, s_handle_add_split_entry, {0}},
+    {REMOVE_SPLIT_ENTRY_MSG, s_handle_remove_split_entry, {0}},
+    // admin API
+    {ENABLE_LOG_STREAM_MSG, s_handle_enable_log_stream, {0}},
+    {DISABLE_LOG_STREAM_MSG, s_handle_disable_log_stream, {0}},
+    {ENABLE_LOG_FILE_MSG, s_handle_enable_log_file, {0}},
+    {DISABLE_LOG_FILE_MSG, s_handle_disable_log_file, {0}},
+    {SET_LOG_PATH_MSG, s_handle_set_log_path, {0}},
+    {SET_DEFINITION_PATH_MSG, s_handle_set_definition_path, {0}},
+    {SET_MAPPING_PATH_MSG, s_handle_set_mapping_path, {0}},
+    {SAVE_DEFINITION_TO_PATH_MSG, s_handle_save_definition_to_path, {0}},
+    {SAVE_MAPPING_TO_PATH_MSG, s_handle_save_mapping_to_path, {0}},
+    {CALL_SERVICE_MSG, s_handle_call_service, {0}},
+    {CALL_SERVICE_MSG_DEPRECATED, s_handle_call_service, {0}},
+    // performance
+    {PING_MSG, s_handle_ping, {0}},
+    {PONG_MSG, s_handle_pong, {0}},
+    {WORKER_GOODBYE_MSG, s_handle_worker_message, {0}},
+    {WORKER_HELLO_MSG, s_handle_worker_message, {0}},
+    {WORKER_READY_MSG, s_handle_worker_message, {0}},
+    {SPLITTER_WORK_MSG, s_handle_splitter_work, {0}},
+};
+
+static igs_whisper_handler_t *s_whisper_handlers_by_title = NULL;
+
+// Returns the handler of a WHISPER title, NULL if unknown. The table is
+// indexed on first use by the network thread.
+static igs_whisper_handler_t *s_whisper_handler (const char *title)
+{
+    if (s_whisper_handlers_by_title == NULL) {
+        size_t nb_handlers = sizeof (s_whisper_handlers) / sizeof (igs_whisper_handler_t);
+        for (size_t i = 0; i < nb_handlers; i++) {
+            igs_whisper_handler_t *handler = &s_whisper_handlers[i];
+            HASH_ADD_KEYPTR (hh, s_whisper_handlers_by_title, handler->title,
+                             strlen (handler->title), handler);
+        }
+    }
+    igs_whisper_handler_t *handler = NULL;
+    HASH_FIND_STR (s_whisper_handlers_by_title, title, handler);
+    return handler;
+}
 
-                igs_debug ("received SET_OUTPUT command from %s (%s)", name,
-                           peerUUID);
-                if (iop_name && value)
-                    igsagent_output_set_string (agent, iop_name, value);
-                free (iop_name);
-                free (value);
-                free (uuid);
-            }
-            else
-            if (streq (title, SET_PARAMETER_MSG)) {
-                char *iop_name = zmsg_popstr (msg_duplicate);
-                if (iop_name == NULL) {
-                    igs_error ("no valid iop name in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *value = zmsg_popstr (msg_duplicate);
-                if (value == NULL) {
-                    igs_error ("no valid value in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (iop_name);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (iop_name);
-                    free (value);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (iop_name);
-                    free (value);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+// manage messages received on the private channel
+int s_manage_zyre_incoming (igs_loop_t *loop, zsock_t *socket, void *arg)
+{
+    IGS_UNUSED (loop)
+    IGS_UNUSED (socket)
+    igs_core_context_t *context = (igs_core_context_t *) arg;
+    assert (context);
+    zyre_t *node = context->node;
+    assert (node);
 
-                igs_debug ("received SET_PARAMETER command from %s (%s)", name,
-                           peerUUID);
-                if (iop_name && value)
-                    igsagent_parameter_set_string (agent, iop_name, value);
-                free (iop_name);
-                free (value);
-                free (uuid);
-            }
-            else
-            if (streq (title, MAP_MSG)) {
-                char *input = zmsg_popstr (msg_duplicate);
-                if (input == NULL) {
-                    igs_error ("no valid input in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *remote_agent = zmsg_popstr (msg_duplicate);
-                if (remote_agent == NULL) {
-                    igs_error (
-                      "no valid agent name in %s message received from %s(%s): "
-                      "rejecting",
-                      title, name, peerUUID);
-                    free (input);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *output = zmsg_popstr (msg_duplicate);
-                if (output == NULL) {
-                    igs_error ("no valid output in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (input);
-                    free (remote_agent);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (input);
-                    free (remote_agent);
-                    free (output);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (input);
-                    free (remote_agent);
-                    free (output);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+    zyre_event_t *zyre_event = zyre_event_new (node);
+    const char *event = zyre_event_type (zyre_event);
+    const char *peerUUID = zyre_event_peer_uuid (zyre_event);
+    const char *name = zyre_event_peer_name (zyre_event);
+    const char *address = zyre_event_peer_addr (zyre_event);
+    zhash_t *headers = zyre_event_headers (zyre_event);
+    const char *group = zyre_event_group (zyre_event);
+    zmsg_t *msg = zyre_event_msg (zyre_event);
+    // message handlers consume the message of the event, unless our zyre
+    // callbacks need it afterwards
+    bool has_callbacks = (context->zyre_callbacks != NULL);
+    zmsg_t *msg_duplicate = (has_callbacks) ? zmsg_dup (msg) : NULL;
+    zmsg_t *payload = (has_callbacks) ? msg_duplicate : msg;
 
-                igs_debug ("received MAP command from %s (%s)", name, peerUUID);
-                if (input && remote_agent && output)
-                    igsagent_mapping_add (agent, input, remote_agent, output);
-                free (input);
-                free (remote_agent);
-                free (output);
-                free (uuid);
-            }
-            else
-            if (streq (title, UNMAP_MSG)) {
-                char *input = zmsg_popstr (msg_duplicate);
-                if (input == NULL) {
-                    igs_error ("no valid input in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *remote_agent = zmsg_popstr (msg_duplicate);
-                if (remote_agent == NULL) {
-                    igs_error (
-                      "no valid agent name in %s message received from %s(%s): "
-                      "rejecting",
-                      title, name, peerUUID);
-                    free (input);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *output = zmsg_popstr (msg_duplicate);
-                if (output == NULL) {
-                    igs_error ("no valid output in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (input);
-                    free (remote_agent);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (input);
-                    free (remote_agent);
-                    free (output);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (input);
-                    free (remote_agent);
-                    free (output);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
+    // parse event
+    if (streq (event, "ENTER")) {
+        igs_debug (
+          "->%s has entered the network with peer id %s and endpoint %s", name,
+          peerUUID, address);
+        igs_zyre_peer_t *zyre_peer = NULL;
+        HASH_FIND_STR (context->zyre_peers, peerUUID, zyre_peer);
+        if (zyre_peer == NULL) {
+            zyre_peer = (igs_zyre_peer_t *) zmalloc (sizeof (igs_zyre_peer_t));
+            zyre_peer->peer_id = s_strndup (peerUUID, IGS_MAX_PEER_ID_LENGTH);
+            HASH_ADD_STR (context->zyre_peers, peer_id, zyre_peer);
+            zyre_peer->name = s_strndup (name, IGS_MAX_AGENT_NAME_LENGTH);
+            zlist_t *keys = zhash_keys (headers);
+            size_t s = zlist_size (keys);
+            if (s > 0) {
+                igs_debug ("Handling headers for peer %s (%s)", name, peerUUID);
+                char *k = zlist_first (keys);
+                const char *v;
+                while (k) {
+                    v = zyre_event_header (zyre_event, k);
+                    igs_debug ("\t%s -> %s", k, v);
+                    k = zlist_next (keys);
                 }
-
-                igs_debug ("received UNMAP command from %s (%s)", name,
-                           peerUUID);
-                if (input && remote_agent && output)
-                    igsagent_mapping_remove_with_name (agent, input,
-                                                        remote_agent, output);
-                free (input);
-                free (remote_agent);
-                free (output);
-                free (uuid);
+                zlist_destroy (&keys);
             }
-            else
-            if (streq (title, ADD_SPLIT_ENTRY_MSG)) {
-                char *input = zmsg_popstr (msg_duplicate);
-                if (input == NULL) {
-                    igs_error ("no valid input in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *remote_agent = zmsg_popstr (msg_duplicate);
-                if (remote_agent == NULL) {
-                    igs_error (
-                      "no valid agent name in %s message received from %s(%s): "
-                      "rejecting",
-                      title, name, peerUUID);
-                    free (input);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *output = zmsg_popstr (msg_duplicate);
-                if (output == NULL) {
-                    igs_error ("no valid output in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (input);
-                    free (remote_agent);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (input);
-                    free (remote_agent);
-                    free (output);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (input);
-                    free (remote_agent);
-                    free (output);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
 
-                igs_debug ("received ADD_SPLIT_ENTRY command from %s (%s)",
-                           name, peerUUID);
-                if (input && remote_agent && output)
-                    igsagent_split_add (agent, input, remote_agent, output);
-                free (input);
-                free (remote_agent);
-                free (output);
-                free (uuid);
-            }
-            else
-            if (streq (title, REMOVE_SPLIT_ENTRY_MSG)) {
-                char *input = zmsg_popstr (msg_duplicate);
-                if (input == NULL) {
-                    igs_error ("no valid input in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *remote_agent = zmsg_popstr (msg_duplicate);
-                if (remote_agent == NULL) {
-                    igs_error (
-                      "no valid agent name in %s message received from %s(%s): "
-                      "rejecting",
-                      title, name, peerUUID);
-                    free (input);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *output = zmsg_popstr (msg_duplicate);
-                if (output == NULL) {
-                    igs_error ("no valid output in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (input);
-                    free (remote_agent);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (input);
-                    free (remote_agent);
-                    free (output);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (input);
-                    free (remote_agent);
-                    free (output);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
+            const char *peer_public_key = zyre_event_header (zyre_event, "X-PUBLICKEY");
+            const char *protocol_version = zyre_event_header (zyre_event, "protocol");
+            if (protocol_version)
+                zyre_peer->protocol = s_strndup (protocol_version, 16);
+            // peers that are not ingescape agents never subscribe to us
+            zyre_peer->accepts_publication_batches =
+              (protocol_version == NULL
+               || zyre_event_header (zyre_event, "publication_batches") != NULL);
+            if (!zyre_peer->accepts_publication_batches)
+                context->zyre_peers_without_batches++;
+            // ingescape agents older than protocol v5 subscribe to
+            // textual topics
+            zyre_peer->uses_textual_topics =
+              (protocol_version != NULL
+               && s_peer_protocol (zyre_peer) < PUBLICATION_V5_PROTOCOL);
+            if (zyre_peer->uses_textual_topics)
+                context->zyre_peers_with_textual_topics++;
 
-                igs_debug (
-                  "received REMOVE_SPLIT_ENTRY_MSG command from %s (%s)", name,
-                  peerUUID);
-                if (input && remote_agent && output)
-                    igsagent_split_remove_with_name (agent, input,
-                                                      remote_agent, output);
-                free (input);
-                free (remote_agent);
-                free (output);
-                free (uuid);
-            }
-            // admin API
-            else
-            if (streq (title, ENABLE_LOG_STREAM_MSG)) {
-                igs_debug ("received ENABLE_LOG_STREAM command from %s (%s)",
-                           name, peerUUID);
-                igs_log_set_stream (true);
-            }
-            else
-            if (streq (title, DISABLE_LOG_STREAM_MSG)) {
-                igs_debug ("received DISABLE_LOG_STREAM command from %s (%s)",
-                           name, peerUUID);
-                igs_log_set_stream (false);
-            }
-            else
-            if (streq (title, ENABLE_LOG_FILE_MSG)) {
-                igs_debug ("received ENABLE_LOG_FILE command from %s (%s)",
-                           name, peerUUID);
-                igs_log_set_file (true, core_context->log_file_path);
-            }
-            else
-            if (streq (title, DISABLE_LOG_FILE_MSG)) {
-                igs_debug ("received DISABLE_LOG_FILE command from %s (%s)",
-                           name, peerUUID);
-                igs_log_set_file (false, core_context->log_file_path);
-            }
-            else
-            if (streq (title, SET_LOG_PATH_MSG)) {
-                char *log_path = zmsg_popstr (msg_duplicate);
-                igs_debug ("received SET_LOG_PATH command from %s (%s)", name,
-                           peerUUID);
-                igs_log_set_file(igs_log_file(), log_path);
-            }
-            else
-            if (streq (title, SET_DEFINITION_PATH_MSG)) {
-                char *definition_path = zmsg_popstr (msg_duplicate);
-                if (definition_path == NULL) {
-                    igs_error (
-                      "no valid definition path in %s message received from "
-                      "%s(%s): rejecting",
-                      title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (definition_path);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (definition_path);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igs_debug ("received SET_DEFINITION_PATH command from %s (%s)",
-                           name, peerUUID);
-                igsagent_definition_set_path (agent, definition_path);
-                free (definition_path);
-                free (uuid);
-            }
-            else
-            if (streq (title, SET_MAPPING_PATH_MSG)) {
-                char *mapping_path = zmsg_popstr (msg_duplicate);
-                if (mapping_path == NULL) {
-                    igs_error ("no valid mapping path in %s message received "
-                               "from %s(%s): "
-                               "rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (mapping_path);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
+            const char *publisher_port = zyre_event_header (zyre_event, "publisher");
+            if (publisher_port) {
+                // we extract the publisher adress to subscribe to from the zyre message
+                // header
+                char endpoint_address[128];
+                strncpy (endpoint_address, address, 127);
+
+                // IP adress extraction
+                char *insert = endpoint_address + strlen (endpoint_address);
+                bool extractOK = true;
+                while (*insert != ':') {
+                    insert--;
+                    if (insert == endpoint_address) {
+                        igs_error ("Could not extract port from address %s", address);
+                        extractOK = false;
+                        break;
+                    }
                 }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    free (mapping_path);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
+
+                if (extractOK) {
+                    // we found a possible publisher to subscribe to
+                    *(insert + 1) =
+                      '\0'; // close endpoint_address string after ':' location
+
+                    // check towards our own ip address (without port)
+                    char *incoming_ip_address =
+                      endpoint_address + 6; // ignore tcp://
+                    *insert = '\0';
+                    bool useIPC = false;
+                    bool use_inproc = false;
+                    const char *ipc_address = NULL;
+                    const char *inproc_address = NULL;
+                    if (streq (context->ip_address, incoming_ip_address)) {
+                        // same IP address : we can try to use ipc (or loopback on windows)
+                        // instead of TCP or we can use inproc if both agents are in the same
+                        // process
+                        int pid = atoi (zyre_event_header (zyre_event, "pid"));
+                        if (context->process_id == pid) {
+                            // FIXME: certainly useless with new architecture
+                            // same ip address and same process : we can use inproc
+                            inproc_address = zyre_event_header (zyre_event, "inproc");
+                            if (inproc_address) {
+                                use_inproc = true;
+                                igs_debug ("Use address %s to subscribe to %s", inproc_address, name);
+                            }
+                        }
+                        else {
+                            // try to recover agent ipc/loopback address
+#if defined(__UNIX__)
+                            ipc_address = zyre_event_header (zyre_event, "ipc");
+#elif defined(__WINDOWS__)
+                            ipc_address = zyre_event_header (zyre_event, "loopback");
+#endif
+                            if (ipc_address) {
+                                useIPC = true;
+                                igs_debug ("Use address %s to subscribe to %s", ipc_address, name);
+                            }
+                        }
+                    }
+                    *insert = ':';
+                    // add port to the endpoint to compose it fully
+                    strcat (endpoint_address, publisher_port);
+                    // our subscriber socket is only opened when we first
+                    // subscribe to one of the outputs of the peer
+                    if (context->network_allow_inproc && use_inproc)
+                        zyre_peer->publisher_endpoint = strdup (inproc_address);
+                    else
+                    if (context->network_allow_ipc && useIPC)
+                        zyre_peer->publisher_endpoint = strdup (ipc_address);
+                    else
+                        zyre_peer->publisher_endpoint = strdup (endpoint_address);
+                    if (context->security_is_enabled && peer_public_key)
+                        zyre_peer->public_key = strdup (peer_public_key);
+#if defined(IGS_SHM_RING)
+                    // publications of peers on this host are read from their
+                    // shared-memory ring, our subscriber socket carrying our
+                    // subscriptions and the publications too large for the ring
+                    if (context->network_allow_ipc && useIPC
+                        && context->network_allow_shm && !context->security_is_enabled
+                        && zyre_event_header (zyre_event, "shm"))
+                        zyre_peer->shm_path = strdup (zyre_event_header (zyre_event, "shm"));
+#endif
                 }
-                igs_debug ("received SET_MAPPING_PATH command from %s (%s)",
-                           name, peerUUID);
-                igsagent_mapping_set_path (agent, mapping_path);
-                free (mapping_path);
-                free (uuid);
             }
-            else
-            if (streq (title, SAVE_DEFINITION_TO_PATH_MSG)) {
-                // identify agent
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
+            zhash_t *headers_bis = zhash_dup (headers);
+            s_agent_propagate_agent_event (IGS_PEER_ENTERED, peerUUID, name, headers_bis);
+            zhash_destroy (&headers_bis);
+        }
+        else {
+            // Agent already exists, we set its reconnected flag
+            //(this is used below to avoid agent destruction on EXIT received after
+            //timeout)
+            zyre_peer->reconnected++;
+        }
+    }
+    else
+    if (streq (event, "JOIN")) {
+        igs_debug ("+%s has joined %s", name, group);
+        if (streq (group, IGS_PRIVATE_CHANNEL)) {
+            // send information for all our agents to the newcomer
+            igs_zyre_peer_t *zyre_peer = NULL;
+            HASH_FIND_STR (context->zyre_peers, peerUUID, zyre_peer);
+            assert (zyre_peer);
+
+            igsagent_t *agent, *tmp;
+            char *definition_str = NULL;
+            char *mapping_str = NULL;
+            HASH_ITER (hh, context->agents, agent, tmp)
+            {
+                // definition is sent to every newcomer on the channel (whether it is a
+                // ingescape agent or not)
+                // values are written under the agent lock only
+                model_agent_read_lock (agent);
+                if (zyre_peer->protocol
+                    && (streq (zyre_peer->protocol, "v2")
+                        || streq (zyre_peer->protocol, "v3")))
+                    definition_str = parser_export_definition_legacy (agent->definition);
+                else
+                    definition_str =
+                      parser_export_definition (agent->definition);
+                model_agent_read_unlock (agent);
+                if (definition_str) {
+                    s_send_definition_to_zyre_peer (agent, peerUUID,
+                                                    definition_str, false);
+                    free (definition_str);
+                    definition_str = NULL;
                 }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
+                else
+                    s_send_definition_to_zyre_peer (agent, peerUUID, "", false);
+                // and so is our mapping
+                if (zyre_peer->protocol && streq (zyre_peer->protocol, "v2"))
+                    mapping_str = parser_export_mapping_legacy (agent->mapping);
+                else
+                    mapping_str = parser_export_mapping (agent->mapping);
+                if (mapping_str) {
+                    s_send_mapping_to_zyre_peer (agent, peerUUID, mapping_str);
+                    free (mapping_str);
+                    mapping_str = NULL;
                 }
-                igs_debug (
-                  "received SAVE_DEFINITION_TO_PATH command from %s (%s)", name,
-                  peerUUID);
-                igsagent_definition_save (agent);
-                free (uuid);
+                else
+                    s_send_mapping_to_zyre_peer (agent, peerUUID, "");
+                // and so is the state of our internal variables
+                s_send_state_to (agent, peerUUID, true);
             }
-            else
-            if (streq (title, SAVE_MAPPING_TO_PATH_MSG)) {
-                // identify agent
-                char *uuid = zmsg_popstr (msg_duplicate);
-                if (uuid == NULL) {
-                    igs_error ("no valid uuid in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igsagent_t *agent = NULL;
-                HASH_FIND_STR (context->agents, uuid, agent);
-                if (agent == NULL) {
-                    igs_error (
-                      "no agent with uuid '%s' in %s message received from "
-                      "%s(%s): rejecting",
-                      uuid, title, name, peerUUID);
-                    if (uuid)
-                        free (uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-                igs_debug ("received SAVE_MAPPING_TO_PATH command from %s (%s)",
+            zyre_peer->has_joined_private_channel = true;
+        }
+    }
+    else
+    if (streq (event, "SHOUT")) {
+        if (streq (group, context->replay_channel)) {
+            // this is a replay message for one of our inputs
+            char *agent_name = zmsg_popstr (payload);
+            char *input = zmsg_popstr (payload);
+            if (agent_name == NULL) {
+                igs_error ("agent name is NULL for replay message from %s(%s): "
+                           "rejecting",
                            name, peerUUID);
-                igsagent_mapping_save (agent);
-                free (uuid);
+                zmsg_destroy (&msg_duplicate);
+                zyre_event_destroy (&zyre_event);
+                return 0;
+            }
+            if (input == NULL) {
+                igs_error (
+                  "input is NULL for replay message from %s(%s): rejecting",
+                  name, peerUUID);
+                free (agent_name);
+                zmsg_destroy (&msg_duplicate);
+                zyre_event_destroy (&zyre_event);
+                return 0;
             }
-            else
-            if (streq (title, CALL_SERVICE_MSG)
-                || streq (title, CALL_SERVICE_MSG_DEPRECATED)) {
-
-                // identify agent
-                char *caller_uuid = zmsg_popstr (msg_duplicate);
-                char *callee_uuid = zmsg_popstr (msg_duplicate);
-
-                const char *caller_name = name; // default caller name is the one of the peer
-
-                if (streq (title, CALL_SERVICE_MSG_DEPRECATED))
-                    igs_warn ("Remote agent %s(%s) uses an older version of Ingescape with deprecated messages. Please upgrade this agent.", caller_name, caller_uuid);
-
-                igs_remote_agent_t *caller_agent = NULL;
-                HASH_FIND_STR (context->remote_agents, caller_uuid, caller_agent);
-                if (caller_agent) {
-                    // replace caller name by the one of an actual agent
-                    // NB: this will happen all the time, except when ingeprobe
-                    //(which is not an agent) emulates a call.
-                    caller_name = caller_agent->definition->name;
-                }
-
-                igsagent_t *callee_agent = NULL;
-                HASH_FIND_STR (context->agents, callee_uuid, callee_agent);
-                if (callee_agent == NULL) {
-                    igs_error (
-                      "no callee agent with uuid '%s' in %s message received "
-                      "from %s(%s): rejecting",
-                      callee_uuid, title, name, peerUUID);
-                    if (callee_uuid)
-                        free (callee_uuid);
-                    if (caller_uuid)
-                        free (caller_uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-
-                char *service_name = zmsg_popstr (msg_duplicate);
-                if (service_name == NULL) {
-                    igs_error ("no service name in %s message received from "
-                               "%s(%s): rejecting",
-                               title, name, peerUUID);
-                    free (caller_uuid);
-                    free (callee_uuid);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
-
-                char *token = zmsg_popstr (msg_duplicate);
-                if (token == NULL) {
-                    igs_error (
-                      "no token in %s message received from %s(%s): rejecting",
-                      title, name, peerUUID);
-                    free (caller_uuid);
-                    free (callee_uuid);
-                    free (service_name);
-                    zmsg_destroy (&msg_duplicate);
-                    zyre_event_destroy (&zyre_event);
-                    return 0;
-                }
 
-                if (callee_agent->definition
-                    && callee_agent->definition->services_table) {
-                    igs_service_t *service = NULL;
-                    HASH_FIND_STR (callee_agent->definition->services_table,
-                                   service_name, service);
-                    if (service) {
-                        if (service->cb) {
-                            s_lock_zyre_peer (__FUNCTION__, __LINE__);
-                            zyre_shouts (context->node,
-                                         callee_agent->igs_channel,
-                                         "CALLED %s from %s (%s)", service_name,
-                                         caller_name, caller_uuid);
-                            s_unlock_zyre_peer (__FUNCTION__, __LINE__);
-                            size_t nb_args = 0;
-                            igs_service_arg_t *_arg = NULL;
-                            LL_COUNT (service->arguments, _arg, nb_args);
-                            if (service_add_values_to_arguments_from_message (service_name,
-                                                                              service->arguments,
-                                                                              msg_duplicate) == IGS_SUCCESS) {
-                                if (core_context->enable_service_logging)
-                                    service_log_received_service (callee_agent, caller_name, caller_uuid, service_name, service->arguments);
-                                (service->cb) (callee_agent, caller_name,
-                                               caller_uuid, service_name,
-                                               service->arguments, nb_args,
-                                               token, service->cb_data);
-                                service_free_values_in_arguments (service->arguments);
+            char *value = NULL;
+            zframe_t *frame = NULL;
+            void *data = NULL;
+            size_t size = 0;
+            igsagent_t *target_agent, *targettmp;
+            HASH_ITER (hh, context->agents, target_agent, targettmp)
+            {
+                if (streq (agent_name, target_agent->definition->name)) {
+                    igs_iop_value_type_t input_type =
+                      igsagent_input_type (target_agent, input);
+                    if (zmsg_size (payload) > 0) {
+                        igs_debug ("replaying %s.%s", agent_name, input);
+                        if (input_type == IGS_STRING_T) {
+                            value = zmsg_popstr (payload);
+                            if (value == NULL) {
+                                igs_error ("value is NULL for replay message "
+                                           "from %s(%s): rejecting",
+                                           name, peerUUID);
+                                free (agent_name);
+                                free (input);
+                                zmsg_destroy (&msg_duplicate);
+                                zyre_event_destroy (&zyre_event);
+                                return 0;
+                            }
+                            igsagent_input_set_string (target_agent, input,
+                                                        value);
+                            free (value);
+                        }
+                        else {
+                            frame = zmsg_pop (payload);
+                            if (frame == NULL) {
+                                igs_error ("value is NULL for replay message "
+                                           "from %s(%s): rejecting",
+                                           name, peerUUID);
+                                free (agent_name);
+                                free (input);
+                                zmsg_destroy (&msg_duplicate);
+                                zyre_event_destroy (&zyre_event);
+                                return 0;
                             }
-                        } else
-                            igsagent_warn (callee_agent, "no defined callback to handle received service %s", service_name);
-                    } else if (!core_context->allow_undefined_services)
-                        igsagent_warn (callee_agent,
-                                       "agent %s(%s) has no service named %s",
-                                       callee_agent->definition->name,
-                                       callee_uuid, service_name);
+                            data = zframe_data (frame);
+                            size = zframe_size (frame);
+                            model_write_iop (target_agent, input, IGS_INPUT_T,
+                                             input_type, data, size);
+                            zframe_destroy (&frame);
+                        }
+                    }
+                    else
+                        igsagent_error (target_agent,
+                                         "replay message for input %s is not "
+                                         "correct and was ignored",
+                                         input);
                 }
-                free (caller_uuid);
-                free (callee_uuid);
-                free (service_name);
-                if (token)
-                    free (token);
-            }
-            // Performance
-            else
-            if (streq (title, PING_MSG)) {
-                // we are pinged by another agent
-                zframe_t *countF = zmsg_pop (msg_duplicate);
-                size_t count = 0;
-                memcpy (&count, zframe_data (countF), sizeof (size_t));
-                zframe_t *payload = zmsg_pop (msg_duplicate);
-                // igsagent_info(agent, "ping %zu from %s", count, peer);
-                zmsg_t *back = zmsg_new ();
-                zmsg_addstr (back, PONG_MSG);
-                zmsg_addmem (back, &count, sizeof (size_t));
-                zmsg_append (back, &payload);
-                s_lock_zyre_peer (__FUNCTION__, __LINE__);
-                zyre_whisper (node, peerUUID, &back);
-                s_unlock_zyre_peer (__FUNCTION__, __LINE__);
             }
-            else
-            if (streq (title, PONG_MSG)) {
-                // continue performance measurement
-                zframe_t *countF = zmsg_pop (msg_duplicate);
-                size_t count = 0;
-                memcpy (&count, zframe_data (countF), sizeof (size_t));
-                zframe_t *payload = zmsg_pop (msg_duplicate);
-                // igsagent_info(agent, "pong %zu from %s", count, peer);
-                if (count != context->performance_msg_counter)
-                    igs_error ("pong message lost at index %zu from %s", count,
-                               peerUUID);
-                else
-                if (count == context->performance_msg_count_target) {
-                    // last message received
-                    context->performance_stop = zclock_usecs ();
-                    igs_info ("message size: %zu bytes",
-                              context->performance_msg_size);
-                    igs_info ("roundtrip count: %zu",
-                              context->performance_msg_count_target);
-                    igs_info ("average latency: %.3f µs",
-                              ((double) context->performance_stop
-                               - (double) context->performance_start)
-                                / context->performance_msg_count_target);
-                    size_t throughput =
-                      (size_t) ((double) context->performance_msg_count_target
-                                / ((double) context->performance_stop
-                                   - (double) context->performance_start)
-                                * 1000000);
-                    double megabytes = (double) throughput
-                                       * context->performance_msg_size
-                                       / (1024 * 1024);
-                    igs_info ("average roundtrip throughput: %zu msg/s",
-                              (size_t) throughput);
-                    igs_info ("average roundtrip throughput: %.3f MB/s",
-                              megabytes);
-                    context->performance_msg_count_target = 0;
-                }
-                else {
-                    context->performance_msg_counter++;
-                    zmsg_t *back = zmsg_new ();
-                    zmsg_addstr (back, PING_MSG);
-                    zmsg_addmem (back, &context->performance_msg_counter,
-                                 sizeof (size_t));
-                    zmsg_append (back, &payload);
-                    s_lock_zyre_peer (__FUNCTION__, __LINE__);
-                    zyre_whisper (node, peerUUID, &back);
-                    s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+            free (agent_name);
+            free (input);
+
+        }
+        else
+        if (streq (group, IGS_PRIVATE_CHANNEL)) {
+            char *title = zmsg_popstr (payload);
+            if (streq (title, REMOTE_AGENT_EXIT_MSG)) {
+                char *uuid = zmsg_popstr (payload);
+                igs_remote_agent_t *remote = NULL;
+                HASH_FIND_STR (context->remote_agents, uuid, remote);
+                if (remote) {
+                    igs_debug ("<-%s (%s) exited", remote->definition->name,
+                               uuid);
+                    split_remove_worker (context, uuid, NULL);
+                    HASH_DEL (context->remote_agents, remote);
+                    s_agent_propagate_agent_event (
+                      IGS_AGENT_EXITED, uuid, remote->definition->name, NULL);
+                    s_clean_and_free_remote_agent (&remote);
                 }
+                else
+                    igs_error ("%s is not a known remote agent", uuid);
+                if (uuid)
+                    free (uuid);
             }
-            else
-            if (streq (title, WORKER_GOODBYE_MSG)
-                    || streq (title, WORKER_HELLO_MSG)
-                    || streq (title, WORKER_READY_MSG))
-                split_message_from_worker (title, msg_duplicate, context);
-            else
-            if (streq (title, SPLITTER_WORK_MSG))
-                split_message_from_splitter (msg_duplicate, context);
+            free (title);
+        }
+    }
+    else
+    if (streq (event, "WHISPER")) {
+        char *title = zmsg_popstr (payload);
+        if (title == NULL) {
+            igs_error ("no header in message received from %s(%s): rejecting",
+                       name, peerUUID);
+            zmsg_destroy (&msg_duplicate);
+            zyre_event_destroy (&zyre_event);
+            return 0;
         }
+        igs_whisper_handler_t *handler = s_whisper_handler (title);
+        int result = (handler) ? handler->handler (context, name, peerUUID, title, payload)
+                               : WHISPER_HANDLED;
         free (title);
+        if (result != WHISPER_HANDLED) {
+            zmsg_destroy (&msg_duplicate);
+            zyre_event_destroy (&zyre_event);
+            // stop our zyre loop by returning -1 : this will start the
+            // cleaning process
+            return (result == WHISPER_STOP_LOOP) ? -1 : 0;
+        }
     }
     else
     if (streq (event, "LEADER")) {
@@ -2891,8 +4239,12 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
                     }
                 }
                 HASH_DEL (context->zyre_peers, zyre_peer);
+                if (!zyre_peer->accepts_publication_batches)
+                    context->zyre_peers_without_batches--;
+                if (zyre_peer->uses_textual_topics)
+                    context->zyre_peers_with_textual_topics--;
                 s_agent_propagate_agent_event (IGS_PEER_EXITED, peerUUID, name, NULL);
-                s_clean_and_free_zyre_peer (&zyre_peer, loop);
+                s_clean_and_free_zyre_peer (&zyre_peer, context);
             }
         }
     }
@@ -2900,17 +4252,21 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
     // handle callbacks
     // NB: as explained earlier, agent may be NULL
     // depending on the event type.
-    igs_channels_wrapper_t *elt;
-    DL_FOREACH (context->zyre_callbacks, elt){
-        if (zyre_event){
-            zmsg_t *dup = zmsg_dup (msg);
-            elt->callback_ptr (event, peerUUID, name, address, group, headers,
-                               dup, elt->my_data);
-            zmsg_destroy (&dup);
-        }else{
-            igs_error ("previous callback certainly destroyed the zyre event : next "
-                       "callbacks will not be executed");
-            break;
+    // NB: callbacks added meanwhile wait for the next event, as message
+    // handlers may have consumed the message of this one.
+    if (has_callbacks) {
+        igs_channels_wrapper_t *elt;
+        DL_FOREACH (context->zyre_callbacks, elt){
+            if (zyre_event){
+                zmsg_t *dup = zmsg_dup (msg);
+                elt->callback_ptr (event, peerUUID, name, address, group, headers,
+                                   dup, elt->my_data);
+                zmsg_destroy (&dup);
+            }else{
+                igs_error ("previous callback certainly destroyed the zyre event : next "
+                           "callbacks will not be executed");
+                break;
+            }
         }
     }
     zmsg_destroy (&msg_duplicate);
@@ -2920,7 +4276,7 @@ int s_manage_zyre_incoming (zloop_t *loop, zsock_t *socket, void *arg)
 
 // Timer callback to (re)send our definition to agents present on the private
 // channel
-int trigger_definition_update (zloop_t *loop, int timer_id, void *arg)
+int trigger_definition_update (igs_loop_t *loop, int timer_id, void *arg)
 {
     IGS_UNUSED (loop)
     IGS_UNUSED (timer_id)
@@ -2940,6 +4296,7 @@ int trigger_definition_update (zloop_t *loop, int timer_id, void *arg)
             HASH_ITER (hh, context->zyre_peers, p, ptmp)
             {
                 if (p->has_joined_private_channel) {
+                    model_agent_read_lock (agent);
                     if (p->protocol
                         && (streq (p->protocol, "v2")
                             || streq (p->protocol, "v3")))
@@ -2947,6 +4304,7 @@ int trigger_definition_update (zloop_t *loop, int timer_id, void *arg)
                     else
                         definition_str =
                           parser_export_definition (agent->definition);
+                    model_agent_read_unlock (agent);
                     if (definition_str) {
                         s_send_definition_to_zyre_peer (
                           agent, p->peer_id, definition_str,
@@ -2978,7 +4336,7 @@ int trigger_definition_update (zloop_t *loop, int timer_id, void *arg)
 
 // Timer callback to update and (re)send our mapping to agents on the private
 // channel
-int s_trigger_mapping_update (zloop_t *loop, int timer_id, void *arg)
+int s_trigger_mapping_update (igs_loop_t *loop, int timer_id, void *arg)
 {
     IGS_UNUSED (loop)
     IGS_UNUSED (timer_id)
@@ -3050,7 +4408,7 @@ void s_network_unlock (void)
 }
 
 // manage messages from the parent thread
-int s_manage_parent (zloop_t *loop, zsock_t *pipe, void *arg)
+int s_manage_parent (igs_loop_t *loop, zsock_t *pipe, void *arg)
 {
     IGS_UNUSED (loop)
     IGS_UNUSED (arg)
@@ -3074,6 +4432,219 @@ int s_manage_parent (zloop_t *loop, zsock_t *pipe, void *arg)
     return 0;
 }
 
+#define PUBLISHER_TCP 1
+#define PUBLISHER_IPC 2
+#define PUBLISHER_INPROC 4
+#define PUBLISHER_SHM 8
+
+// Duplicates the message of a publication, large values being shared
+// with the original message instead of copied
+static zmsg_t *s_publication_dup (igs_publication_t *publication)
+{
+    if (publication->nb_values == 0)
+        return zmsg_dup (publication->msg);
+    zmsg_t *dup = zmsg_new ();
+    zframe_t *frame = zmsg_first (publication->msg);
+    while (frame) {
+        igs_value_t *shared = NULL;
+        for (size_t i = 0; i < publication->nb_values && !shared; i++)
+            if (zframe_data (frame) == (byte *) publication->values[i]->data)
+                shared = publication->values[i];
+        zframe_t *frame_dup = NULL;
+        if (shared) {
+            IGS_REFCOUNT_INCREMENT (shared->refcount);
+            frame_dup = model_value_frame_new (shared, zframe_size (frame));
+        }
+        else
+            frame_dup = zframe_dup (frame);
+        zmsg_append (dup, &frame_dup);
+        frame = zmsg_next (publication->msg);
+    }
+    return dup;
+}
+
+static void s_publication_queue_destroy (igs_queue_t **queue)
+{
+    assert (queue);
+    if (*queue == NULL)
+        return;
+    int publishers = 0;
+    igs_publication_t *publication = (igs_publication_t *) s_queue_pop (*queue, &publishers);
+    while (publication) {
+        network_publication_destroy (&publication);
+        publication = (igs_publication_t *) s_queue_pop (*queue, &publishers);
+    }
+    s_queue_destroy (queue);
+}
+
+// Reads the subscription messages received by one of our XPUB publishers.
+// Must be called by the publisher thread with the model mutex locked.
+static void s_update_subscriptions (zsock_t *publisher,
+                                    igs_subscription_t **subscriptions)
+{
+    while (zsock_events (publisher) & ZMQ_POLLIN) {
+        zframe_t *frame = zframe_recv (publisher);
+        if (!frame)
+            break;
+        byte *data = zframe_data (frame);
+        size_t size = zframe_size (frame);
+        // first byte is 1 for subscriptions and 0 for unsubscriptions,
+        // followed by the filter
+        if (size > 0 && (data[0] == 0 || data[0] == 1)) {
+            const char *filter = (const char *) data + 1;
+            size_t length = size - 1;
+            igs_subscription_t *subscription = NULL;
+            HASH_FIND (hh, *subscriptions, filter, length, subscription);
+            if (data[0] == 1 && subscription == NULL) {
+                subscription = (igs_subscription_t *) zmalloc (sizeof (igs_subscription_t));
+                subscription->filter = (char *) zmalloc (length + 1);
+                memcpy (subscription->filter, filter, length);
+                subscription->length = length;
+                HASH_ADD_KEYPTR (hh, *subscriptions, subscription->filter, length, subscription);
+            }
+            else if (data[0] == 0 && subscription) {
+                HASH_DEL (*subscriptions, subscription);
+                free (subscription->filter);
+                free (subscription);
+            }
+        }
+        zframe_destroy (&frame);
+    }
+}
+
+// Sends all the queued publications, the last publisher taking the message
+// of each publication and the others getting a copy of it
+static void s_drain_publication_queue (igs_core_context_t *context)
+{
+    zsock_t *sockets[] = {context->publisher, context->ipc_publisher,
+                          context->inproc_publisher};
+    const char *transports[] = {"on the network", "using IPC", "using inproc"};
+    int publishers = 0;
+    igs_publication_t *publication =
+      (igs_publication_t *) s_queue_pop (context->publication_queue, &publishers);
+    while (publication) {
+#if defined(IGS_SHM_RING)
+        if (publishers & PUBLISHER_SHM) {
+            if (!shm_ring_write (context->shm_ring, publication->msg)
+                && context->ipc_publisher) {
+                // readers get it using IPC at the place of its numbered
+                // placeholder in the ring, see igs_receiver_ring_t
+                uint64_t number = ++context->shm_fallbacks;
+                zmsg_t *msg = s_publication_dup (publication);
+                zframe_t *topic = zmsg_pop (msg);
+                zframe_t *shm_topic = zframe_dup (topic);
+                zframe_data (shm_topic)[0] = PUBLICATION_SHM_MARKER;
+                zframe_destroy (&topic);
+                zmsg_t *placeholder = zmsg_new ();
+                zmsg_addmem (placeholder, zframe_data (shm_topic), zframe_size (shm_topic));
+                zmsg_addmem (placeholder, &number, sizeof (uint64_t));
+                shm_ring_write (context->shm_ring, placeholder);
+                zmsg_destroy (&placeholder);
+                zmsg_pushmem (msg, &number, sizeof (uint64_t));
+                zmsg_prepend (msg, &shm_topic);
+                if (zmsg_send (&msg, context->ipc_publisher) != 0) {
+                    igs_error ("Could not send publication using IPC");
+                    zmsg_destroy (&msg);
+                }
+            }
+            publishers &= ~PUBLISHER_SHM;
+        }
+#endif
+        for (int i = 0; i < 3; i++) {
+            int publisher = 1 << i;
+            if (!(publishers & publisher) || !sockets[i])
+                continue;
+            zmsg_t *msg = NULL;
+            if (publishers & ~((publisher << 1) - 1))
+                msg = s_publication_dup (publication);
+            else {
+                msg = publication->msg;
+                publication->msg = NULL;
+            }
+            if (zmsg_send (&msg, sockets[i]) != 0) {
+                igs_error ("Could not send publication %s", transports[i]);
+                zmsg_destroy (&msg);
+            }
+        }
+        network_publication_destroy (&publication);
+        publication = (igs_publication_t *) s_queue_pop (context->publication_queue, &publishers);
+    }
+}
+
+// Publisher thread: sends the queued publications and reads the
+// subscriptions received by our publishers, which it owns. Application
+// threads signal it on its pipe when it waits for publications, and send
+// it the HWM command to change the HWM of the publishers.
+static void s_publisher_actor (zsock_t *pipe, void *args)
+{
+    igs_core_context_t *context = (igs_core_context_t *) args;
+    igs_subscription_t **subscriptions[] = {&context->publisher_subscriptions,
+                                            &context->ipc_publisher_subscriptions,
+                                            &context->inproc_publisher_subscriptions};
+    zsock_t *sockets[] = {context->publisher, context->ipc_publisher,
+                          context->inproc_publisher};
+    zpoller_t *poller = zpoller_new (pipe, NULL);
+    for (int i = 0; i < 3; i++)
+        if (sockets[i])
+            zpoller_add (poller, sockets[i]);
+    zsock_signal (pipe, 0);
+
+    bool terminated = false;
+    while (!terminated) {
+        s_drain_publication_queue (context);
+        // check the queue again after announcing that we wait, so that a
+        // publication queued meanwhile is either seen or signaled
+        IGS_ATOMIC_STORE (context->publication_queue->is_waiting, 1);
+        void *which = NULL;
+        if (s_queue_depth (context->publication_queue) == 0) {
+            which = zpoller_wait (poller, -1);
+            if (which == NULL && zpoller_terminated (poller))
+                terminated = true;
+        }
+        IGS_ATOMIC_STORE (context->publication_queue->is_waiting, 0);
+        if (which == pipe) {
+            zmsg_t *msg = zmsg_recv (pipe);
+            if (msg == NULL)
+                terminated = true;
+            else if (zmsg_signal (msg) < 0) {
+                char *command = zmsg_popstr (msg);
+                if (command && streq (command, "$TERM"))
+                    terminated = true;
+                else if (command && streq (command, "HWM")) {
+                    char *value = zmsg_popstr (msg);
+                    int hwm_value = (value) ? atoi (value) : 0;
+                    for (int i = 0; i < 3; i++)
+                        if (sockets[i])
+                            zsock_set_sndhwm (sockets[i], hwm_value);
+                    free (value);
+                }
+                free (command);
+            }
+            zmsg_destroy (&msg);
+        }
+        else if (which) {
+            for (int i = 0; i < 3; i++)
+                if (which == sockets[i]) {
+                    model_read_write_lock (__FUNCTION__, __LINE__);
+                    s_update_subscriptions (sockets[i], subscriptions[i]);
+                    model_read_write_unlock (__FUNCTION__, __LINE__);
+                }
+        }
+    }
+    s_drain_publication_queue (context);
+    zpoller_destroy (&poller);
+}
+
+static void s_free_subscriptions (igs_subscription_t **subscriptions)
+{
+    igs_subscription_t *subscription, *tmp;
+    HASH_ITER (hh, *subscriptions, subscription, tmp){
+        HASH_DEL (*subscriptions, subscription);
+        free (subscription->filter);
+        free (subscription);
+    }
+}
+
 static void s_run_loop (zsock_t *mypipe, void *args)
 {
     s_network_lock ();
@@ -3124,23 +4695,41 @@ static void s_run_loop (zsock_t *mypipe, void *args)
         return;
     }
 
-    context->loop = zloop_new ();
+    context->loop = loop_new ();
     assert (context->loop);
-    zloop_set_verbose (context->loop, false);
-    zloop_reader (context->loop, mypipe, s_manage_parent, context);
-    zloop_reader_set_tolerant (context->loop, mypipe);
-    zloop_reader (context->loop, zyre_socket (context->node),
-                  s_manage_zyre_incoming, context);
-    zloop_reader_set_tolerant (context->loop, zyre_socket (context->node));
-    zloop_timer (context->loop, 1000, 0, trigger_definition_update, context);
-    zloop_timer (context->loop, 1000, 0, s_trigger_mapping_update, context);
+    loop_reader (context->loop, mypipe, s_manage_parent, context);
+    loop_reader (context->loop, zyre_socket (context->node),
+                 s_manage_zyre_incoming, context);
+    loop_timer (context->loop, 1000, 0, trigger_definition_update, context);
+    loop_timer (context->loop, 1000, 0, s_trigger_mapping_update, context);
+
+    // our publishers are handed over to the publisher thread
+    igs_queue_t *publication_queue =
+      s_queue_new (context->network_publication_queue_size);
+    IGS_ATOMIC_STORE (context->dropped_publications, 0);
+    IGS_MUTEX_INIT (context->publication_signal_mutex);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    context->publication_queue = publication_queue;
+    context->publisher_actor = zactor_new (s_publisher_actor, context);
+    // subscribers of our peers will be handed over to the receiver threads
+    context->nb_receivers = context->network_receive_threads;
+    context->receivers = (igs_receiver_thread_t *) zmalloc (
+      context->nb_receivers * sizeof (igs_receiver_thread_t));
+    for (size_t i = 0; i < context->nb_receivers; i++) {
+        igs_receiver_thread_t *receiver = &context->receivers[i];
+        receiver->context = context;
+        receiver->queue = s_queue_new (RECEIVER_QUEUE_SIZE);
+        receiver->backlog = zlist_new ();
+        receiver->actor = zactor_new (s_receiver_actor, receiver);
+    }
+    model_read_write_unlock (__FUNCTION__, __LINE__);
 
     zsock_signal (mypipe, 0);
     s_network_unlock ();
 
     /////////////////////
     igs_debug ("loop starting");
-    zloop_start (context->loop); // returns when one of the pollers returns -1
+    loop_start (context->loop); // returns when one of the pollers returns -1
     /////////////////////
 
     s_network_lock ();
@@ -3156,10 +4745,41 @@ static void s_run_loop (zsock_t *mypipe, void *args)
     igs_zyre_peer_t *zyre_peer, *tmp_peer;
     HASH_ITER (hh, context->zyre_peers, zyre_peer, tmp_peer)
     {
-        HASH_DEL (context->zyre_peers, zyre_peer);
-        s_clean_and_free_zyre_peer (&zyre_peer, context->loop);
+        HASH_DEL (context->zyre_peers, zyre_peer);
+        s_clean_and_free_zyre_peer (&zyre_peer, context);
+    }
+    context->zyre_peers_without_batches = 0;
+    context->zyre_peers_with_textual_topics = 0;
+
+    // stop the receiver threads once they destroyed the sockets of our
+    // peers, without the model mutex they may need meanwhile
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igs_receiver_thread_t *receivers = context->receivers;
+    size_t nb_receivers = context->nb_receivers;
+    context->receivers = NULL;
+    context->nb_receivers = 0;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    for (size_t i = 0; i < nb_receivers; i++) {
+        while (!s_flush_receiver_commands (&receivers[i]))
+            zclock_sleep (1);
+        zactor_destroy (&receivers[i].actor);
+        s_queue_destroy (&receivers[i].queue);
+        zlist_destroy (&receivers[i].backlog);
+    }
+    free (receivers);
+    loop_destroy (&context->loop);
+
+    // coalesced publications were dropped with the loop
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    HASH_ITER (hh, context->agents, agent, tmp)
+    {
+        if (agent->definition) {
+            igs_iop_t *iop, *tmp_iop;
+            HASH_ITER (hh, agent->definition->outputs_table, iop, tmp_iop)
+                iop->publication_pending = false;
+        }
     }
-    zloop_destroy (&context->loop);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
 
     igs_timer_t *current_timer, *tmp_timer;
     HASH_ITER (hh, context->timers, current_timer, tmp_timer)
@@ -3168,11 +4788,32 @@ static void s_run_loop (zsock_t *mypipe, void *args)
         free (current_timer);
     }
 
+    // stop the publisher thread, after it sent the queued publications,
+    // without the model mutex it may need meanwhile
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    zactor_t *publisher_actor = context->publisher_actor;
+    context->publisher_actor = NULL;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    zactor_destroy (&publisher_actor);
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    publication_queue = context->publication_queue;
+    context->publication_queue = NULL;
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    s_publication_queue_destroy (&publication_queue);
+    IGS_MUTEX_DESTROY (context->publication_signal_mutex);
+
     // zmq stack cleaning
     zyre_stop (context->node);
     zyre_destroy (&context->node);
+    model_read_write_lock (__FUNCTION__, __LINE__);
     zsock_destroy (&context->publisher);
     zsock_destroy (&context->ipc_publisher);
+#if defined(IGS_SHM_RING)
+    shm_ring_destroy (&context->shm_ring);
+#endif
+    s_free_subscriptions (&context->publisher_subscriptions);
+    s_free_subscriptions (&context->ipc_publisher_subscriptions);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
 #if defined(__UNIX__) && !defined(__UTYPE_IOS)
     zsys_file_delete (
       context->network_ipc_full_path); // destroy ipc_path in file system
@@ -3182,8 +4823,11 @@ static void s_run_loop (zsock_t *mypipe, void *args)
     context->network_ipc_full_path = NULL;
 #endif
 #if !defined(__UTYPE_IOS)
+    model_read_write_lock (__FUNCTION__, __LINE__);
     if (context->inproc_publisher)
         zsock_destroy (&context->inproc_publisher);
+    s_free_subscriptions (&context->inproc_publisher_subscriptions);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
 #endif
     if (context->logger)
         zsock_destroy (&context->logger);
@@ -3340,6 +4984,7 @@ void s_init_loop (igs_core_context_t *context)
       context->node, "ingescape", "v%d.%d.%d", (int) igs_version () / 10000,
       (int) (igs_version () % 10000) / 100, (int) (igs_version () % 100));
     zyre_set_header (context->node, "protocol", "v%d", igs_protocol ());
+    zyre_set_header (context->node, "publication_batches", "1");
     s_unlock_zyre_peer (__FUNCTION__, __LINE__);
 
     // Add stored headers to zyre
@@ -3357,9 +5002,10 @@ void s_init_loop (igs_core_context_t *context)
         snprintf (endpoint, 512, "tcp://%s:%d", context->ip_address,
                   context->network_publishing_port);
 
-    context->publisher = zsock_new_pub (endpoint);
+    // XPUB sockets let us know which outputs are subscribed to
+    context->publisher = zsock_new_xpub (endpoint);
     if (!context->publisher)
-        igs_error("zsock_new_pub(%s): %s", endpoint, strerror(errno));
+        igs_error("zsock_new_xpub(%s): %s", endpoint, strerror(errno));
     assert (context->publisher);
     if (context->security_is_enabled) {
         zcert_apply (context->security_cert, context->publisher);
@@ -3400,7 +5046,7 @@ void s_init_loop (igs_core_context_t *context)
     sprintf (context->network_ipc_endpoint, "ipc://%s/%s",
              context->network_ipc_folder_path, zyre_uuid (context->node));
     s_unlock_zyre_peer (__FUNCTION__, __LINE__);
-    context->ipc_publisher = zsock_new_pub (context->network_ipc_endpoint);
+    context->ipc_publisher = zsock_new_xpub (context->network_ipc_endpoint);
     assert (context->ipc_publisher);
     if (context->security_is_enabled) {
         zcert_apply (context->security_cert, context->ipc_publisher);
@@ -3410,11 +5056,26 @@ void s_init_loop (igs_core_context_t *context)
     s_lock_zyre_peer (__FUNCTION__, __LINE__);
     zyre_set_header (context->node, "ipc", "%s", context->network_ipc_endpoint);
     s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+#if defined(IGS_SHM_RING)
+    // shared-memory ring next to our ipc endpoint, read by the agents of the
+    // other processes of this host
+    if (context->network_allow_ipc && context->network_allow_shm
+        && !context->security_is_enabled) {
+        char *shm_path = zsys_sprintf ("%s.shm", context->network_ipc_full_path);
+        context->shm_ring = shm_ring_create (shm_path, IGS_SHM_RING_CAPACITY);
+        if (context->shm_ring) {
+            s_lock_zyre_peer (__FUNCTION__, __LINE__);
+            zyre_set_header (context->node, "shm", "%s", shm_path);
+            s_unlock_zyre_peer (__FUNCTION__, __LINE__);
+        }
+        zstr_free (&shm_path);
+    }
+#endif
 
 #elif defined(__WINDOWS__)
     context->network_ipc_endpoint = strdup ("tcp://127.0.0.1:*");
     zsock_t *ipc_publisher = context->ipc_publisher =
-      zsock_new_pub (context->network_ipc_endpoint);
+      zsock_new_xpub (context->network_ipc_endpoint);
     assert (context->ipc_publisher);
     if (context->security_is_enabled) {
         zcert_apply (context->security_cert, context->ipc_publisher);
@@ -3434,7 +5095,7 @@ void s_init_loop (igs_core_context_t *context)
       sizeof (char) * (12 + strlen (zyre_uuid (context->node))));
     sprintf (inproc_endpoint, "inproc://%s", zyre_uuid (context->node));
     s_unlock_zyre_peer (__FUNCTION__, __LINE__);
-    context->inproc_publisher = zsock_new_pub (inproc_endpoint);
+    context->inproc_publisher = zsock_new_xpub (inproc_endpoint);
     assert (context->inproc_publisher);
     if (context->security_is_enabled) {
         zcert_apply (context->security_cert, context->inproc_publisher);
@@ -3561,11 +5222,505 @@ void s_init_loop (igs_core_context_t *context)
 // PRIVATE API
 ////////////////////////////////////////////////////////////////////////
 
+igs_publication_t *network_publication_new (void)
+{
+    igs_publication_t *publication = (igs_publication_t *) zmalloc (sizeof (igs_publication_t));
+    publication->msg = zmsg_new ();
+    return publication;
+}
+
+void network_publication_destroy (igs_publication_t **publication)
+{
+    assert (publication);
+    if (*publication == NULL)
+        return;
+    if ((*publication)->msg)
+        zmsg_destroy (&(*publication)->msg);
+    for (size_t i = 0; i < (*publication)->nb_values; i++)
+        igs_value_release (&(*publication)->values[i]);
+    free ((*publication)->values);
+    free (*publication);
+    *publication = NULL;
+}
+
+// Appends a frame sharing value, whose reference is consumed
+static void s_publication_add_shared_value (igs_publication_t *publication,
+                                            igs_value_t *value,
+                                            size_t size)
+{
+    if (publication->nb_values == publication->values_capacity) {
+        publication->values_capacity = (publication->values_capacity) ? 2 * publication->values_capacity : 4;
+        publication->values = (igs_value_t **) realloc (publication->values,
+                                                        publication->values_capacity * sizeof (igs_value_t *));
+    }
+    // the publication keeps its own reference so that s_publication_dup
+    // can recognize the frame, the frame keeps the one it was given
+    IGS_REFCOUNT_INCREMENT (value->refcount);
+    publication->values[publication->nb_values++] = value;
+    zframe_t *frame = model_value_frame_new (value, size);
+    zmsg_append (publication->msg, &frame);
+}
+
+// Appends a copy of frame, which belongs to source, to the message of
+// target. Large values are shared with source instead of copied.
+static void s_publication_append_frame (igs_publication_t *target,
+                                        igs_publication_t *source,
+                                        zframe_t *frame)
+{
+    igs_value_t *shared = NULL;
+    for (size_t i = 0; i < source->nb_values && !shared; i++)
+        if (zframe_data (frame) == (byte *) source->values[i]->data)
+            shared = source->values[i];
+    if (shared) {
+        IGS_REFCOUNT_INCREMENT (shared->refcount);
+        s_publication_add_shared_value (target, shared, zframe_size (frame));
+    }
+    else {
+        zframe_t *frame_dup = zframe_dup (frame);
+        zmsg_append (target->msg, &frame_dup);
+    }
+}
+
+// Values larger than network_zero_copy_threshold and kept in a value
+// block are shared with the publication rather than copied into it.
+// Must be called with the agent lock held.
+static bool s_shares_output_value (const igs_iop_t *iop, size_t size)
+{
+    return iop->value_block && size > core_context->network_zero_copy_threshold;
+}
+
+// Appends the value frame of an output to a publication.
+// Must be called with the agent lock held.
+static void s_add_output_value (igs_publication_t *publication,
+                                const igs_iop_t *iop)
+{
+    zmsg_t *msg = publication->msg;
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            zmsg_addmem (msg, &(iop->value.i), sizeof (int));
+            break;
+        case IGS_DOUBLE_T:
+            zmsg_addmem (msg, &(iop->value.d), sizeof (double));
+            break;
+        case IGS_BOOL_T:
+            zmsg_addmem (msg, &(iop->value.b), sizeof (bool));
+            break;
+        case IGS_STRING_T: {
+            // strings are sent without their terminating null character
+            size_t length = (iop->value_block) ? iop->value_size - 1
+                                               : ((iop->value.s) ? strlen (iop->value.s) : 0);
+            if (s_shares_output_value (iop, length))
+                s_publication_add_shared_value (publication, model_iop_value_share (iop), length);
+            else
+                zmsg_addstr (msg, (iop->value.s) ? iop->value.s : "");
+        } break;
+        case IGS_IMPULSION_T:
+            zmsg_addmem (msg, NULL, 0);
+            break;
+        case IGS_DATA_T:
+            if (iop->value.data && s_shares_output_value (iop, iop->value_size))
+                s_publication_add_shared_value (publication, model_iop_value_share (iop), iop->value_size);
+            else
+                zmsg_addmem (msg, iop->value.data, iop->value_size);
+            break;
+        default:
+            break;
+    }
+}
+
+// Must be called with the agent lock held
+static void s_log_output_publication (igsagent_t *agent, const igs_iop_t *iop)
+{
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            igsagent_debug (agent, "%s(%s) publishes %s -> %d",
+                             agent->definition->name, agent->uuid,
+                             iop->name, iop->value.i);
+            break;
+        case IGS_DOUBLE_T:
+            igsagent_debug (agent, "%s(%s) publishes %s -> %f",
+                             agent->definition->name, agent->uuid,
+                             iop->name, iop->value.d);
+            break;
+        case IGS_BOOL_T:
+            igsagent_debug (agent, "%s(%s) publishes %s -> %d",
+                             agent->definition->name, agent->uuid,
+                             iop->name, iop->value.b);
+            break;
+        case IGS_STRING_T:
+            igsagent_debug (agent, "%s(%s) publishes %s -> '%s'",
+                             agent->definition->name, agent->uuid,
+                             iop->name, iop->value.s);
+            break;
+        case IGS_IMPULSION_T:
+            igsagent_debug (agent, "%s(%s) publishes impulsion %s",
+                             agent->definition->name, agent->uuid,
+                             iop->name);
+            break;
+        case IGS_DATA_T:
+            igsagent_debug (agent, "%s(%s) publishes data %s (%zu bytes)",
+                             agent->definition->name, agent->uuid,
+                             iop->name, iop->value_size);
+            break;
+        default:
+            break;
+    }
+}
+
+// Builds the protocol v5 publication of a batch of outputs of the agent
+// with this uuid, sharing the large values of the batch
+static igs_publication_t *s_compact_batch (const char *uuid,
+                                           igs_publication_t *batch,
+                                           const byte *topic)
+{
+    igs_publication_t *compact = network_publication_new ();
+    zmsg_addmem (compact->msg, topic, PUBLICATION_V5_TOPIC_LENGTH);
+    zframe_t *name_frame = zmsg_first (batch->msg);
+    while (name_frame) {
+        zframe_t *type_frame = zmsg_next (batch->msg);
+        zframe_t *value_frame = zmsg_next (batch->msg);
+        if (type_frame == NULL || value_frame == NULL)
+            break;
+        char output_topic[IGS_MAX_IOP_NAME_LENGTH + 64] = "";
+        snprintf (output_topic, IGS_MAX_IOP_NAME_LENGTH + 64, "%s-%.*s", uuid,
+                  (int) zframe_size (name_frame), (char *) zframe_data (name_frame));
+        byte header[PUBLICATION_V5_HEADER_LENGTH];
+        s_write_topic_id (header, s_topic_id (output_topic));
+        header[8] = (byte) s_parse_value_type (type_frame);
+        zmsg_addmem (compact->msg, header, PUBLICATION_V5_HEADER_LENGTH);
+        s_publication_append_frame (compact, batch, value_frame);
+        name_frame = zmsg_next (batch->msg);
+    }
+    return compact;
+}
+
+// Filters are prefixes of the topics they subscribe to
+static bool s_has_subscriber (igs_subscription_t *subscriptions,
+                              const char *topic,
+                              size_t topic_length)
+{
+    igs_subscription_t *subscription = NULL;
+    HASH_FIND (hh, subscriptions, topic, topic_length, subscription);
+    if (subscription)
+        return true;
+    // protocol v5 filters are exact, apart from empty filters
+    // subscribing to everything
+    if (topic_length > 0 && (byte) topic[0] == PUBLICATION_V5_MARKER) {
+        HASH_FIND (hh, subscriptions, topic, 0, subscription);
+        return (subscription != NULL);
+    }
+    for (subscription = subscriptions; subscription; subscription = subscription->hh.next) {
+        if (subscription->length <= topic_length
+            && memcmp (subscription->filter, topic, subscription->length) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Returns the publishers having subscribers for topic, as a combination
+// of PUBLISHER_* flags. Must be called with the model mutex locked.
+static int s_subscribed_publishers (const char *topic, size_t topic_length)
+{
+    int publishers = 0;
+    if (!core_context->network_actor || !core_context->publisher)
+        return 0;
+    if (s_has_subscriber (core_context->publisher_subscriptions, topic, topic_length))
+        publishers |= PUBLISHER_TCP;
+    if (core_context->ipc_publisher
+        && s_has_subscriber (core_context->ipc_publisher_subscriptions, topic, topic_length))
+        publishers |= PUBLISHER_IPC;
+    if (core_context->inproc_publisher
+        && s_has_subscriber (core_context->inproc_publisher_subscriptions, topic, topic_length))
+        publishers |= PUBLISHER_INPROC;
+    if (core_context->shm_ring && topic_length == PUBLICATION_V5_TOPIC_LENGTH
+        && (byte) topic[0] == PUBLICATION_V5_MARKER) {
+        // readers of our ring subscribe exactly to its topics
+        char shm_topic[PUBLICATION_V5_TOPIC_LENGTH];
+        memcpy (shm_topic, topic, PUBLICATION_V5_TOPIC_LENGTH);
+        shm_topic[0] = PUBLICATION_SHM_MARKER;
+        igs_subscription_t *subscription = NULL;
+        HASH_FIND (hh, core_context->ipc_publisher_subscriptions, shm_topic,
+                   PUBLICATION_V5_TOPIC_LENGTH, subscription);
+        if (subscription)
+            publishers |= PUBLISHER_SHM;
+    }
+    return publishers;
+}
+
+// Queues a publication for the TCP, IPC and inproc publishers given by
+// s_subscribed_publishers, to be sent by the publisher thread. Publication
+// is consumed. Output name is NULL for batches. Must be called with the
+// model mutex locked, which keeps the publisher thread alive. Only the
+// producer clearing is_waiting signals the publisher thread, and the signal
+// mutex keeps producers of successive waits from sharing its pipe at once.
+static igs_result_t s_send_publication (igsagent_t *agent,
+                                        igs_publication_t **publication,
+                                        int publishers,
+                                        const char *output_name)
+{
+    igs_result_t result = IGS_SUCCESS;
+    const char *what = (output_name) ? output_name : "batch";
+    igs_core_context_t *context = agent->context;
+    if (context->network_actor && context->publisher) {
+        if (publishers && *publication) {
+            if (context->publisher_actor
+                && s_queue_push (context->publication_queue,
+                                 *publication, publishers)) {
+                *publication = NULL;
+                if (IGS_ATOMIC_EXCHANGE (context->publication_queue->is_waiting, 0)) {
+                    IGS_MUTEX_LOCK (context->publication_signal_mutex);
+                    zsock_signal (zactor_sock (context->publisher_actor), 0);
+                    IGS_MUTEX_UNLOCK (context->publication_signal_mutex);
+                }
+            }
+            else {
+                // queue is full, like the HWM of a publisher
+                IGS_ATOMIC_ADD (context->dropped_publications, 1);
+                igsagent_debug (agent, "publication queue is full : dropping output %s",
+                                what);
+                result = IGS_FAILURE;
+            }
+        }
+    }
+    else
+        igsagent_warn (
+          agent,
+          "agent not started : could not publish output %s to the "
+          "network (published to agents in same process only)",
+          what);
+    network_publication_destroy (publication);
+    return result;
+}
+
+static igs_result_t s_publish_output_locked (igsagent_t *agent, const igs_iop_t *iop);
+
+static void s_coalesced_publication_destroy (void *arg)
+{
+    igs_coalesced_publication_t *publication = (igs_coalesced_publication_t *) arg;
+    free (publication->agent_uuid);
+    free (publication->output_name);
+    free (publication);
+}
+
+// Timer callback publishing the latest value of a rate-limited output.
+// The agent is found and published under the same lock, so that it cannot
+// be destroyed meanwhile.
+static int s_publish_coalesced_output (igs_loop_t *loop, int timer_id, void *arg)
+{
+    IGS_UNUSED (loop)
+    IGS_UNUSED (timer_id)
+    igs_coalesced_publication_t *publication = (igs_coalesced_publication_t *) arg;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    igsagent_t *agent = NULL;
+    igs_iop_t *iop = NULL;
+    HASH_FIND_STR (core_context->agents, publication->agent_uuid, agent);
+    if (agent && agent->definition)
+        HASH_FIND_STR (agent->definition->outputs_table, publication->output_name, iop);
+    if (iop && iop->publication_pending) {
+        // free slot for the publication below
+        iop->publication_pending = false;
+        iop->last_publication_time = 0;
+        if (!agent->is_whole_agent_muted && !iop->is_muted
+            && !agent->context->is_frozen) {
+            s_publish_output_locked (agent, iop);
+            return 0;
+        }
+    }
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return 0;
+}
+
+// Publication is owned by the timer, or freed if the loop is gone
+static void s_schedule_coalesced_publication (igs_coalesced_publication_t *publication,
+                                              int64_t delay)
+{
+    s_network_lock ();
+    if (core_context->loop) {
+        size_t delay_ms = (size_t) ((delay + 999) / 1000);
+        loop_timer_owning (core_context->loop, delay_ms, 1, s_publish_coalesced_output,
+                           publication, s_coalesced_publication_destroy);
+    }
+    else
+        s_coalesced_publication_destroy (publication);
+    s_network_unlock ();
+}
+
+// Captures the value of iop for the agents of our process. Must be called
+// with the agent locked. Release local->shared when done.
+static void s_capture_local_publication (const igs_iop_t *iop,
+                                         igs_local_publication_t *local)
+{
+    local->value_type = iop->value_type;
+    local->shared = NULL;
+    local->data = NULL;
+    local->size = 0;
+    switch (iop->value_type) {
+        case IGS_INTEGER_T:
+            local->value.i = iop->value.i;
+            local->data = &local->value.i;
+            local->size = sizeof (int);
+            break;
+        case IGS_DOUBLE_T:
+            local->value.d = iop->value.d;
+            local->data = &local->value.d;
+            local->size = sizeof (double);
+            break;
+        case IGS_BOOL_T:
+            local->value.b = iop->value.b;
+            local->data = &local->value.b;
+            local->size = sizeof (bool);
+            break;
+        case IGS_STRING_T: {
+            const char *string = (iop->value.s) ? iop->value.s : "";
+            local->size = strlen (string) + 1;
+            if (local->size <= sizeof (local->value.bytes)) {
+                memcpy (local->value.bytes, string, local->size);
+                local->data = local->value.bytes;
+            }
+            else {
+                local->shared = model_iop_value_share (iop);
+                local->data = local->shared->data;
+            }
+        } break;
+        case IGS_DATA_T:
+            local->size = iop->value_size;
+            if (iop->value.data == NULL || local->size <= sizeof (local->value.bytes)) {
+                if (local->size)
+                    memcpy (local->value.bytes, iop->value.data, local->size);
+                local->data = local->value.bytes;
+            }
+            else {
+                local->shared = model_iop_value_share (iop);
+                local->data = local->shared->data;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Writes a captured output value to the inputs of the agents of our process
+// mapped on it, without using any message. Must be called with the model
+// mutex locked, which is released.
+static void s_publish_locally (const char *agent_name,
+                               const char *output_name,
+                               igs_local_publication_t *local)
+{
+    s_write_mapped_inputs (core_context, agent_name, output_name,
+                           local->value_type, local->data, local->size);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    igs_value_release (&local->shared);
+}
+
+// Publishes an output of an agent that is not muted nor frozen. Must be
+// called with the model mutex locked, which is released on return.
+static igs_result_t s_publish_output_locked (igsagent_t *agent, const igs_iop_t *iop)
+{
+    int result = IGS_SUCCESS;
+    // publication state is only modified under the model mutex
+    igs_iop_t *state = (igs_iop_t *) iop;
+    if (iop->publication_period > 0 && agent->context->loop) {
+        int64_t now = zclock_usecs ();
+        int64_t elapsed = now - iop->last_publication_time;
+        if (elapsed < iop->publication_period) {
+            // coalesce: the value at the end of the period wins
+            int64_t delay = iop->publication_period - elapsed;
+            igs_coalesced_publication_t *publication = NULL;
+            if (!iop->publication_pending) {
+                publication = (igs_coalesced_publication_t *) zmalloc (sizeof (igs_coalesced_publication_t));
+                publication->agent_uuid = strdup (agent->uuid);
+                publication->output_name = strdup (iop->name);
+                state->publication_pending = true;
+            }
+            model_read_write_unlock (__FUNCTION__, __LINE__);
+            // scheduled without the model mutex, see s_network_lock
+            if (publication)
+                s_schedule_coalesced_publication (publication, delay);
+            return IGS_SUCCESS;
+        }
+        state->last_publication_time = now;
+        state->publication_pending = false;
+    }
+    // iop value is protected by the agent lock while we copy it
+    model_agent_read_lock (agent);
+    if (iop->publish_on_change_only
+        && model_iop_publication_is_unchanged (state)) {
+        state->suppressed_publications++;
+        model_agent_read_unlock (agent);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_SUCCESS;
+    }
+    split_add_work_to_queue (agent->context, agent->uuid, iop);
+    if (agent->outputs_batch) {
+        // published later by igsagent_outputs_commit
+        zmsg_addstr (agent->outputs_batch->msg, iop->name);
+        zmsg_addstrf (agent->outputs_batch->msg, "%d", iop->value_type);
+        s_add_output_value (agent->outputs_batch, iop);
+        s_log_output_publication (agent, iop);
+        model_agent_read_unlock (agent);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        return IGS_SUCCESS;
+    }
+    // textual topics are only built for peers older than protocol v5
+    char topic[IGS_MAX_IOP_NAME_LENGTH + 64] = "";
+    bool textual_topics = (agent->context->zyre_peers_with_textual_topics > 0);
+    if (textual_topics || iop->publication_topic_id == 0)
+        snprintf (topic, IGS_MAX_IOP_NAME_LENGTH + 64, "%s-%s", agent->uuid, iop->name);
+    if (iop->publication_topic_id == 0)
+        state->publication_topic_id = s_topic_id (topic);
+    int publishers = (textual_topics) ? s_subscribed_publishers (topic, strlen (topic)) : 0;
+    // peers using protocol v5 subscribe to the compact topic, which is
+    // directly followed by the type byte
+    byte compact_topic[PUBLICATION_V5_TOPIC_LENGTH + 1];
+    s_write_compact_topic (compact_topic, iop->publication_topic_id);
+    compact_topic[PUBLICATION_V5_TOPIC_LENGTH] = (byte) iop->value_type;
+    int compact_publishers = s_subscribed_publishers ((const char *) compact_topic,
+                                                      PUBLICATION_V5_TOPIC_LENGTH);
+    igs_publication_t *publication = NULL;
+    if (publishers) {
+        publication = network_publication_new ();
+        zmsg_addstr (publication->msg, topic);
+        zmsg_addstrf (publication->msg, "%d", iop->value_type);
+        s_add_output_value (publication, iop);
+    }
+    igs_publication_t *compact_publication = NULL;
+    if (compact_publishers) {
+        compact_publication = network_publication_new ();
+        zmsg_addmem (compact_publication->msg, compact_topic,
+                     PUBLICATION_V5_TOPIC_LENGTH + 1);
+        s_add_output_value (compact_publication, iop);
+    }
+    s_log_output_publication (agent, iop);
+    // agents of our process get the value itself, names are copied
+    // because the model is unlocked while their inputs are written
+    igs_local_publication_t local;
+    char agent_name[IGS_MAX_AGENT_NAME_LENGTH + 1] = "";
+    char output_name[IGS_MAX_IOP_NAME_LENGTH + 1] = "";
+    if (!agent->is_virtual) {
+        s_capture_local_publication (iop, &local);
+        snprintf (agent_name, IGS_MAX_AGENT_NAME_LENGTH + 1, "%s", agent->definition->name);
+        snprintf (output_name, IGS_MAX_IOP_NAME_LENGTH + 1, "%s", iop->name);
+    }
+    model_agent_read_unlock (agent);
+
+    result = s_send_publication (agent, &publication, publishers, iop->name);
+    if (compact_publication
+        && s_send_publication (agent, &compact_publication, compact_publishers,
+                               iop->name) != IGS_SUCCESS)
+        result = IGS_FAILURE;
+    // 4- distribute publication to other agents inside our context
+    // without using the network
+    if (!agent->is_virtual)
+        s_publish_locally (agent_name, output_name, &local);
+    else
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+    return result;
+}
+
 igs_result_t network_publish_output (igsagent_t *agent, const igs_iop_t *iop)
 {
     assert (agent);
     assert (agent->context);
-    assert (agent->uuid);
     assert (iop);
     assert (iop->name);
     int result = IGS_SUCCESS;
@@ -3574,120 +5729,12 @@ igs_result_t network_publish_output (igsagent_t *agent, const igs_iop_t *iop)
     if (!agent->is_whole_agent_muted && !iop->is_muted
         && !agent->context->is_frozen) {
         model_read_write_lock (__FUNCTION__, __LINE__);
-        split_add_work_to_queue (agent->context, agent->uuid, iop);
         // check that this agent has not been destroyed when we were locked
         if (!agent || !(agent->uuid)) {
             model_read_write_unlock (__FUNCTION__, __LINE__);
             return IGS_SUCCESS;
         }
-        zmsg_t *msg = zmsg_new ();
-        zmsg_addstrf (msg, "%s-%s", agent->uuid, iop->name);
-        zmsg_addstrf (msg, "%d", iop->value_type);
-        switch (iop->value_type) {
-            case IGS_INTEGER_T:
-                zmsg_addmem (msg, &(iop->value.i), sizeof (int));
-                igsagent_debug (agent, "%s(%s) publishes %s -> %d",
-                                 agent->definition->name, agent->uuid,
-                                 iop->name, iop->value.i);
-                break;
-            case IGS_DOUBLE_T:
-                zmsg_addmem (msg, &(iop->value.d), sizeof (double));
-                igsagent_debug (agent, "%s(%s) publishes %s -> %f",
-                                 agent->definition->name, agent->uuid,
-                                 iop->name, iop->value.d);
-                break;
-            case IGS_BOOL_T:
-                zmsg_addmem (msg, &(iop->value.b), sizeof (bool));
-                igsagent_debug (agent, "%s(%s) publishes %s -> %d",
-                                 agent->definition->name, agent->uuid,
-                                 iop->name, iop->value.b);
-                break;
-            case IGS_STRING_T:
-                zmsg_addstr (msg, iop->value.s);
-                igsagent_debug (agent, "%s(%s) publishes %s -> '%s'",
-                                 agent->definition->name, agent->uuid,
-                                 iop->name, iop->value.s);
-                break;
-            case IGS_IMPULSION_T:
-                zmsg_addmem (msg, NULL, 0);
-                igsagent_debug (agent, "%s(%s) publishes impulsion %s",
-                                 agent->definition->name, agent->uuid,
-                                 iop->name);
-                break;
-            case IGS_DATA_T: {
-                zframe_t *frame = zframe_new (iop->value.data, iop->value_size);
-                zmsg_append (msg, &frame);
-                igsagent_debug (agent, "%s(%s) publishes data %s (%zu bytes)",
-                                 agent->definition->name, agent->uuid,
-                                 iop->name, iop->value_size);
-            } break;
-            default:
-                break;
-        }
-
-        // 1- publish to TCP
-        zmsg_t *msg_quater = zmsg_dup (msg);
-        if (agent->context->network_actor && agent->context->publisher) {
-            zmsg_t *msg_bis = zmsg_dup (msg);
-            zmsg_t *msg_ter = zmsg_dup (msg);
-            if (zmsg_send (&msg, core_context->publisher) != 0) {
-                igsagent_error (agent,
-                                 "Could not publish output %s on the network\n",
-                                 iop->name);
-                zmsg_destroy (&msg);
-                result = IGS_FAILURE;
-            }
-            // 2- publish to IPC
-            if (core_context->ipc_publisher) {
-                // publisher can be NULL on IOS or for read/write problems with assigned
-                // IPC path in both cases, an error message has been issued at start
-                if (zmsg_send (&msg_bis, core_context->ipc_publisher) != 0) {
-                    igsagent_error (agent,
-                                     "Could not publish output %s using IPC\n",
-                                     iop->name);
-                    zmsg_destroy (&msg_bis);
-                    result = IGS_FAILURE;
-                }
-            }
-            // 3- publish to inproc
-            if (core_context->inproc_publisher) {
-                if (zmsg_send (&msg_ter, core_context->inproc_publisher) != 0) {
-                    igsagent_error (
-                      agent, "Could not publish output %s using inproc\n",
-                      iop->name);
-                    zmsg_destroy (&msg_ter);
-                    result = IGS_FAILURE;
-                }
-            }
-        }
-        else {
-            zmsg_destroy (&msg);
-            igsagent_warn (
-              agent,
-              "agent not started : could not publish output %s to the "
-              "network (published to agents in same process only)",
-              iop->name);
-        }
-        // 4- distribute publication message to other agents inside our context
-        // without using the network
-        if (!agent->is_virtual) {
-            free (zmsg_popstr (msg_quater)); // remove composite uuid/iop name
-            zmsg_pushstr (msg_quater,
-                          iop->name); // replace it by simple iop name
-            // Generate a temporary fake remote agent, containing only
-            // necessary information for s_handle_publication_from_remote_agent.
-            igs_remote_agent_t *fake_remote = (igs_remote_agent_t *) zmalloc (sizeof (igs_remote_agent_t));
-            fake_remote->context = core_context;
-            fake_remote->definition = (igs_definition_t *) zmalloc (sizeof (igs_definition_t));
-            fake_remote->definition->name = agent->definition->name;
-            model_read_write_unlock (__FUNCTION__, __LINE__); // to avoid deadlock inside s_handle_publication_from_remote_agent
-            s_handle_publication_from_remote_agent (msg_quater, fake_remote);
-            free (fake_remote->definition);
-            free (fake_remote);
-        }
-        else
-            model_read_write_unlock (__FUNCTION__, __LINE__);
-        zmsg_destroy (&msg_quater);
+        result = s_publish_output_locked (agent, iop);
     }
     else {
         if (agent->is_whole_agent_muted)
@@ -3706,7 +5753,107 @@ igs_result_t network_publish_output (igsagent_t *agent, const igs_iop_t *iop)
     return result;
 }
 
-int network_timer_callback (zloop_t *loop, int timer_id, void *arg)
+igs_result_t network_publish_outputs_batch (igsagent_t *agent, igs_publication_t **batch)
+{
+    assert (agent);
+    assert (agent->context);
+    assert (batch);
+    assert (*batch);
+    igs_result_t result = IGS_SUCCESS;
+    if (zmsg_size ((*batch)->msg) == 0) {
+        network_publication_destroy (batch);
+        return IGS_SUCCESS;
+    }
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    // check that this agent has not been destroyed when we were locked
+    if (!(agent->uuid)) {
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        network_publication_destroy (batch);
+        return IGS_SUCCESS;
+    }
+    zmsg_t *local_batch = NULL;
+    char topic[IGS_MAX_IOP_NAME_LENGTH + 64] = "";
+    igs_result_t compact_result = IGS_SUCCESS;
+    if (agent->context->network_actor && agent->context->publisher) {
+        // peers using protocol v5 get their own version of the batch,
+        // built before the batch message is consumed below
+        snprintf (topic, IGS_MAX_IOP_NAME_LENGTH + 64, "%s%s", agent->uuid, PUBLICATION_BATCH_SUFFIX);
+        byte compact_topic[PUBLICATION_V5_TOPIC_LENGTH];
+        s_write_compact_topic (compact_topic, s_topic_id (topic));
+        int compact_publishers = s_subscribed_publishers ((const char *) compact_topic,
+                                                          PUBLICATION_V5_TOPIC_LENGTH);
+        if (compact_publishers) {
+            igs_publication_t *compact_batch = s_compact_batch (agent->uuid, *batch, compact_topic);
+            compact_result = s_send_publication (agent, &compact_batch, compact_publishers, NULL);
+        }
+    }
+    if (!agent->context->network_actor || !agent->context->publisher) {
+        local_batch = (*batch)->msg;
+        (*batch)->msg = NULL;
+        result = s_send_publication (agent, batch, 0, NULL);
+    }
+    else if (agent->context->zyre_peers_with_textual_topics == 0) {
+        // all our peers got the protocol v5 batch
+        local_batch = (*batch)->msg;
+        (*batch)->msg = NULL;
+    }
+    else if (agent->context->zyre_peers_without_batches == 0) {
+        snprintf (topic, IGS_MAX_IOP_NAME_LENGTH + 64, "%s%s", agent->uuid, PUBLICATION_BATCH_SUFFIX);
+        int publishers = s_subscribed_publishers (topic, strlen (topic));
+        if (publishers) {
+            local_batch = s_publication_dup (*batch);
+            zmsg_pushstr ((*batch)->msg, topic);
+            result = s_send_publication (agent, batch, publishers, NULL);
+        }
+        else {
+            local_batch = (*batch)->msg;
+            (*batch)->msg = NULL;
+        }
+    }
+    else {
+        // some peers only understand one output per publication,
+        // which share the values held by the batch
+        local_batch = s_publication_dup (*batch);
+        zframe_t *name_frame = zmsg_first ((*batch)->msg);
+        while (name_frame) {
+            zframe_t *type_frame = zmsg_next ((*batch)->msg);
+            zframe_t *value_frame = zmsg_next ((*batch)->msg);
+            if (type_frame == NULL || value_frame == NULL)
+                break;
+            char output_name[IGS_MAX_IOP_NAME_LENGTH + 1] = "";
+            snprintf (output_name, IGS_MAX_IOP_NAME_LENGTH + 1, "%.*s",
+                      (int) zframe_size (name_frame), (char *) zframe_data (name_frame));
+            snprintf (topic, IGS_MAX_IOP_NAME_LENGTH + 64, "%s-%s", agent->uuid, output_name);
+            int publishers = s_subscribed_publishers (topic, strlen (topic));
+            if (publishers) {
+                igs_publication_t *single = network_publication_new ();
+                zmsg_addstr (single->msg, topic);
+                s_publication_append_frame (single, *batch, type_frame);
+                s_publication_append_frame (single, *batch, value_frame);
+                if (s_send_publication (agent, &single, publishers, output_name) != IGS_SUCCESS)
+                    result = IGS_FAILURE;
+            }
+            name_frame = zmsg_next ((*batch)->msg);
+        }
+    }
+    if (compact_result != IGS_SUCCESS)
+        result = IGS_FAILURE;
+    // distribute the batch to other agents inside our context without
+    // using the network
+    if (!agent->is_virtual) {
+        char agent_name[IGS_MAX_AGENT_NAME_LENGTH + 1] = "";
+        snprintf (agent_name, IGS_MAX_AGENT_NAME_LENGTH + 1, "%s", agent->definition->name);
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+        s_dispatch_publication (core_context, agent_name, local_batch);
+    }
+    else
+        model_read_write_unlock (__FUNCTION__, __LINE__);
+    zmsg_destroy (&local_batch);
+    network_publication_destroy (batch);
+    return result;
+}
+
+int network_timer_callback (igs_loop_t *loop, int timer_id, void *arg)
 {
     IGS_UNUSED (loop)
     IGS_UNUSED (timer_id)
@@ -4818,6 +6965,18 @@ bool igs_has_ipc ()
     return core_context->network_allow_ipc;
 }
 
+void igs_set_shm (bool allow)
+{
+    core_init_context ();
+    core_context->network_allow_shm = allow;
+}
+
+bool igs_has_shm ()
+{
+    core_init_context ();
+    return core_context->network_allow_shm;
+}
+
 void igs_net_set_high_water_marks (int hwm_value)
 {
     core_init_context ();
@@ -4827,21 +6986,94 @@ void igs_net_set_high_water_marks (int hwm_value)
     }
     if (core_context->network_actor
         && core_context->publisher) {
-        zsock_set_sndhwm (core_context->publisher, hwm_value);
-        if (core_context->ipc_publisher)
-            zsock_set_sndhwm (core_context->ipc_publisher, hwm_value);
-        if (core_context->inproc_publisher)
-            zsock_set_sndhwm (core_context->inproc_publisher, hwm_value);
-        zsock_set_sndhwm (core_context->logger, hwm_value);
-        igs_zyre_peer_t *tmp = NULL, *peer = NULL;
-        HASH_ITER (hh, core_context->zyre_peers, peer, tmp)
-        {
-            zsock_set_rcvhwm (peer->subscriber, hwm_value);
+        admin_set_logger_hwm (hwm_value);
+        // publishers are owned by the publisher thread, and subscribers of
+        // our peers by the receiver threads, which apply the new value
+        // themselves: subscribers are updated the next time their receiver
+        // thread wakes up, as only the network thread signals them
+        model_read_write_lock (__FUNCTION__, __LINE__);
+        if (core_context->publisher_actor) {
+            char value[16];
+            snprintf (value, sizeof (value), "%d", hwm_value);
+            IGS_MUTEX_LOCK (core_context->publication_signal_mutex);
+            zstr_sendx (zactor_sock (core_context->publisher_actor), "HWM",
+                        value, NULL);
+            IGS_MUTEX_UNLOCK (core_context->publication_signal_mutex);
         }
+        for (size_t i = 0; i < core_context->nb_receivers; i++) {
+            igs_receiver_command_t *command = s_receiver_command_new (RECEIVER_SET_HWM);
+            command->hwm = hwm_value;
+            if (!s_queue_push (core_context->receivers[i].queue, command, 0)) {
+                igs_warn ("receiver queue is full : HWM of some subscribers is unchanged");
+                free (command);
+            }
+        }
+        model_read_write_unlock (__FUNCTION__, __LINE__);
     }
     core_context->network_hwm_value = hwm_value;
 }
 
+void igs_net_set_publication_queue_size (size_t size)
+{
+    core_init_context ();
+    if (size == 0) {
+        igs_error ("publication queue size must be greater than zero");
+        return;
+    }
+    if (core_context->network_actor && core_context->publisher)
+        igs_warn ("agent is already started : new publication queue size "
+                  "will be used at next start");
+    core_context->network_publication_queue_size = size;
+}
+
+void igs_net_set_receive_threads (size_t nb_threads)
+{
+    core_init_context ();
+    if (nb_threads == 0) {
+        igs_error ("number of receive threads must be greater than zero");
+        return;
+    }
+    if (core_context->network_actor && core_context->publisher)
+        igs_warn ("agent is already started : new number of receive threads "
+                  "will be used at next start");
+    core_context->network_receive_threads = nb_threads;
+}
+
+size_t igs_net_receive_threads (void)
+{
+    core_init_context ();
+    return core_context->network_receive_threads;
+}
+
+size_t igs_net_publication_queue_depth (void)
+{
+    core_init_context ();
+    size_t depth = 0;
+    model_read_write_lock (__FUNCTION__, __LINE__);
+    if (core_context->publication_queue)
+        depth = s_queue_depth (core_context->publication_queue);
+    model_read_write_unlock (__FUNCTION__, __LINE__);
+    return depth;
+}
+
+size_t igs_net_dropped_publications (void)
+{
+    core_init_context ();
+    return (size_t) IGS_ATOMIC_LOAD (core_context->dropped_publications);
+}
+
+void igs_net_set_zero_copy_threshold (size_t size)
+{
+    core_init_context ();
+    core_context->network_zero_copy_threshold = size;
+}
+
+size_t igs_net_zero_copy_threshold (void)
+{
+    core_init_context ();
+    return core_context->network_zero_copy_threshold;
+}
+
 void igs_net_raise_sockets_limit ()
 {
     core_init_context ();
@@ -4909,8 +7141,8 @@ int igs_timer_start (size_t delay, size_t times, igs_timer_fn cb, void *my_data)
     igs_timer_t *timer = (igs_timer_t *) zmalloc (sizeof (igs_timer_t));
     timer->cb = cb;
     timer->my_data = my_data;
-    timer->timer_id = zloop_timer (core_context->loop, delay, times,
-                                   network_timer_callback, timer);
+    timer->timer_id = loop_timer (core_context->loop, delay, times,
+                                  network_timer_callback, timer);
     HASH_ADD_INT (core_context->timers, timer_id, timer);
     s_network_unlock ();
     return timer->timer_id;
@@ -4927,7 +7159,7 @@ void igs_timer_stop (int timer_id)
     igs_timer_t *timer = NULL;
     HASH_FIND_INT (core_context->timers, &timer_id, timer);
     if (timer) {
-        zloop_timer_end (core_context->loop, timer_id);
+        loop_timer_end (core_context->loop, timer_id);
         HASH_DEL (core_context->timers, timer);
         free (timer);
     }
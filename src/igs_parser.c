@@ -1660,9 +1660,12 @@ igs_result_t igsagent_definition_load_str (igsagent_t *agent,
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
+    model_agent_write_lock (agent);
     igsagent_set_name (agent, tmp->name);
     definition_free_definition (&agent->definition);
     agent->definition = tmp;
+    agent->definition_generation++;
+    model_agent_write_unlock (agent);
     agent->network_need_to_send_definition_update = true;
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
@@ -1687,10 +1690,13 @@ igs_result_t igsagent_definition_load_file (igsagent_t *agent,
         model_read_write_unlock (__FUNCTION__, __LINE__);
         return IGS_FAILURE;
     }
+    model_agent_write_lock (agent);
     igsagent_set_name (agent, tmp->name);
     definition_free_definition (&agent->definition);
     agent->definition_path = s_strndup (file_path, IGS_MAX_PATH_LENGTH - 1);
     agent->definition = tmp;
+    agent->definition_generation++;
+    model_agent_write_unlock (agent);
     agent->network_need_to_send_definition_update = true;
     model_read_write_unlock (__FUNCTION__, __LINE__);
     return IGS_SUCCESS;
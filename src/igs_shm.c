@@ -0,0 +1,723 @@
+/*  =========================================================================
+    shm - shared-memory ring of publications for agents on the same host
+
+    Copyright (c) the Contributors as noted in the AUTHORS file.
+    This file is part of Ingescape, see https://github.com/zeromq/ingescape.
+
+    This Source Code Form is subject to the terms of the Mozilla Public
+    License, v. 2.0. If a copy of the MPL was not distributed with this
+    file, You can obtain one at http://mozilla.org/MPL/2.0/.
+    =========================================================================
+*/
+
+#include "ingescape_private.h"
+
+#if defined(IGS_SHM_RING)
+
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// The ring is a file mapped by its writer, the publisher thread of an
+// agent, and by the network threads of the agents subscribing to it from
+// other processes. The file starts with a header, followed by the data
+// area, whose capacity is a power of two. Positions are counted in bytes
+// since the creation of the ring and never wrap.
+//
+// Each publication is a record aligned on 8 bytes:
+// - its length, not counting this 8-byte record header, then its number
+// of frames, both as native uint32,
+// - each frame as its size (native uint32) followed by its bytes.
+// A record never wraps around the end of the data area: the writer puts a
+// SHM_RECORD_WRAP length instead and continues at the beginning.
+//
+// The writer announces the end of the record it is about to write in
+// reserve_position, writes it and then publishes it in write_position. A
+// reader copying a record checks reserve_position afterwards to know if
+// the writer overtook it meanwhile. Readers wait on the signal futex,
+// incremented for each record, and the writer only wakes them up when
+// some of them are waiting.
+//
+// Readers only copy the records whose topic, their first frame, is one of
+// their filters. Topics start with a protocol marker, which is not part of
+// the comparison, and are compared whole: the ring only carries protocol
+// v5 topics, which have a fixed length.
+//
+// Frames of at least SHM_SEGMENT_THRESHOLD bytes are written in segments,
+// files named after the ring and suffixed by their index, and the record
+// only holds a handle on them: its size has SHM_FRAME_HANDLE set and its
+// bytes are the segment index, the offset, the size and the generation
+// of the frame in the segment. Readers map the segments and read frames
+// in place, counting themselves in the segment header while they do. The
+// writer reuses the least recently written segment without readers, once
+// it owns SHM_MIN_SEGMENTS of them, so that the latest large frames stay
+// readable for a while. The generation of a segment is odd while the
+// writer fills it, and readers give up frames of older generations.
+#define SHM_RING_MAGIC 0x49475352 // "IGSR"
+#define SHM_RING_VERSION 2
+#define SHM_RING_HEADER_SIZE 64
+#define SHM_RECORD_HEADER_SIZE 8
+#define SHM_RECORD_WRAP UINT32_MAX
+#define SHM_ALIGN(size) (((size) + 7) & ~((size_t) 7))
+#define SHM_SEGMENT_MAGIC 0x49475353 // "IGSS"
+#define SHM_SEGMENT_HEADER_SIZE 64
+#define SHM_SEGMENT_THRESHOLD (1024 * 1024)
+#define SHM_MIN_SEGMENTS 4
+#define SHM_MAX_SEGMENTS 16
+#define SHM_FRAME_HANDLE 0x80000000u
+#define SHM_HANDLE_SIZE 32
+
+typedef struct shm_segment_header {
+    uint32_t magic;
+    uint32_t readers;
+    uint64_t generation;
+} shm_segment_header_t;
+
+// mapping of a segment, shared on the reader side by the ring and the
+// frames read in place
+typedef struct shm_segment {
+    igs_refcount_t refcount;
+    shm_segment_header_t *header;
+    size_t mapped_size;
+    uint64_t last_write; // writer only
+} shm_segment_t;
+
+typedef struct shm_ring_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t write_position;
+    uint64_t reserve_position;
+    uint32_t signal;
+    uint32_t waiters;
+} shm_ring_header_t;
+
+// topic of the records copied by a reader, see shm_ring_subscribe
+typedef struct shm_filter {
+    byte *topic; //without its marker
+    size_t length;
+    size_t count;
+    UT_hash_handle hh;
+} shm_filter_t;
+
+struct igs_shm_ring {
+    char *path;
+    bool is_writer;
+    shm_ring_header_t *header;
+    byte *data;
+    size_t mapped_size;
+    uint64_t read_position; // readers only
+    size_t lost; // readers only
+    shm_filter_t *filters; // readers only
+    shm_segment_t *segments[SHM_MAX_SEGMENTS];
+    uint64_t nb_writes; // writer only
+};
+
+static long s_futex (uint32_t *address, int operation, uint32_t value, int timeout)
+{
+    struct timespec delay = {timeout / 1000, (timeout % 1000) * 1000000L};
+    return syscall (SYS_futex, address, operation, value,
+                    (timeout >= 0) ? &delay : NULL, NULL, 0);
+}
+
+// Wakes up the readers waiting for a record
+static void s_shm_ring_signal (shm_ring_header_t *header)
+{
+    __atomic_add_fetch (&header->signal, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n (&header->waiters, __ATOMIC_SEQ_CST) > 0)
+        s_futex (&header->signal, FUTEX_WAKE, INT_MAX, -1);
+}
+
+// True if the record at cursor starts with a topic the reader subscribed to
+static bool s_shm_ring_is_subscribed (igs_shm_ring_t *ring, const byte *cursor,
+                                      const byte *end, uint32_t nb_frames)
+{
+    uint32_t size = 0;
+    if (nb_frames == 0 || ring->filters == NULL || cursor + sizeof (uint32_t) > end)
+        return false;
+    memcpy (&size, cursor, sizeof (uint32_t));
+    cursor += sizeof (uint32_t);
+    if ((size & SHM_FRAME_HANDLE) || size < 2 || size > (size_t) (end - cursor))
+        return false;
+    shm_filter_t *filter = NULL;
+    HASH_FIND (hh, ring->filters, cursor + 1, size - 1, filter);
+    return (filter != NULL);
+}
+
+static igs_shm_ring_t *s_shm_ring_map (const char *path, int fd, size_t size, bool is_writer)
+{
+    void *mapping = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (mapping == MAP_FAILED) {
+        igs_error ("could not map shared memory ring %s (%s)", path, strerror (errno));
+        return NULL;
+    }
+    igs_shm_ring_t *ring = (igs_shm_ring_t *) zmalloc (sizeof (igs_shm_ring_t));
+    ring->path = strdup (path);
+    ring->is_writer = is_writer;
+    ring->header = (shm_ring_header_t *) mapping;
+    ring->data = (byte *) mapping + SHM_RING_HEADER_SIZE;
+    ring->mapped_size = size;
+    return ring;
+}
+
+static char *s_shm_segment_path (igs_shm_ring_t *ring, uint32_t index)
+{
+    return zsys_sprintf ("%s.%u", ring->path, index);
+}
+
+static shm_segment_t *s_shm_segment_map (const char *path, int fd, size_t size)
+{
+    void *mapping = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (mapping == MAP_FAILED) {
+        igs_error ("could not map shared memory segment %s (%s)", path, strerror (errno));
+        return NULL;
+    }
+    shm_segment_t *segment = (shm_segment_t *) zmalloc (sizeof (shm_segment_t));
+    segment->refcount = 1;
+    segment->header = (shm_segment_header_t *) mapping;
+    segment->mapped_size = size;
+    return segment;
+}
+
+static void s_shm_segment_release (shm_segment_t **segment)
+{
+    if (*segment && IGS_REFCOUNT_DECREMENT ((*segment)->refcount) == 0) {
+        munmap ((*segment)->header, (*segment)->mapped_size);
+        free (*segment);
+    }
+    *segment = NULL;
+}
+
+static shm_segment_t *s_shm_segment_create (igs_shm_ring_t *ring, uint32_t index, size_t capacity)
+{
+    char *path = s_shm_segment_path (ring, index);
+    int fd = open (path, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    shm_segment_t *segment = NULL;
+    if (fd < 0)
+        igs_error ("could not create shared memory segment %s (%s)", path, strerror (errno));
+    else if (ftruncate (fd, (off_t) (SHM_SEGMENT_HEADER_SIZE + capacity)) != 0) {
+        igs_error ("could not size shared memory segment %s (%s)", path, strerror (errno));
+        close (fd);
+    }
+    else
+        segment = s_shm_segment_map (path, fd, SHM_SEGMENT_HEADER_SIZE + capacity);
+    if (segment)
+        __atomic_store_n (&segment->header->magic, SHM_SEGMENT_MAGIC, __ATOMIC_RELEASE);
+    else
+        unlink (path);
+    zstr_free (&path);
+    return segment;
+}
+
+// Starts filling segment: fails if some reader is reading it
+static bool s_shm_segment_lock (shm_segment_t *segment)
+{
+    uint64_t generation = segment->header->generation;
+    __atomic_store_n (&segment->header->generation, generation + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n (&segment->header->readers, __ATOMIC_SEQ_CST) == 0)
+        return true;
+    __atomic_store_n (&segment->header->generation, generation, __ATOMIC_SEQ_CST);
+    return false;
+}
+
+// Writes frame in a segment and its handle in handle, returns false if no
+// segment is available. Segments written since nb_writes are not reused.
+static bool s_shm_ring_write_segment (igs_shm_ring_t *ring, zframe_t *frame,
+                                      uint64_t nb_writes, byte *handle)
+{
+    size_t size = zframe_size (frame);
+    shm_segment_t *segment = NULL;
+    uint32_t index = 0;
+    uint32_t tried = 0;
+    uint32_t nb_segments = 0;
+    while (nb_segments < SHM_MAX_SEGMENTS && ring->segments[nb_segments])
+        nb_segments++;
+    while (segment == NULL && nb_segments >= SHM_MIN_SEGMENTS) {
+        shm_segment_t *candidate = NULL;
+        for (uint32_t i = 0; i < nb_segments; i++) {
+            shm_segment_t *other = ring->segments[i];
+            if (!(tried & (1u << i)) && other->last_write <= nb_writes
+                && other->mapped_size - SHM_SEGMENT_HEADER_SIZE >= size
+                && (candidate == NULL || other->last_write < candidate->last_write)) {
+                candidate = other;
+                index = i;
+            }
+        }
+        if (candidate == NULL)
+            break;
+        tried |= 1u << index;
+        if (s_shm_segment_lock (candidate))
+            segment = candidate;
+    }
+    if (segment == NULL && nb_segments < SHM_MAX_SEGMENTS) {
+        size_t capacity = SHM_SEGMENT_THRESHOLD;
+        while (capacity < size)
+            capacity <<= 1;
+        index = nb_segments;
+        ring->segments[index] = s_shm_segment_create (ring, index, capacity);
+        segment = ring->segments[index];
+        if (segment && !s_shm_segment_lock (segment))
+            segment = NULL;
+    }
+    if (segment == NULL)
+        return false;
+    memcpy ((byte *) segment->header + SHM_SEGMENT_HEADER_SIZE, zframe_data (frame), size);
+    uint64_t generation = segment->header->generation + 1;
+    __atomic_store_n (&segment->header->generation, generation, __ATOMIC_SEQ_CST);
+    segment->last_write = ++ring->nb_writes;
+    uint64_t offset = SHM_SEGMENT_HEADER_SIZE;
+    uint64_t size64 = size;
+    memcpy (handle, &index, sizeof (uint32_t));
+    memset (handle + 4, 0, 4);
+    memcpy (handle + 8, &offset, sizeof (uint64_t));
+    memcpy (handle + 16, &size64, sizeof (uint64_t));
+    memcpy (handle + 24, &generation, sizeof (uint64_t));
+    return true;
+}
+
+static void s_shm_segment_frame_destroy (void **hint)
+{
+    shm_segment_t *segment = (shm_segment_t *) *hint;
+    __atomic_sub_fetch (&segment->header->readers, 1, __ATOMIC_SEQ_CST);
+    s_shm_segment_release (&segment);
+    *hint = NULL;
+}
+
+// Returns a frame reading in place the frame of a segment, NULL if the
+// segment is unavailable or was reused since handle was written
+static zframe_t *s_shm_ring_read_segment (igs_shm_ring_t *ring, const byte *handle)
+{
+    uint32_t index = 0;
+    uint64_t offset = 0, size = 0, generation = 0;
+    memcpy (&index, handle, sizeof (uint32_t));
+    memcpy (&offset, handle + 8, sizeof (uint64_t));
+    memcpy (&size, handle + 16, sizeof (uint64_t));
+    memcpy (&generation, handle + 24, sizeof (uint64_t));
+    if (index >= SHM_MAX_SEGMENTS)
+        return NULL;
+    shm_segment_t *segment = ring->segments[index];
+    if (segment == NULL) {
+        // segments are never resized : they are mapped once
+        char *path = s_shm_segment_path (ring, index);
+        int fd = open (path, O_RDWR);
+        struct stat info;
+        if (fd >= 0 && fstat (fd, &info) == 0
+            && (size_t) info.st_size > SHM_SEGMENT_HEADER_SIZE)
+            segment = s_shm_segment_map (path, fd, (size_t) info.st_size);
+        else if (fd >= 0)
+            close (fd);
+        if (segment
+            && __atomic_load_n (&segment->header->magic, __ATOMIC_ACQUIRE) != SHM_SEGMENT_MAGIC)
+            s_shm_segment_release (&segment);
+        if (segment == NULL)
+            igs_warn ("could not read shared memory segment %s", path);
+        zstr_free (&path);
+        ring->segments[index] = segment;
+        if (segment == NULL)
+            return NULL;
+    }
+    if (offset < SHM_SEGMENT_HEADER_SIZE || offset > segment->mapped_size
+        || size > segment->mapped_size - offset)
+        return NULL;
+    __atomic_add_fetch (&segment->header->readers, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n (&segment->header->generation, __ATOMIC_SEQ_CST) != generation) {
+        __atomic_sub_fetch (&segment->header->readers, 1, __ATOMIC_SEQ_CST);
+        return NULL;
+    }
+    IGS_REFCOUNT_INCREMENT (segment->refcount);
+    return zframe_frommem ((byte *) segment->header + offset, (size_t) size,
+                           s_shm_segment_frame_destroy, segment);
+}
+
+////////////////////////////////////////////////////////////////////////
+// PRIVATE API
+////////////////////////////////////////////////////////////////////////
+
+igs_shm_ring_t *shm_ring_create (const char *path, size_t capacity)
+{
+    assert (path);
+    size_t rounded = 4096;
+    while (rounded < capacity)
+        rounded <<= 1;
+    int fd = open (path, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        igs_error ("could not create shared memory ring %s (%s)", path, strerror (errno));
+        return NULL;
+    }
+    size_t size = SHM_RING_HEADER_SIZE + rounded;
+    if (ftruncate (fd, (off_t) size) != 0) {
+        igs_error ("could not size shared memory ring %s (%s)", path, strerror (errno));
+        close (fd);
+        unlink (path);
+        return NULL;
+    }
+    igs_shm_ring_t *ring = s_shm_ring_map (path, fd, size, true);
+    if (ring == NULL) {
+        unlink (path);
+        return NULL;
+    }
+    ring->header->version = SHM_RING_VERSION;
+    ring->header->capacity = rounded;
+    // readers check the magic number last
+    __atomic_store_n (&ring->header->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+    return ring;
+}
+
+igs_shm_ring_t *shm_ring_open (const char *path)
+{
+    assert (path);
+    int fd = open (path, O_RDWR);
+    if (fd < 0) {
+        igs_debug ("could not open shared memory ring %s (%s)", path, strerror (errno));
+        return NULL;
+    }
+    struct stat info;
+    if (fstat (fd, &info) != 0 || (size_t) info.st_size <= SHM_RING_HEADER_SIZE) {
+        igs_warn ("shared memory ring %s is invalid", path);
+        close (fd);
+        return NULL;
+    }
+    igs_shm_ring_t *ring = s_shm_ring_map (path, fd, (size_t) info.st_size, false);
+    if (ring == NULL)
+        return NULL;
+    shm_ring_header_t *header = ring->header;
+    if (__atomic_load_n (&header->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC
+        || header->version != SHM_RING_VERSION
+        || header->capacity != ring->mapped_size - SHM_RING_HEADER_SIZE
+        || (header->capacity & (header->capacity - 1)) != 0) {
+        igs_warn ("shared memory ring %s is invalid or has an unsupported version", path);
+        shm_ring_destroy (&ring);
+        return NULL;
+    }
+    // only new publications are read
+    ring->read_position = __atomic_load_n (&header->write_position, __ATOMIC_ACQUIRE);
+    return ring;
+}
+
+void shm_ring_destroy (igs_shm_ring_t **ring)
+{
+    assert (ring);
+    if (*ring == NULL)
+        return;
+    munmap ((*ring)->header, (*ring)->mapped_size);
+    // NB: files stay valid for the readers which mapped them
+    for (uint32_t i = 0; i < SHM_MAX_SEGMENTS; i++) {
+        if ((*ring)->segments[i] && (*ring)->is_writer) {
+            char *path = s_shm_segment_path (*ring, i);
+            unlink (path);
+            zstr_free (&path);
+        }
+        s_shm_segment_release (&((*ring)->segments[i]));
+    }
+    shm_filter_t *filter, *tmp;
+    HASH_ITER (hh, (*ring)->filters, filter, tmp){
+        HASH_DEL ((*ring)->filters, filter);
+        free (filter->topic);
+        free (filter);
+    }
+    if ((*ring)->is_writer)
+        unlink ((*ring)->path);
+    free ((*ring)->path);
+    free (*ring);
+    *ring = NULL;
+}
+
+bool shm_ring_write (igs_shm_ring_t *ring, zmsg_t *msg)
+{
+    assert (ring);
+    assert (ring->is_writer);
+    assert (msg);
+    shm_ring_header_t *header = ring->header;
+    size_t capacity = (size_t) header->capacity;
+    // large frames go to segments first, their handles replacing them
+    byte handles[SHM_MAX_SEGMENTS][SHM_HANDLE_SIZE];
+    zframe_t *handled[SHM_MAX_SEGMENTS];
+    size_t nb_handles = 0;
+    uint64_t nb_writes = ring->nb_writes;
+    size_t length = 0;
+    zframe_t *frame = zmsg_first (msg);
+    while (frame) {
+        if (zframe_size (frame) >= SHM_SEGMENT_THRESHOLD && nb_handles < SHM_MAX_SEGMENTS
+            && s_shm_ring_write_segment (ring, frame, nb_writes, handles[nb_handles])) {
+            handled[nb_handles++] = frame;
+            length += sizeof (uint32_t) + SHM_HANDLE_SIZE;
+        }
+        else
+            length += sizeof (uint32_t) + zframe_size (frame);
+        frame = zmsg_next (msg);
+    }
+    size_t record_size = SHM_RECORD_HEADER_SIZE + SHM_ALIGN (length);
+    // larger records would leave no time to readers to copy them
+    if (record_size > capacity / 2)
+        return false;
+
+    uint64_t position = header->write_position;
+    size_t offset = (size_t) (position & (capacity - 1));
+    bool wraps = (offset + record_size > capacity);
+    uint64_t end = (wraps) ? position + (capacity - offset) + record_size : position + record_size;
+    __atomic_store_n (&header->reserve_position, end, __ATOMIC_RELAXED);
+    __atomic_thread_fence (__ATOMIC_RELEASE);
+    if (wraps) {
+        *(uint32_t *) (ring->data + offset) = SHM_RECORD_WRAP;
+        offset = 0;
+    }
+    byte *record = ring->data + offset;
+    ((uint32_t *) record)[0] = (uint32_t) length;
+    ((uint32_t *) record)[1] = (uint32_t) zmsg_size (msg);
+    byte *cursor = record + SHM_RECORD_HEADER_SIZE;
+    size_t handle = 0;
+    frame = zmsg_first (msg);
+    while (frame) {
+        if (handle < nb_handles && handled[handle] == frame) {
+            uint32_t size = SHM_FRAME_HANDLE | SHM_HANDLE_SIZE;
+            memcpy (cursor, &size, sizeof (uint32_t));
+            memcpy (cursor + sizeof (uint32_t), handles[handle++], SHM_HANDLE_SIZE);
+            cursor += sizeof (uint32_t) + SHM_HANDLE_SIZE;
+        }
+        else {
+            uint32_t size = (uint32_t) zframe_size (frame);
+            memcpy (cursor, &size, sizeof (uint32_t));
+            memcpy (cursor + sizeof (uint32_t), zframe_data (frame), size);
+            cursor += sizeof (uint32_t) + size;
+        }
+        frame = zmsg_next (msg);
+    }
+    __atomic_store_n (&header->write_position, end, __ATOMIC_RELEASE);
+    s_shm_ring_signal (header);
+    return true;
+}
+
+void shm_ring_subscribe (igs_shm_ring_t *ring, const char *filter, size_t length, bool subscribe)
+{
+    assert (ring);
+    assert (!ring->is_writer);
+    assert (filter);
+    if (length < 2)
+        return;
+    shm_filter_t *found = NULL;
+    HASH_FIND (hh, ring->filters, filter + 1, length - 1, found);
+    if (subscribe && found)
+        found->count++;
+    else if (subscribe) {
+        found = (shm_filter_t *) zmalloc (sizeof (shm_filter_t));
+        found->topic = (byte *) zmalloc (length - 1);
+        memcpy (found->topic, filter + 1, length - 1);
+        found->length = length - 1;
+        found->count = 1;
+        HASH_ADD_KEYPTR (hh, ring->filters, found->topic, found->length, found);
+    }
+    else if (found && --found->count == 0) {
+        HASH_DEL (ring->filters, found);
+        free (found->topic);
+        free (found);
+    }
+}
+
+zmsg_t *shm_ring_read (igs_shm_ring_t *ring)
+{
+    assert (ring);
+    assert (!ring->is_writer);
+    shm_ring_header_t *header = ring->header;
+    size_t capacity = (size_t) header->capacity;
+    for (;;) {
+        uint64_t write_position = __atomic_load_n (&header->write_position, __ATOMIC_ACQUIRE);
+        if (ring->read_position == write_position)
+            return NULL;
+        if (write_position - ring->read_position > capacity) {
+            // the writer overtook us : skip to its current position
+            ring->lost++;
+            ring->read_position = write_position;
+            return NULL;
+        }
+        size_t offset = (size_t) (ring->read_position & (capacity - 1));
+        const byte *record = ring->data + offset;
+        uint32_t length = ((const uint32_t *) record)[0];
+        if (length == SHM_RECORD_WRAP) {
+            ring->read_position += capacity - offset;
+            continue;
+        }
+        uint32_t nb_frames = ((const uint32_t *) record)[1];
+        bool is_valid = (offset + SHM_RECORD_HEADER_SIZE + length <= capacity);
+        bool is_complete = true;
+        const byte *cursor = record + SHM_RECORD_HEADER_SIZE;
+        const byte *end = cursor + length;
+        // other records are skipped without being copied
+        bool is_subscribed = is_valid && s_shm_ring_is_subscribed (ring, cursor, end, nb_frames);
+        zmsg_t *msg = (is_subscribed) ? zmsg_new () : NULL;
+        for (uint32_t i = 0; is_subscribed && is_valid && i < nb_frames; i++) {
+            uint32_t size = 0;
+            if (cursor + sizeof (uint32_t) > end) {
+                is_valid = false;
+                break;
+            }
+            memcpy (&size, cursor, sizeof (uint32_t));
+            cursor += sizeof (uint32_t);
+            bool is_handle = (size & SHM_FRAME_HANDLE);
+            size &= ~SHM_FRAME_HANDLE;
+            if (size > (size_t) (end - cursor) || (is_handle && size != SHM_HANDLE_SIZE)) {
+                is_valid = false;
+                break;
+            }
+            if (is_handle) {
+                zframe_t *frame = s_shm_ring_read_segment (ring, cursor);
+                if (frame)
+                    zmsg_append (msg, &frame);
+                else
+                    is_complete = false;
+            }
+            else
+                zmsg_addmem (msg, cursor, size);
+            cursor += size;
+        }
+        // the record was not overwritten while we read it if the writer
+        // has not reserved the place it occupied
+        __atomic_thread_fence (__ATOMIC_ACQUIRE);
+        uint64_t reserve_position = __atomic_load_n (&header->reserve_position, __ATOMIC_RELAXED);
+        if (!is_valid || reserve_position - ring->read_position > capacity) {
+            zmsg_destroy (&msg);
+            ring->lost++;
+            ring->read_position = __atomic_load_n (&header->write_position, __ATOMIC_ACQUIRE);
+            return NULL;
+        }
+        ring->read_position += SHM_RECORD_HEADER_SIZE + SHM_ALIGN (length);
+        if (!is_subscribed)
+            continue;
+        if (!is_complete) {
+            // the writer reused a segment before we could read it
+            zmsg_destroy (&msg);
+            ring->lost++;
+            continue;
+        }
+        return msg;
+    }
+}
+
+bool shm_ring_wait (igs_shm_ring_t *ring, zsock_t *pipe)
+{
+    assert (ring);
+    shm_ring_header_t *header = ring->header;
+    uint32_t signal = __atomic_load_n (&header->signal, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n (&header->write_position, __ATOMIC_SEQ_CST) != ring->read_position)
+        return true;
+    // a command sent on pipe once we read signal changes it, see
+    // s_shm_reader_send : it is either seen now or wakes us up
+    if (pipe && (zsock_events (pipe) & ZMQ_POLLIN))
+        return false;
+    __atomic_add_fetch (&header->waiters, 1, __ATOMIC_SEQ_CST);
+    // returns at once if a record was written since we read signal
+    s_futex (&header->signal, FUTEX_WAIT, signal, -1);
+    __atomic_sub_fetch (&header->waiters, 1, __ATOMIC_SEQ_CST);
+    return (__atomic_load_n (&header->write_position, __ATOMIC_SEQ_CST) != ring->read_position);
+}
+
+struct igs_shm_reader {
+    zactor_t *actor;
+    igs_shm_ring_t *ring; //used by the actor, destroyed after it
+};
+
+// Reader thread: forwards the publications of the ring on its pipe, where
+// they are handled as if received on a SUB socket. It only sleeps on the
+// futex of the ring, which its commands change to wake it up.
+static void s_shm_reader_actor (zsock_t *pipe, void *args)
+{
+    igs_shm_ring_t *ring = (igs_shm_ring_t *) args;
+    // never block on a network thread lagging behind
+    zsock_set_sndtimeo (pipe, 0);
+    zsock_signal (pipe, 0);
+    size_t lost = 0;
+    bool terminated = false;
+    while (!terminated) {
+        zmsg_t *msg = shm_ring_read (ring);
+        while (msg) {
+            if (zmsg_send (&msg, pipe) != 0) {
+                zmsg_destroy (&msg);
+                ring->lost++;
+            }
+            msg = shm_ring_read (ring);
+        }
+        if (ring->lost != lost) {
+            igs_warn ("%zu publications lost in shared memory ring %s",
+                      ring->lost - lost, ring->path);
+            lost = ring->lost;
+        }
+        if (zsock_events (pipe) & ZMQ_POLLIN) {
+            zmsg_t *command = zmsg_recv (pipe);
+            char *text = (command) ? zmsg_popstr (command) : NULL;
+            zframe_t *filter = (command) ? zmsg_first (command) : NULL;
+            if (command == NULL || (text && (streq (text, "$TERM") || streq (text, "STOP"))))
+                terminated = true;
+            else if (text && filter && streq (text, "SUBSCRIBE"))
+                shm_ring_subscribe (ring, (const char *) zframe_data (filter),
+                                    zframe_size (filter), true);
+            else if (text && filter && streq (text, "UNSUBSCRIBE"))
+                shm_ring_subscribe (ring, (const char *) zframe_data (filter),
+                                    zframe_size (filter), false);
+            free (text);
+            zmsg_destroy (&command);
+        }
+        else
+            shm_ring_wait (ring, pipe);
+    }
+}
+
+// Sends a command to the reader thread and wakes it up. Other readers of
+// the ring may wake up as well and go back to sleep.
+static void s_shm_reader_send (igs_shm_reader_t *reader, zmsg_t **msg)
+{
+    if (zmsg_send (msg, zactor_sock (reader->actor)) != 0)
+        zmsg_destroy (msg);
+    s_shm_ring_signal (reader->ring->header);
+}
+
+igs_shm_reader_t *shm_reader_new (const char *path)
+{
+    assert (path);
+    igs_shm_ring_t *ring = shm_ring_open (path);
+    if (ring == NULL)
+        return NULL;
+    igs_shm_reader_t *reader = (igs_shm_reader_t *) zmalloc (sizeof (igs_shm_reader_t));
+    reader->ring = ring;
+    reader->actor = zactor_new (s_shm_reader_actor, ring);
+    return reader;
+}
+
+void shm_reader_destroy (igs_shm_reader_t **reader)
+{
+    assert (reader);
+    if (*reader == NULL)
+        return;
+    // the thread may sleep on the futex, which $TERM would not wake up
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, "STOP");
+    s_shm_reader_send (*reader, &msg);
+    zactor_destroy (&(*reader)->actor);
+    shm_ring_destroy (&(*reader)->ring);
+    free (*reader);
+    *reader = NULL;
+}
+
+zsock_t *shm_reader_sock (igs_shm_reader_t *reader)
+{
+    assert (reader);
+    return zactor_sock (reader->actor);
+}
+
+void shm_reader_subscribe (igs_shm_reader_t *reader, const char *filter,
+                           size_t length, bool subscribe)
+{
+    assert (reader);
+    assert (filter);
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, (subscribe) ? "SUBSCRIBE" : "UNSUBSCRIBE");
+    zmsg_addmem (msg, filter, length);
+    s_shm_reader_send (reader, &msg);
+}
+
+#endif
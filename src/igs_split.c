@@ -61,13 +61,7 @@ void split_remove_worker (igs_core_context_t *context, char *uuid, char *input_n
             igs_queued_work_t *work_elt, *work_tmp;
             LL_FOREACH_SAFE(splitter->queued_works, work_elt, work_tmp){
                 LL_DELETE(splitter->queued_works, work_elt);
-                if(work_elt->value_type == IGS_DATA_T){
-                    free(work_elt->value.data);
-                    work_elt->value.data = NULL;
-                }else if(work_elt->value_type == IGS_STRING_T){
-                    free(work_elt->value.s);
-                    work_elt->value.s = NULL;
-                }
+                igs_value_release(&work_elt->shared_value);
                 free(work_elt);
             }
             free(splitter->queued_works);
@@ -130,14 +124,19 @@ void s_split_trigger_send_message_to_worker (igs_core_context_t *context, char *
                             zmsg_addmem(readyMessage, &(work->value.b), sizeof(bool));
                             break;
                         case IGS_STRING_T:
-                            zmsg_addstr(readyMessage, work->value.s);
+                            zmsg_addstr(readyMessage, (work->value.s) ? work->value.s : "");
                             break;
                         case IGS_IMPULSION_T:
                             zmsg_addmem(readyMessage, NULL, 0);
                             break;
-                        case IGS_DATA_T:{
-                            zframe_t *frame = zframe_new (work->value.data, work->value_size);
-                            zmsg_append(readyMessage, &frame);}
+                        case IGS_DATA_T:
+                            if (work->shared_value){
+                                //the frame takes over the reference of the work
+                                zframe_t *frame = model_value_frame_new(work->shared_value, work->value_size);
+                                work->shared_value = NULL;
+                                zmsg_append(readyMessage, &frame);
+                            }else
+                                zmsg_addmem(readyMessage, NULL, 0);
                             break;
                         default:
                             break;
@@ -166,18 +165,7 @@ void s_split_trigger_send_message_to_worker (igs_core_context_t *context, char *
                     igs_channel_whisper_zmsg(max_credit_worker->agent_uuid, &readyMessage);
                     
                     LL_DELETE(splitter->queued_works, work);
-                    switch(work->value_type){
-                        case IGS_STRING_T:
-                            free(work->value.s);
-                            work->value.s = NULL;
-                            break;
-                        case IGS_DATA_T:
-                            free(work->value.data);
-                            work->value.data = NULL;
-                            break;
-                        default:
-                            break;
-                    }
+                    igs_value_release(&work->shared_value);
                     free(work);
                     max_credit_worker->uses++;
                     max_credit_worker->credit--;
@@ -216,14 +204,14 @@ void split_add_work_to_queue (igs_core_context_t *context, char* agent_uuid, con
                         new_work->value.b = output->value.b;
                         break;
                     case IGS_STRING_T:
-                        new_work->value.s = strdup(output->value.s);
+                    case IGS_DATA_T:
+                        //queued works share the value with the output
+                        new_work->shared_value = model_iop_value_share(output);
+                        if (new_work->shared_value)
+                            new_work->value.data = new_work->shared_value->data;
                         break;
                     case IGS_IMPULSION_T:
                         break;
-                    case IGS_DATA_T:
-                        new_work->value.data = (void *)zmalloc( output->value_size);
-                        memcpy(new_work->value.data, output->value.data, output->value_size);
-                        break;
                     default:
                         break;
                 }
@@ -39,6 +39,8 @@ igsagent_t *igsagent_new (const char *name, bool activate_immediately)
     zuuid_t *uuid = zuuid_new ();
     agent->uuid = strdup (zuuid_str (uuid));
     zuuid_destroy (&uuid);
+    IGS_RWLOCK_INIT (agent->model_lock);
+    agent->references = 1;
     igsagent_clear_definition (agent); // set valid but empty definition, preserve name
     igsagent_set_name (agent, name);
     assert (agent->definition);
@@ -58,10 +60,6 @@ void igsagent_destroy (igsagent_t **agent)
         igsagent_deactivate (*agent);
 
     zhash_delete (core_context->created_agents, (*agent)->uuid);
-    if ((*agent)->uuid) {
-        free ((*agent)->uuid);
-        (*agent)->uuid = NULL;
-    }
     if ((*agent)->state)
         free ((*agent)->state);
     if ((*agent)->definition_path)
@@ -89,11 +87,21 @@ void igsagent_destroy (igsagent_t **agent)
         DL_DELETE ((*agent)->agent_event_callbacks, event_cb);
         free (event_cb);
     }
-    if ((*agent)->mapping)
+    // threads waiting for the agent lock give up once the uuid is cleared,
+    // and the last thread still holding a reference frees the agent
+    model_agent_write_lock (*agent);
+    free ((*agent)->uuid);
+    (*agent)->uuid = NULL;
+    if ((*agent)->mapping) {
+        mapping_index_remove_all (*agent);
         mapping_free_mapping (&(*agent)->mapping);
+    }
     if ((*agent)->definition)
         definition_free_definition (&(*agent)->definition);
-    free (*agent);
+    model_agent_write_unlock (*agent);
+    if ((*agent)->outputs_batch)
+        network_publication_destroy (&(*agent)->outputs_batch);
+    model_agent_release (*agent);
     *agent = NULL;
     model_read_write_unlock (__FUNCTION__, __LINE__);
 }
@@ -230,10 +238,10 @@ void igsagent_log (igs_log_level_t level,
     assert (function);
     assert (agent);
     assert (format);
+    if (!admin_log_is_enabled (level))
+        return;
     va_list list;
     va_start (list, format);
-    char content[IGS_MAX_STRING_MSG_LENGTH] = "";
-    vsnprintf (content, IGS_MAX_STRING_MSG_LENGTH - 1, format, list);
+    admin_log_v (agent, level, function, format, list);
     va_end (list);
-    admin_log (agent, level, function, "%s", content);
 }
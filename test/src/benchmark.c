@@ -0,0 +1,316 @@
+//
+//  benchmark.c
+//  testing
+//
+//  Micro-benchmarks for the model and network layers, run with
+//  igsTester --benchmark or igsBenchmark. Figures are printed on stdout
+//  and are meant to be compared between builds on the same machine.
+//
+
+#include "common.h"
+#include <ingescape.h>
+#include <czmq.h>
+#include "ingescape_private.h"
+
+#define BENCHMARK_WRITES_PER_THREAD 200000
+
+// Allocations made by the whole process are only counted in igsBenchmark,
+// which interposes the glibc allocator, see benchmarker.c
+#if defined(IGS_BENCHMARK_ALLOCATIONS) && defined(__GLIBC__)
+#define BENCHMARK_COUNTS_ALLOCATIONS 1
+size_t benchmarkAllocationCount(void);
+#else
+#define BENCHMARK_COUNTS_ALLOCATIONS 0
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Model write throughput vs. number of agents and threads
+typedef struct {
+    igsagent_t *agent;
+    size_t nbOfWrites;
+    int64_t elapsed; //in microseconds
+} benchmarkWriter_t;
+
+static void benchmarkWriterActor(zsock_t *pipe, void *args){
+    benchmarkWriter_t *writer = (benchmarkWriter_t *)args;
+    zsock_signal(pipe, 0);
+    int64_t start = zclock_usecs();
+    for (size_t i = 0; i < writer->nbOfWrites; i++){
+        igsagent_input_set_int(writer->agent, "x", (int)i);
+        if (igsagent_input_int(writer->agent, "x") != (int)i)
+            printf("benchmark: inconsistent read on agent %p\n", (void *)writer->agent);
+    }
+    writer->elapsed = zclock_usecs() - start;
+}
+
+void benchmarkModelWrites(void){
+    const size_t agentCounts[] = {1, 4, 16};
+    const size_t threadCounts[] = {1, 2, 4, 8};
+    printf("\n--- model write throughput (input int, write + read) ---\n");
+    printf("%8s %8s %16s\n", "agents", "threads", "writes/s");
+    for (size_t a = 0; a < sizeof(agentCounts) / sizeof(size_t); a++){
+        size_t nbOfAgents = agentCounts[a];
+        igsagent_t **agents = (igsagent_t **)calloc(nbOfAgents, sizeof(igsagent_t *));
+        for (size_t i = 0; i < nbOfAgents; i++){
+            char name[64] = "";
+            snprintf(name, 64, "benchmark_agent_%zu", i);
+            agents[i] = igsagent_new(name, true);
+            igsagent_input_create(agents[i], "x", IGS_INTEGER_T, NULL, 0);
+        }
+        for (size_t t = 0; t < sizeof(threadCounts) / sizeof(size_t); t++){
+            size_t nbOfThreads = threadCounts[t];
+            benchmarkWriter_t *writers = (benchmarkWriter_t *)calloc(nbOfThreads, sizeof(benchmarkWriter_t));
+            zactor_t **actors = (zactor_t **)calloc(nbOfThreads, sizeof(zactor_t *));
+            for (size_t i = 0; i < nbOfThreads; i++){
+                writers[i].agent = agents[i % nbOfAgents];
+                writers[i].nbOfWrites = BENCHMARK_WRITES_PER_THREAD;
+            }
+            for (size_t i = 0; i < nbOfThreads; i++)
+                actors[i] = zactor_new(benchmarkWriterActor, &writers[i]);
+            int64_t slowest = 0;
+            size_t total = 0;
+            for (size_t i = 0; i < nbOfThreads; i++){
+                zactor_destroy(&actors[i]);
+                if (writers[i].elapsed > slowest)
+                    slowest = writers[i].elapsed;
+                total += writers[i].nbOfWrites;
+            }
+            double throughput = (slowest > 0) ? (double)total * 1000000.0 / (double)slowest : 0;
+            printf("%8zu %8zu %16.0f\n", nbOfAgents, nbOfThreads, throughput);
+            free(actors);
+            free(writers);
+        }
+        for (size_t i = 0; i < nbOfAgents; i++)
+            igsagent_destroy(&agents[i]);
+        free(agents);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Output writes by name vs. through pre-resolved handles
+#define BENCHMARK_HANDLE_OUTPUTS 200
+#define BENCHMARK_HANDLE_ROUNDS 1000
+
+void benchmarkHandleWrites(void){
+    igsagent_t *agent = igsagent_new("benchmark_handles", true);
+    char names[BENCHMARK_HANDLE_OUTPUTS][32];
+    igs_iop_handle_t *handles[BENCHMARK_HANDLE_OUTPUTS];
+    for (size_t i = 0; i < BENCHMARK_HANDLE_OUTPUTS; i++){
+        snprintf(names[i], 32, "output_%zu", i);
+        igsagent_output_create(agent, names[i], IGS_DOUBLE_T, NULL, 0);
+        handles[i] = igsagent_output_handle(agent, names[i]);
+    }
+    printf("\n--- output writes, %d doubles x %d rounds ---\n",
+           BENCHMARK_HANDLE_OUTPUTS, BENCHMARK_HANDLE_ROUNDS);
+    printf("%8s %16s\n", "mode", "writes/s");
+    size_t total = BENCHMARK_HANDLE_OUTPUTS * BENCHMARK_HANDLE_ROUNDS;
+    int64_t start = zclock_usecs();
+    for (size_t r = 0; r < BENCHMARK_HANDLE_ROUNDS; r++)
+        for (size_t i = 0; i < BENCHMARK_HANDLE_OUTPUTS; i++)
+            igsagent_output_set_double(agent, names[i], (double)r);
+    int64_t elapsed = zclock_usecs() - start;
+    printf("%8s %16.0f\n", "name", (elapsed > 0) ? (double)total * 1000000.0 / (double)elapsed : 0);
+    start = zclock_usecs();
+    for (size_t r = 0; r < BENCHMARK_HANDLE_ROUNDS; r++)
+        for (size_t i = 0; i < BENCHMARK_HANDLE_OUTPUTS; i++)
+            igs_output_set_double_h(handles[i], (double)r);
+    elapsed = zclock_usecs() - start;
+    printf("%8s %16.0f\n", "handle", (elapsed > 0) ? (double)total * 1000000.0 / (double)elapsed : 0);
+    for (size_t i = 0; i < BENCHMARK_HANDLE_OUTPUTS; i++)
+        igs_iop_handle_destroy(&handles[i]);
+    igsagent_destroy(&agent);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Allocations per write for string and data IOPs
+#define BENCHMARK_ALLOCATION_WRITES 10000
+#define BENCHMARK_FRAME_SIZE 4096
+
+void benchmarkAllocationsPerWrite(void){
+    printf("\n--- allocations per write (input, %d writes) ---\n", BENCHMARK_ALLOCATION_WRITES);
+#if BENCHMARK_COUNTS_ALLOCATIONS
+    igsagent_t *agent = igsagent_new("benchmark_allocations", true);
+    igsagent_input_create(agent, "label", IGS_STRING_T, NULL, 0);
+    igsagent_input_create(agent, "frame", IGS_DATA_T, NULL, 0);
+    char *frame = (char *)calloc(1, BENCHMARK_FRAME_SIZE);
+    const char *labels[] = {"sensor_a", "sensor_bb"};
+    //first writes size the storage
+    igsagent_input_set_string(agent, "label", labels[0]);
+    igsagent_input_set_data(agent, "frame", frame, BENCHMARK_FRAME_SIZE);
+    printf("%24s %16s\n", "value", "allocs/write");
+
+    size_t before = benchmarkAllocationCount();
+    for (size_t i = 0; i < BENCHMARK_ALLOCATION_WRITES; i++)
+        igsagent_input_set_string(agent, "label", labels[i % 2]);
+    size_t allocations = benchmarkAllocationCount() - before;
+    printf("%24s %16.3f\n", "short string", (double)allocations / BENCHMARK_ALLOCATION_WRITES);
+
+    before = benchmarkAllocationCount();
+    for (size_t i = 0; i < BENCHMARK_ALLOCATION_WRITES; i++)
+        igsagent_input_set_data(agent, "frame", frame, BENCHMARK_FRAME_SIZE);
+    allocations = benchmarkAllocationCount() - before;
+    printf("%24s %16.3f\n", "4 KB data", (double)allocations / BENCHMARK_ALLOCATION_WRITES);
+
+    before = benchmarkAllocationCount();
+    for (size_t i = 0; i < BENCHMARK_ALLOCATION_WRITES; i++)
+        igsagent_input_set_data(agent, "frame", frame, BENCHMARK_FRAME_SIZE - (i % 256));
+    allocations = benchmarkAllocationCount() - before;
+    printf("%24s %16.3f\n", "3.8-4 KB data", (double)allocations / BENCHMARK_ALLOCATION_WRITES);
+
+    free(frame);
+    igsagent_destroy(&agent);
+#else
+    printf("allocation counting is only available in igsBenchmark, on glibc\n");
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reading large data inputs by copy vs. borrowing
+#define BENCHMARK_BORROW_FRAME_SIZE (2 * 1024 * 1024)
+#define BENCHMARK_BORROW_READS 1000
+
+void benchmarkBorrowedReads(void){
+    igsagent_t *agent = igsagent_new("benchmark_borrow", true);
+    igsagent_input_create(agent, "frame", IGS_DATA_T, NULL, 0);
+    char *frame = (char *)calloc(1, BENCHMARK_BORROW_FRAME_SIZE);
+    igsagent_input_set_data(agent, "frame", frame, BENCHMARK_BORROW_FRAME_SIZE);
+    printf("\n--- reads of a 2 MB data input, %d reads ---\n", BENCHMARK_BORROW_READS);
+    printf("%8s %16s\n", "mode", "reads/s");
+    int64_t start = zclock_usecs();
+    for (size_t i = 0; i < BENCHMARK_BORROW_READS; i++){
+        void *data = NULL;
+        size_t size = 0;
+        igsagent_input_data(agent, "frame", &data, &size);
+        free(data);
+    }
+    int64_t elapsed = zclock_usecs() - start;
+    printf("%8s %16.0f\n", "copy", (elapsed > 0) ? (double)BENCHMARK_BORROW_READS * 1000000.0 / (double)elapsed : 0);
+    start = zclock_usecs();
+    for (size_t i = 0; i < BENCHMARK_BORROW_READS; i++){
+        const void *data = NULL;
+        size_t size = 0;
+        igs_value_t *token = NULL;
+        igsagent_input_data_borrow(agent, "frame", &data, &size, &token);
+        igs_value_release(&token);
+    }
+    elapsed = zclock_usecs() - start;
+    printf("%8s %16.0f\n", "borrow", (elapsed > 0) ? (double)BENCHMARK_BORROW_READS * 1000000.0 / (double)elapsed : 0);
+    free(frame);
+    igsagent_destroy(&agent);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Event loop overhead with many peers: zloop vs. the ingescape loop
+#define BENCHMARK_LOOP_MESSAGES 100000
+
+typedef struct {
+    size_t received;
+    size_t expected;
+} benchmarkLoopCounter_t;
+
+static int benchmarkZloopReader(zloop_t *loop, zsock_t *socket, void *arg){
+    IGS_UNUSED(loop)
+    benchmarkLoopCounter_t *counter = (benchmarkLoopCounter_t *)arg;
+    zframe_t *frame = zframe_recv(socket);
+    zframe_destroy(&frame);
+    return (++counter->received == counter->expected) ? -1 : 0;
+}
+
+static int benchmarkZloopTimer(zloop_t *loop, int timerId, void *arg){
+    IGS_UNUSED(loop)
+    IGS_UNUSED(timerId)
+    IGS_UNUSED(arg)
+    return 0;
+}
+
+static int benchmarkLoopReader(igs_loop_t *loop, zsock_t *socket, void *arg){
+    IGS_UNUSED(loop)
+    benchmarkLoopCounter_t *counter = (benchmarkLoopCounter_t *)arg;
+    zframe_t *frame = zframe_recv(socket);
+    zframe_destroy(&frame);
+    return (++counter->received == counter->expected) ? -1 : 0;
+}
+
+static int benchmarkLoopTimer(igs_loop_t *loop, int timerId, void *arg){
+    IGS_UNUSED(loop)
+    IGS_UNUSED(timerId)
+    IGS_UNUSED(arg)
+    return 0;
+}
+
+// Each peer has a socket and a pending timer, like remote agents on the
+// network thread. One message is sent to each peer, then the loop runs
+// until all are received.
+static double benchmarkLoopRun(size_t nbOfPeers, bool useZloop){
+    zsock_t **senders = (zsock_t **)calloc(nbOfPeers, sizeof(zsock_t *));
+    zsock_t **readers = (zsock_t **)calloc(nbOfPeers, sizeof(zsock_t *));
+    zloop_t *zloop = NULL;
+    igs_loop_t *loop = NULL;
+    if (useZloop){
+        zloop = zloop_new();
+        zloop_set_verbose(zloop, false);
+    }else
+        loop = loop_new();
+    benchmarkLoopCounter_t counter = {0, nbOfPeers};
+    for (size_t i = 0; i < nbOfPeers; i++){
+        char endpoint[64] = "";
+        snprintf(endpoint, 64, "inproc://benchmark-loop-%zu", i);
+        readers[i] = zsock_new(ZMQ_PAIR);
+        zsock_bind(readers[i], "%s", endpoint);
+        senders[i] = zsock_new(ZMQ_PAIR);
+        zsock_connect(senders[i], "%s", endpoint);
+        if (useZloop){
+            zloop_reader(zloop, readers[i], benchmarkZloopReader, &counter);
+            zloop_timer(zloop, 3600000, 1, benchmarkZloopTimer, NULL);
+        }else{
+            loop_reader(loop, readers[i], benchmarkLoopReader, &counter);
+            loop_timer(loop, 3600000, 1, benchmarkLoopTimer, NULL);
+        }
+    }
+    size_t rounds = BENCHMARK_LOOP_MESSAGES / nbOfPeers;
+    int64_t start = zclock_usecs();
+    for (size_t r = 0; r < rounds; r++){
+        for (size_t i = 0; i < nbOfPeers; i++)
+            zsock_send(senders[i], "i", (int)r);
+        counter.received = 0;
+        if (useZloop)
+            zloop_start(zloop);
+        else
+            loop_start(loop);
+    }
+    int64_t elapsed = zclock_usecs() - start;
+    if (useZloop)
+        zloop_destroy(&zloop);
+    else
+        loop_destroy(&loop);
+    for (size_t i = 0; i < nbOfPeers; i++){
+        zsock_destroy(&senders[i]);
+        zsock_destroy(&readers[i]);
+    }
+    free(senders);
+    free(readers);
+    return (double)elapsed / (double)(rounds * nbOfPeers);
+}
+
+void benchmarkLoopOverhead(void){
+    size_t peers[] = {10, 100, 1000};
+    printf("\n--- event loop overhead, %d messages spread over peers ---\n", BENCHMARK_LOOP_MESSAGES);
+    printf("%8s %16s %16s\n", "peers", "zloop us/msg", "igs us/msg");
+    for (size_t i = 0; i < sizeof(peers) / sizeof(size_t); i++){
+        double zloopCost = benchmarkLoopRun(peers[i], true);
+        double loopCost = benchmarkLoopRun(peers[i], false);
+        printf("%8zu %16.3f %16.3f\n", peers[i], zloopCost, loopCost);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void runBenchmarks(void){
+    bool previousConsole = igs_log_console();
+    igs_log_set_console(false);
+    benchmarkModelWrites();
+    benchmarkHandleWrites();
+    benchmarkAllocationsPerWrite();
+    benchmarkBorrowedReads();
+    benchmarkLoopOverhead();
+    igs_log_set_console(previousConsole);
+}
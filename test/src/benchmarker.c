@@ -0,0 +1,65 @@
+//
+//  benchmarker.c
+//  testing
+//
+//  igsBenchmark runs the benchmarks of benchmark.c like igsTester
+//  --benchmark, and also counts the allocations made by the process. On
+//  glibc, they are counted by interposing the allocator, which is why this
+//  is not done in igsTester.
+//
+
+#include "common.h"
+#include <ingescape.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#if defined(IGS_BENCHMARK_ALLOCATIONS) && defined(__GLIBC__)
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+static size_t benchmarkAllocations = 0;
+
+void *malloc(size_t size){
+    __atomic_fetch_add(&benchmarkAllocations, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size){
+    __atomic_fetch_add(&benchmarkAllocations, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size){
+    __atomic_fetch_add(&benchmarkAllocations, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size){
+    __atomic_fetch_add(&benchmarkAllocations, 1, __ATOMIC_RELAXED);
+    *ptr = __libc_memalign(alignment, size);
+    return (*ptr || size == 0) ? 0 : ENOMEM;
+}
+
+void *aligned_alloc(size_t alignment, size_t size){
+    __atomic_fetch_add(&benchmarkAllocations, 1, __ATOMIC_RELAXED);
+    return __libc_memalign(alignment, size);
+}
+
+void free(void *ptr){
+    __libc_free(ptr);
+}
+
+size_t benchmarkAllocationCount(void){
+    return __atomic_load_n(&benchmarkAllocations, __ATOMIC_RELAXED);
+}
+#endif
+
+int main(int argc, const char * argv[]) {
+    IGS_UNUSED(argc)
+    IGS_UNUSED(argv)
+    igs_clear_context();
+    runBenchmarks();
+    return 0;
+}
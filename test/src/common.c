@@ -208,6 +208,7 @@ void print_usage(const char *myAgentName) {
     printf("--interactiveloop : enables interactive loop to pass commands in CLI (default: false)\n");
     printf("--auto : enables automatic network tests based on timers and network events\n");
     printf("--static : runs static tests only\n");
+    printf("--benchmark : runs model and network benchmarks and exits\n");
 }
 
 //helper to convert paths starting with ~ to absolute paths
@@ -70,4 +70,6 @@ void securityCommandSparing(char * ip_address);
 
 void editorCommand(const char *agentUUID, const char *input);
 
+void runBenchmarks(void);
+
 #endif /* common_h */
@@ -341,6 +341,45 @@ void testerIOPCallback(igs_iop_type_t iopType, const char* name, igs_iop_value_t
     }
 }
 
+//definition exports concurrent with writes from another thread
+#define CONCURRENT_EXPORT_WRITES 20000
+void concurrentExportWriter(zsock_t *pipe, void *args){
+    igsagent_t *agent = (igsagent_t *)args;
+    zsock_signal(pipe, 0);
+    char value[256] = "";
+    for (size_t i = 0; i < CONCURRENT_EXPORT_WRITES; i++){
+        //varying lengths make writes reallocate the stored values
+        snprintf(value, 256, "%0*zu", (int)(1 + i % 200), i);
+        igsagent_output_set_string(agent, "string", value);
+        igsagent_output_set_data(agent, "data", value, strlen(value));
+    }
+    zsock_signal(pipe, 0);
+    char *command = zstr_recv(pipe); //$TERM
+    free(command);
+}
+
+//publications received from the outputs of another agent of our process
+size_t sinkPublications = 0;
+int sinkLastInt = 0;
+void sinkIOPCallback(igsagent_t *agent, igs_iop_type_t iopType, const char* name, igs_iop_value_type_t valueType,
+                     void* value, size_t valueSize, void* myCbData){
+    IGS_UNUSED(agent)
+    IGS_UNUSED(iopType)
+    IGS_UNUSED(name)
+    IGS_UNUSED(valueSize)
+    IGS_UNUSED(myCbData)
+    sinkPublications++;
+    if (valueType == IGS_INTEGER_T)
+        sinkLastInt = *(int *)value;
+}
+
+//buffers adopted by data outputs, identified by their first byte
+size_t ownedDataFrees[3] = {0, 0, 0};
+void ownedDataFree(void *data){
+    ownedDataFrees[((unsigned char *)data)[0]]++;
+    free(data);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // MAIN & OPTIONS & COMMAND INTERPRETER
 //
@@ -352,6 +391,7 @@ int main(int argc, const char * argv[]) {
     int opt = 0;
     bool interactiveloop = false;
     bool staticTests = false;
+    bool benchmarks = false;
 
     static struct option long_options[] = {
         {"verbose",     no_argument, 0,  'v' },
@@ -363,6 +403,7 @@ int main(int argc, const char * argv[]) {
         {"name",        required_argument, 0,  'n' },
         {"auto",        no_argument, 0,  'a' },
         {"static",        no_argument, 0,  's' },
+        {"benchmark",        no_argument, 0,  'b' },
         {"help",        no_argument, 0,  'h' },
         {0, 0, 0, 0}
     };
@@ -391,6 +432,9 @@ int main(int argc, const char * argv[]) {
             case 's':
                 staticTests = true;
                 break;
+            case 'b':
+                benchmarks = true;
+                break;
             case 'h':
                 print_usage(agentName);
                 exit(0);
@@ -400,6 +444,10 @@ int main(int argc, const char * argv[]) {
         }
     }
     igs_clear_context();
+    if (benchmarks){
+        runBenchmarks();
+        exit(0);
+    }
     igs_log_set_syslog(true);
     //NB: on macos, because syslog is broken, logs can be checked using this command:
     //log stream --info --debug --predicate 'sender == "ingescape"' --style syslog
@@ -882,6 +930,23 @@ int main(int argc, const char * argv[]) {
     igs_parameter_set_description("my_impulsion", "my iop description here");
     char *exportedDef = igs_definition_json();
     assert(exportedDef);
+    igsagent_t *exportedAgent = igsagent_new("concurrent_export", true);
+    igsagent_output_create(exportedAgent, "string", IGS_STRING_T, NULL, 0);
+    igsagent_output_create(exportedAgent, "data", IGS_DATA_T, NULL, 0);
+    zactor_t *exportWriter = zactor_new(concurrentExportWriter, exportedAgent);
+    zpoller_t *exportPoller = zpoller_new(exportWriter, NULL);
+    size_t nbOfExports = 0;
+    while (zpoller_wait(exportPoller, 0) == NULL && !zpoller_terminated(exportPoller)){
+        char *concurrentDef = igsagent_definition_json(exportedAgent);
+        assert(concurrentDef);
+        free(concurrentDef);
+        nbOfExports++;
+    }
+    zpoller_destroy(&exportPoller);
+    assert(zsock_wait(exportWriter) == 0);
+    zactor_destroy(&exportWriter);
+    assert(nbOfExports > 0);
+    igsagent_destroy(&exportedAgent);
     igs_definition_set_path("/tmp/simple Demo Agent.json");
     igs_definition_save();
     igs_clear_definition();
@@ -1857,6 +1922,183 @@ int main(int argc, const char * argv[]) {
     igsagent_deactivate(secondAgent);
     assert(tester_secondAgentExited);
 
+    //handles resolve their IOP again after a definition reload
+    igsagent_t *handleAgent = igsagent_new("handleAgent", true);
+    igsagent_input_create(handleAgent, "handle_input", IGS_INTEGER_T, &myInt, sizeof(int));
+    igsagent_output_create(handleAgent, "handle_int", IGS_INTEGER_T, &myInt, sizeof(int));
+    assert(igsagent_output_handle(handleAgent, "handle_missing") == NULL);
+    igs_iop_handle_t *inputHandle = igsagent_input_handle(handleAgent, "handle_input");
+    assert(inputHandle);
+    assert(igs_output_set_int_h(inputHandle, 2) == IGS_FAILURE);
+    assert(igs_iop_int_h(inputHandle) == myInt);
+    igs_iop_handle_t *outputHandle = igsagent_output_handle(handleAgent, "handle_int");
+    assert(outputHandle);
+    assert(igs_output_set_int_h(outputHandle, 7) == IGS_SUCCESS);
+    assert(igs_iop_int_h(outputHandle) == 7);
+    assert(igsagent_output_int(handleAgent, "handle_int") == 7);
+    char *handleDef = igsagent_definition_json(handleAgent);
+    assert(handleDef);
+    igsagent_clear_definition(handleAgent);
+    assert(igs_output_set_int_h(outputHandle, 8) == IGS_FAILURE);
+    assert(igs_iop_int_h(outputHandle) == 0);
+    assert(igs_iop_int_h(inputHandle) == 0);
+    assert(igsagent_definition_load_str(handleAgent, handleDef) == IGS_SUCCESS);
+    free(handleDef);
+    assert(igs_output_set_int_h(outputHandle, 9) == IGS_SUCCESS);
+    assert(igs_iop_int_h(outputHandle) == 9);
+    assert(igsagent_output_int(handleAgent, "handle_int") == 9);
+    igsagent_input_set_int(handleAgent, "handle_input", 3);
+    assert(igs_iop_int_h(inputHandle) == 3);
+    igs_iop_handle_destroy(&inputHandle);
+    igs_iop_handle_destroy(&outputHandle);
+    assert(inputHandle == NULL && outputHandle == NULL);
+    igsagent_destroy(&handleAgent);
+
+    //outputs published to another agent of our process
+    igsagent_t *outputsSource = igsagent_new("outputsSource", true);
+    igsagent_output_create(outputsSource, "out_int", IGS_INTEGER_T, &myInt, sizeof(int));
+    igsagent_output_create(outputsSource, "out_string", IGS_STRING_T, myString, strlen(myString) + 1);
+    igsagent_output_create(outputsSource, "out_data", IGS_DATA_T, myData, 32);
+    igsagent_t *outputsSink = igsagent_new("outputsSink", true);
+    igsagent_input_create(outputsSink, "in_int", IGS_INTEGER_T, &myInt, sizeof(int));
+    igsagent_input_create(outputsSink, "in_string", IGS_STRING_T, myString, strlen(myString) + 1);
+    igsagent_input_create(outputsSink, "in_data", IGS_DATA_T, myData, 32);
+    igsagent_observe_input(outputsSink, "in_int", sinkIOPCallback, NULL);
+    igsagent_observe_input(outputsSink, "in_string", sinkIOPCallback, NULL);
+    igsagent_observe_input(outputsSink, "in_data", sinkIOPCallback, NULL);
+    igsagent_mapping_add(outputsSink, "in_int", "outputsSource", "out_int");
+    igsagent_mapping_add(outputsSink, "in_string", "outputsSource", "out_string");
+    igsagent_mapping_add(outputsSink, "in_data", "outputsSource", "out_data");
+
+    //outputs batches are published once, when committed
+    assert(igsagent_outputs_commit(outputsSource) == IGS_FAILURE);
+    assert(igsagent_outputs_begin(outputsSource) == IGS_SUCCESS);
+    assert(igsagent_outputs_begin(outputsSource) == IGS_FAILURE);
+    sinkPublications = 0;
+    igsagent_output_set_int(outputsSource, "out_int", 10);
+    igsagent_output_set_string(outputsSource, "out_string", "batched string");
+    assert(sinkPublications == 0);
+    assert(igsagent_input_int(outputsSink, "in_int") == myInt);
+    assert(igsagent_output_int(outputsSource, "out_int") == 10);
+    assert(igsagent_outputs_commit(outputsSource) == IGS_SUCCESS);
+    assert(sinkPublications == 2);
+    assert(igsagent_input_int(outputsSink, "in_int") == 10);
+    char *batchedString = igsagent_input_string(outputsSink, "in_string");
+    assert(streq(batchedString, "batched string"));
+    free(batchedString);
+    assert(igsagent_outputs_commit(outputsSource) == IGS_FAILURE);
+    igsagent_output_set_int(outputsSource, "out_int", 11);
+    assert(sinkPublications == 3 && sinkLastInt == 11);
+    assert(igsagent_outputs_begin(outputsSource) == IGS_SUCCESS);
+    assert(igsagent_outputs_commit(outputsSource) == IGS_SUCCESS);
+    assert(sinkPublications == 3);
+
+    //identical values are not published again in publish on change mode
+    igsagent_output_set_publish_on_change(outputsSource, "out_int", true);
+    igsagent_output_set_publish_on_change(outputsSource, "out_string", true);
+    igsagent_output_set_publish_on_change(outputsSource, "out_data", true);
+    assert(igsagent_output_publish_on_change(outputsSource, "out_int"));
+    assert(igsagent_suppressed_publications(outputsSource) == 0);
+    sinkPublications = 0;
+    igsagent_output_set_int(outputsSource, "out_int", 20);
+    igsagent_output_set_int(outputsSource, "out_int", 20);
+    assert(sinkPublications == 1);
+    assert(igsagent_output_suppressed_publications(outputsSource, "out_int") == 1);
+    igsagent_output_set_int(outputsSource, "out_int", 21);
+    assert(sinkPublications == 2 && sinkLastInt == 21);
+    igsagent_output_set_string(outputsSource, "out_string", "unchanged string");
+    igsagent_output_set_string(outputsSource, "out_string", "unchanged string");
+    assert(sinkPublications == 3);
+    assert(igsagent_output_suppressed_publications(outputsSource, "out_string") == 1);
+    igsagent_output_set_string(outputsSource, "out_string", "changed string");
+    assert(sinkPublications == 4);
+    char onChangeData[64] = {0};
+    igsagent_output_set_data(outputsSource, "out_data", onChangeData, 64);
+    igsagent_output_set_data(outputsSource, "out_data", onChangeData, 64);
+    assert(sinkPublications == 5);
+    assert(igsagent_output_suppressed_publications(outputsSource, "out_data") == 1);
+    onChangeData[63] = 1;
+    igsagent_output_set_data(outputsSource, "out_data", onChangeData, 64);
+    assert(sinkPublications == 6);
+    igsagent_output_set_data(outputsSource, "out_data", onChangeData, 32);
+    assert(sinkPublications == 7);
+    assert(igsagent_suppressed_publications(outputsSource) == 3);
+    igsagent_output_set_publish_on_change(outputsSource, "out_int", false);
+    igsagent_output_set_int(outputsSource, "out_int", 21);
+    assert(sinkPublications == 8);
+    igsagent_output_set_publish_on_change(outputsSource, "out_string", false);
+    igsagent_output_set_publish_on_change(outputsSource, "out_data", false);
+
+    //rate limits only apply once started, see autotests
+    assert(igsagent_output_set_max_rate(outputsSource, "missing", 10) == IGS_FAILURE);
+    assert(igsagent_output_set_max_rate(outputsSource, "out_int", 10) == IGS_SUCCESS);
+    assert(igsagent_output_max_rate(outputsSource, "out_int") - 10 < 0.000001);
+    sinkPublications = 0;
+    igsagent_output_set_int(outputsSource, "out_int", 30);
+    igsagent_output_set_int(outputsSource, "out_int", 31);
+    assert(sinkPublications == 2 && sinkLastInt == 31);
+    assert(igsagent_output_set_max_rate(outputsSource, "out_int", 0) == IGS_SUCCESS);
+    assert(igsagent_output_max_rate(outputsSource, "out_int") < 0.000001);
+
+    //borrowed values are not modified by later writes
+    char borrowedData[256];
+    memset(borrowedData, 'a', 256);
+    igsagent_output_set_data(outputsSource, "out_data", borrowedData, 256);
+    igsagent_output_set_string(outputsSource, "out_string", "first borrowed string");
+    const void *borrowedValue = NULL;
+    size_t borrowedSize = 0;
+    igs_value_t *dataToken = NULL;
+    assert(igsagent_output_data_borrow(outputsSource, "out_data", &borrowedValue, &borrowedSize, &dataToken) == IGS_SUCCESS);
+    assert(dataToken && borrowedValue && borrowedSize == 256);
+    const char *borrowedString = NULL;
+    igs_value_t *stringToken = NULL;
+    assert(igsagent_output_string_borrow(outputsSource, "out_string", &borrowedString, &stringToken) == IGS_SUCCESS);
+    assert(stringToken && streq(borrowedString, "first borrowed string"));
+    const void *borrowedInput = NULL;
+    size_t borrowedInputSize = 0;
+    igs_value_t *inputToken = NULL;
+    assert(igsagent_input_data_borrow(outputsSink, "in_data", &borrowedInput, &borrowedInputSize, &inputToken) == IGS_SUCCESS);
+    assert(inputToken && borrowedInputSize == 256);
+    memset(borrowedData, 'b', 256);
+    igsagent_output_set_data(outputsSource, "out_data", borrowedData, 256);
+    igsagent_output_set_string(outputsSource, "out_string", "second borrowed string");
+    for (size_t i = 0; i < 256; i++){
+        assert(((const char *)borrowedValue)[i] == 'a');
+        assert(((const char *)borrowedInput)[i] == 'a');
+    }
+    assert(streq(borrowedString, "first borrowed string"));
+    igs_value_release(&dataToken);
+    igs_value_release(&stringToken);
+    igs_value_release(&inputToken);
+    assert(dataToken == NULL && stringToken == NULL && inputToken == NULL);
+    igs_value_release(&inputToken);
+    void *rewrittenData = NULL;
+    size_t rewrittenSize = 0;
+    assert(igsagent_input_data(outputsSink, "in_data", &rewrittenData, &rewrittenSize) == IGS_SUCCESS);
+    assert(rewrittenSize == 256 && ((char *)rewrittenData)[0] == 'b');
+    free(rewrittenData);
+
+    //adopted buffers are released once, when replaced or with their output
+    unsigned char *firstOwned = (unsigned char *)malloc(128);
+    memset(firstOwned, 0, 128);
+    assert(igsagent_output_set_data_owned(outputsSource, "out_data", firstOwned, 128, ownedDataFree) == IGS_SUCCESS);
+    assert(ownedDataFrees[0] == 0);
+    unsigned char *secondOwned = (unsigned char *)malloc(128);
+    memset(secondOwned, 1, 128);
+    assert(igsagent_output_set_data_owned(outputsSource, "out_data", secondOwned, 128, ownedDataFree) == IGS_SUCCESS);
+    assert(ownedDataFrees[0] == 1 && ownedDataFrees[1] == 0);
+    assert(igsagent_input_data(outputsSink, "in_data", &rewrittenData, &rewrittenSize) == IGS_SUCCESS);
+    assert(rewrittenSize == 128 && ((unsigned char *)rewrittenData)[0] == 1);
+    free(rewrittenData);
+    unsigned char *rejectedOwned = (unsigned char *)malloc(128);
+    memset(rejectedOwned, 2, 128);
+    assert(igsagent_output_set_data_owned(outputsSource, "missing", rejectedOwned, 128, ownedDataFree) == IGS_FAILURE);
+    assert(ownedDataFrees[2] == 1);
+
+    igsagent_destroy(&outputsSink);
+    igsagent_destroy(&outputsSource);
+    assert(ownedDataFrees[0] == 1 && ownedDataFrees[1] == 1 && ownedDataFrees[2] == 1);
+
     //elections
     assert(igs_election_leave("my election") == IGS_FAILURE);
     assert(igs_election_join("my election") == IGS_SUCCESS);
@@ -1912,6 +2154,26 @@ int main(int argc, const char * argv[]) {
         
         igs_start_with_device(networkDevice, port);
         igs_channel_join("TEST_CHANNEL");
+
+        //writes to a rate-limited output are coalesced, the last one winning
+        igsagent_t *rateSource = igsagent_new("rateSource", true);
+        igsagent_output_create(rateSource, "rate_int", IGS_INTEGER_T, &myInt, sizeof(int));
+        igsagent_t *rateSink = igsagent_new("rateSink", true);
+        igsagent_input_create(rateSink, "rate_int", IGS_INTEGER_T, &myInt, sizeof(int));
+        igsagent_observe_input(rateSink, "rate_int", sinkIOPCallback, NULL);
+        igsagent_mapping_add(rateSink, "rate_int", "rateSource", "rate_int");
+        igsagent_output_set_max_rate(rateSource, "rate_int", 5);
+        sinkPublications = 0;
+        igsagent_output_set_int(rateSource, "rate_int", 41);
+        igsagent_output_set_int(rateSource, "rate_int", 42);
+        igsagent_output_set_int(rateSource, "rate_int", 43);
+        assert(sinkPublications == 1 && sinkLastInt == 41);
+        zclock_sleep(500);
+        assert(sinkPublications == 2 && sinkLastInt == 43);
+        igsagent_output_set_int(rateSource, "rate_int", 44);
+        assert(sinkPublications == 3 && sinkLastInt == 44);
+        igsagent_destroy(&rateSink);
+        igsagent_destroy(&rateSource);
         zloop_t *loop = zloop_new();
         zsock_t *pipe = igs_pipe_to_ingescape();
         zloop_reader(loop, pipe, ingescapeSentMessage, NULL);